@@ -34,6 +34,7 @@ else()
 endif()
 
 set(MARIADB_HEADER ${mariadb_SOURCE_DIR}/include CACHE INTERNAL "")
+set(MARIADB_BINARY_HEADER ${mariadb_BINARY_DIR}/include CACHE INTERNAL "") # generated mariadb_version.h
 
 set(CMAKE_FIND_LIBRARY_SUFFIXES ".a")
 find_library(MARIADB_LIB
@@ -0,0 +1,83 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+#ifndef SIMPLE_MARIADB_BATCH_H
+#define SIMPLE_MARIADB_BATCH_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <common/sql_utils.h>
+
+namespace simple_mariadb::batch {
+
+    using ::common::sql_utils::InsertType;
+
+    /**
+     * Pieces of an INSERT / REPLACE / INSERT IGNORE statement. Views point into the parsed query.
+     */
+    struct ParsedInsert {
+        InsertType type = InsertType::INSERT;
+        std::string_view table;   ///< Table as written, including backticks or schema prefix.
+        std::string_view columns; ///< Column list including the parentheses.
+        std::string_view values;  ///< One or more value tuples, from the first '(' to the last ')'.
+        std::string_view suffix;  ///< Trailing ON DUPLICATE KEY UPDATE clause, empty if none.
+    };
+
+    /**
+     * Splits a single INSERT / REPLACE / INSERT IGNORE ... VALUES statement into its parts.
+     * Quoted strings, quoted identifiers and escapes inside the values are skipped correctly.
+     * @return false when the statement has another shape (INSERT ... SELECT, SET syntax, several statements...).
+     */
+    bool parse_insert(std::string_view query, ParsedInsert &parsed);
+
+    /**
+     * Validates a statement for enqueue(): `INSERT [IGNORE] INTO` or `REPLACE INTO`, a [schema.]table, a column
+     * list and one or more VALUES tuples with one value per column, then an optional ';'. A value is a quoted
+     * string, a number, a word such as NULL or DEFAULT, or a function call over values. Anything else, another
+     * statement after the ';' or an ON DUPLICATE KEY UPDATE clause included, is rejected.
+     *
+     * Single pass and allocation free; it replaces the regular expressions of
+     * common::sql_utils::is_insert_or_replace_query_correct() and accepts no statement that function rejects, except
+     * that line breaks are blanks like spaces and tabs, as they are for the server.
+     */
+    bool is_insert_or_replace(std::string_view query);
+
+    /**
+     * Key identifying statements that can share one VALUES list: insert type, table, column list and suffix,
+     * ignoring whitespace and backticks in the identifiers.
+     */
+    std::string group_key(const ParsedInsert &parsed);
+
+    /**
+     * Rewrites queued statements into multi-row statements.
+     *
+     * Runs of consecutive compatible statements are merged into one `INSERT ... VALUES (...),(...),...`. A
+     * statement of another group, or one that cannot be parsed and is passed through untouched, ends the run, so
+     * the statements run in the order they were queued.
+     */
+    std::vector<std::string> rewrite_multi_row(const std::vector<std::string> &queries);
+
+    /**
+     * Same as above into result, replacing its content. The strings of result are reused, so a buffer recycled
+     * between batches stops allocating once it has grown to the size of the batches.
+     * @param merged if not null, set to the number of queued statements each statement of result stands for.
+     */
+    void rewrite_multi_row(const std::vector<std::string> &queries, std::vector<std::string> &result,
+                           std::vector<size_t> *merged = nullptr);
+
+    /**
+     * Joins statements into one `START TRANSACTION;...;COMMIT;` multi-statement, adding the missing terminators
+     * and skipping empty statements. The buffer is sized once before the statements are appended.
+     */
+    std::string wrap_transaction(const std::vector<std::string> &statements);
+
+    /**
+     * Same as above into sql, replacing its content and keeping its capacity.
+     */
+    void wrap_transaction(const std::vector<std::string> &statements, std::string &sql);
+
+}
+
+#endif //SIMPLE_MARIADB_BATCH_H
@@ -0,0 +1,150 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+#ifndef SIMPLE_MARIADB_CACHE_H
+#define SIMPLE_MARIADB_CACHE_H
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <variant>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace simple_mariadb::cache {
+
+    /**
+     * Canonical name of a table for invalidation: backticks and the schema prefix removed, lower case.
+     */
+    std::string table_key(std::string_view identifier);
+
+    /**
+     * Tables read by a SELECT, after FROM and JOIN, including the ones of subqueries.
+     */
+    std::vector<std::string> read_tables(std::string_view query);
+
+    /**
+     * Whether the result of query may be cached: a SELECT reading at least one table, none of them in
+     * information_schema, performance_schema or mysql. Without a table no write invalidates the entry, and the
+     * system schemas change without a write naming their tables.
+     */
+    bool is_cacheable(std::string_view query);
+
+    /**
+     * What a statement may change.
+     */
+    struct Written {
+        enum Scope {
+            NONE,   ///< Reads and session statements (SELECT, SHOW, SET, COMMIT...).
+            TABLES, ///< Only the listed tables.
+            ALL     ///< Unknown or unparsed statement, every entry has to go.
+        };
+
+        Scope scope = NONE;
+        std::vector<std::string> tables;
+    };
+
+    /**
+     * Tables changed by a write statement: INSERT, REPLACE, UPDATE, DELETE, TRUNCATE, LOAD DATA and the table DDL.
+     */
+    Written written_tables(std::string_view statement);
+
+    /**
+     * A cached select() or query_to_json() result.
+     */
+    typedef std::variant<nlohmann::json, std::vector<std::map<std::string, std::string>>> CachedResult;
+
+    struct CacheStats {
+        size_t size = 0;
+        size_t capacity = 0;
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t evictions = 0;     ///< Least recently used entries dropped to make room.
+        size_t expirations = 0;   ///< Entries found past their time to live.
+        size_t invalidations = 0; ///< Entries dropped because a write touched one of their tables.
+
+        [[nodiscard]] nlohmann::json to_json() const;
+    };
+
+    /**
+     * Size-bounded LRU cache of query results with a time to live per entry.
+     *
+     * Each entry remembers the tables its query reads; a write invalidates the entries of the tables it changes.
+     * A result computed while one of its tables was written is not stored, so a read racing with a write cannot
+     * put the old rows back. Thread safe.
+     */
+    class ResultCache {
+    public:
+        ResultCache(size_t capacity, std::chrono::milliseconds ttl);
+
+        ResultCache(const ResultCache &other) = delete;
+
+        ResultCache &operator=(const ResultCache &other) = delete;
+
+        /**
+         * @return the cached result of key, nullptr on a miss.
+         */
+        std::shared_ptr<const CachedResult> get(const std::string &key);
+
+        /**
+         * Point in time to take before running the query of a miss and to hand to put().
+         */
+        uint64_t now();
+
+        /**
+         * Stores the result of key read from tables, unless one of them was invalidated after started.
+         */
+        void put(const std::string &key, const std::vector<std::string> &tables, CachedResult value,
+                 uint64_t started);
+
+        /**
+         * Drops the entries reading the tables changed by statement.
+         */
+        void invalidate(std::string_view statement);
+
+        void invalidate_table(std::string_view table);
+
+        void clear();
+
+        CacheStats get_stats();
+
+    private:
+        struct Entry {
+            std::string key;
+            std::vector<std::string> tables;
+            std::shared_ptr<const CachedResult> value;
+            std::chrono::steady_clock::time_point expires;
+        };
+
+        typedef std::list<Entry>::iterator Iterator;
+
+        void m_erase(Iterator it);
+
+        void m_invalidate_table(const std::string &table);
+
+        void m_clear();
+
+        const size_t m_capacity;
+        const std::chrono::milliseconds m_ttl;
+
+        std::mutex m_mutex;
+        std::list<Entry> m_lru; ///< Most recently used first.
+        std::unordered_map<std::string, Iterator> m_index;
+        std::unordered_map<std::string, std::unordered_set<std::string>> m_by_table; ///< Table to the keys reading it.
+        uint64_t m_clock = 0; ///< Ticks on every invalidation.
+        uint64_t m_cleared_at = 0;
+        std::unordered_map<std::string, uint64_t> m_invalidated_at;
+        CacheStats m_stats;
+    };
+
+}
+
+#endif //SIMPLE_MARIADB_CACHE_H
@@ -6,11 +6,31 @@
 #define SIMPLE_MARIADB_CLIENT_H
 
 #include <mutex>
+#include <thread>
+#include <atomic>
+#include <algorithm>
 #include <simple_color/color.h>
 #include <simple_config/config.h>
 #include <simple_logger/logger.h>
 #include <simple_mariadb/config.h>
-#include <regex>
+#include <simple_mariadb/pool.h>
+#include <simple_mariadb/batch.h>
+#include <simple_mariadb/statement.h>
+#include <simple_mariadb/rows.h>
+#include <simple_mariadb/loader.h>
+#include <simple_mariadb/queue.h>
+#include <simple_mariadb/spill.h>
+#include <simple_mariadb/cursor.h>
+#include <simple_mariadb/decoder.h>
+#include <simple_mariadb/mapping.h>
+#include <simple_mariadb/columnar.h>
+#include <simple_mariadb/table.h>
+#include <simple_mariadb/executor.h>
+#include <simple_mariadb/engine.h>
+#include <simple_mariadb/cache.h>
+#include <simple_mariadb/metrics.h>
+#include <simple_mariadb/logging.h>
+#include <simple_mariadb/retry.h>
 #include <common/common.h>
 #include <common/sql_utils.h>
 
@@ -18,9 +38,108 @@ namespace simple_mariadb::client {
 
     typedef std::string Query;
     typedef ::common::ThreadQueueWithMaxSize<Query> Queue;
-    typedef ::common::Stats Stats;
 //    typedef ::common::ThreadQueue<Query> Queue;
 
+    /**
+     * Counters of a single writer thread and its write connection.
+     */
+    struct WriterStats {
+        size_t id = 0;
+        size_t executed = 0;   ///< Statements written successfully.
+        size_t failed = 0;     ///< Statements the server rejected.
+        size_t batches = 0;    ///< Multi-insert batches sent.
+        size_t reconnects = 0; ///< Reconnection attempts of the write connection.
+        bool connected = false;
+    };
+
+    /**
+     * Latencies in nanoseconds and write throughput, recorded lock-free on the hot paths.
+     */
+    struct OperationStats {
+        simple_mariadb::metrics::HistogramSnapshot insert;       ///< Single statements written one by one.
+        simple_mariadb::metrics::HistogramSnapshot insert_multi; ///< Batches written in one transaction.
+        simple_mariadb::metrics::HistogramSnapshot query;        ///< query() calls, retries included.
+        simple_mariadb::metrics::HistogramSnapshot acquire;      ///< Read pool checkouts.
+        simple_mariadb::metrics::HistogramSnapshot connect;      ///< Opening a connection, the first one and the reconnects.
+        simple_mariadb::metrics::HistogramSnapshot batch_rows;   ///< Statements or rows per written batch.
+        simple_mariadb::metrics::RateSnapshot rows;              ///< Written rows, counted like WriterStats::executed.
+
+        [[nodiscard]] nlohmann::json to_json() const;
+    };
+
+    /**
+     * Queue statistics extended with the per-writer counters.
+     */
+    struct Stats : public ::common::Stats {
+        std::vector<WriterStats> writers;
+        simple_mariadb::pool::PoolStats read_pool;
+        simple_mariadb::statement::StatementCacheStats statements; ///< Summed over the write connections and idle read connections.
+        WriterStats row_writer; ///< Writer of the typed rows from enqueue_row().
+        simple_mariadb::queue::QueueStats queue; ///< Backend, capacity and overflow counters of the write queue.
+        simple_mariadb::spill::SpillStats spill; ///< Spill log counters, zero when spilling is disabled.
+        WriterStats spill_writer; ///< Writer replaying the spill log.
+        simple_mariadb::retry::RetryStats retry; ///< Failed writes retried or given up on.
+        WriterStats retry_writer; ///< Writer running the retries.
+        simple_mariadb::executor::ExecutorStats async; ///< Executor of the async reads, zero until the first one.
+        simple_mariadb::engine::EngineStats engine; ///< Nonblocking engine counters, zero with the threads engine.
+        simple_mariadb::cache::CacheStats cache; ///< Query result cache counters, zero when it is disabled.
+        OperationStats operations;
+    };
+
+    class MariaDBManager;
+
+    /**
+     * Write handle of one producer thread, from MariaDBManager::make_producer(). Statements are checked like
+     * MariaDBManager::enqueue() checks them and staged in a buffer of the handle, which is handed to the writers in
+     * one go once it holds max_rows statements, once the oldest one waited for linger, or on flush(). The thread
+     * then touches the shared queue once per batch instead of once per statement.
+     *
+     * Not thread safe: each thread keeps its own handle. There is no timer: the linger time is only checked when a
+     * statement is staged, so an idle handle keeps its statements until the next enqueue() or flush(), and a thread
+     * that stops writing for a while must call flush() itself. The destructor flushes, a handle must be flushed or
+     * destroyed before MariaDBManager::stop() and must not outlive its manager. A moved-from handle refuses every
+     * statement.
+     */
+    class Producer {
+    public:
+        Producer(MariaDBManager &manager, size_t max_rows, std::chrono::milliseconds linger);
+
+        Producer(const Producer &other) = delete;
+
+        Producer &operator=(const Producer &other) = delete;
+
+        Producer(Producer &&other) noexcept;
+
+        Producer &operator=(Producer &&other) noexcept;
+
+        ~Producer();
+
+        /**
+         * @return false if the statement is refused, or if publishing the batch it completed failed; always false on
+         * a moved-from handle.
+         */
+        bool enqueue(const std::string &query, bool check_correctness = true);
+
+        bool enqueue(std::string &&query, bool check_correctness = true);
+
+        /**
+         * Hands the staged statements to the writers.
+         * @return false if the queue refused some of them.
+         */
+        bool flush();
+
+        [[nodiscard]] size_t staged() const { return m_buffer.size(); }
+
+    private:
+        bool m_stage(std::string &&query);
+
+        MariaDBManager *m_manager;
+        size_t m_max_rows;
+        std::chrono::milliseconds m_linger;
+        std::chrono::steady_clock::time_point m_first; ///< When the oldest staged statement was staged.
+        std::vector<std::string> m_buffer; ///< Kept between batches, it stops growing after the first one.
+    };
+
     class MariaDBManager {
     public:
         explicit MariaDBManager(simple_mariadb::config::MariaDBConfig &config);
@@ -35,14 +154,89 @@ namespace simple_mariadb::client {
 
         ~MariaDBManager();
 
+        /**
+         * Rows as column name to string value, NULL reads as an empty string. Streams the result, so only the
+         * returned rows are held in memory. Served from the query cache when query_cache_size is set.
+         */
         std::vector<std::map<std::string, std::string>> select(const std::string &query);
 
+        /**
+         * Rows of query into result, replacing its content: one shared header and every cell in a single arena,
+         * read as std::string_view by column index or name. Reusing result across calls reuses its arena.
+         * @return number of rows.
+         */
+        size_t select(const std::string &query, simple_mariadb::table::ResultTable &result);
+
+        /**
+         * Queues a write statement. With spill_dir set, statements go to the spill log on disk instead when the
+         * queue is full or the write connection is down; they are replayed in order once the database is back,
+         * also after a restart.
+         */
         bool enqueue(const std::string &query, bool check_correctness = true);
 
+        /**
+         * Same as above, the statement is moved through the queue to the writer without being copied.
+         */
+        bool enqueue(std::string &&query, bool check_correctness = true);
+
+        /**
+         * Same as above, the statement is checked on the view and copied once, into the queue, if it is accepted.
+         */
+        bool enqueue(std::string_view query, bool check_correctness = true);
+
+        bool enqueue(const char *query, bool check_correctness = true);
+
+        /**
+         * Opt-in batched hand-off for threads that write many statements, see Producer.
+         * @param max_rows staged statements that trigger a hand-off, capped to the queue size.
+         * @param linger longest time a staged statement waits for the batch to fill.
+         */
+        Producer make_producer(size_t max_rows = 256, std::chrono::milliseconds linger = std::chrono::milliseconds(10));
+
+        /**
+         * Buffers a typed row for table. Rows are grouped per table and column list and written with
+         * PreparedStatement::addBatch() / executeBatch(), which the connector sends with the bulk binary protocol
+         * when useBulkStmts is enabled. No SQL text is built or escaped per row, unless the batch fails: its rows
+         * then go to the retries as text statements, like any failed write, and are retried, spilled or dead
+         * lettered.
+         * @return false if the number of values does not match the columns or the row buffer is full.
+         */
+        template<typename... Args>
+        bool enqueue_row(const std::string &table, const std::vector<std::string> &columns, const Args &... values) {
+            return this->m_enqueue_row(table, columns, {simple_mariadb::rows::to_value(values)...});
+        }
+
+        /**
+         * Hands every buffered row to the row writer and waits until they are written.
+         */
+        void flush_rows();
+
+        size_t pending_rows();
+
+        /**
+         * Bulk loads the rows produced by source with `LOAD DATA LOCAL INFILE` on a dedicated connection, streamed
+         * in chunks of load_chunk_size bytes without a temporary file. Meant for backfills, it bypasses the queue.
+         * @throws std::runtime_error if the load fails, the error is logged and counted in the error counter.
+         */
+        simple_mariadb::loader::LoadStats load_data(const std::string &table, const std::vector<std::string> &columns,
+                                                    const simple_mariadb::loader::RowSource &source,
+                                                    simple_mariadb::loader::InsertType type = simple_mariadb::loader::InsertType::INSERT);
+
+        /**
+         * Bulk loads buffered rows, one value per column each. See load_data() with a row source.
+         */
+        simple_mariadb::loader::LoadStats load_data(const std::string &table, const std::vector<std::string> &columns,
+                                                    const std::vector<std::vector<simple_mariadb::rows::Value>> &rows,
+                                                    simple_mariadb::loader::InsertType type = simple_mariadb::loader::InsertType::INSERT);
+
         size_t queue_size();
 
         void stop(bool force = false);
 
+        /**
+         * Kept for compatibility, does nothing: the writer threads started by the constructor drain the queue until
+         * stop().
+         */
         void run();
 
         bool is_connected();
@@ -51,11 +245,144 @@ namespace simple_mariadb::client {
 
         void set_multi_insert(bool multi_insert);
 
+        void set_multi_row_insert(bool multi_row_insert);
+
         std::unique_ptr<sql::ResultSet> query(const std::string &query);
 
+        /**
+         * Served from the query cache when query_cache_size is set.
+         */
         json query_to_json(const std::string &query);
 
-        static json resultset_to_json(sql::ResultSet &res);
+        /**
+         * Drops every cached result, for tables written outside this manager.
+         */
+        void clear_query_cache();
+
+        /**
+         * query() on the async executor. Its threads are sized to the read pool, so many reads can be in flight
+         * without a thread per request; retries and their backoff happen there too.
+         */
+        std::future<std::unique_ptr<sql::ResultSet>> query_async(const std::string &query);
+
+        /**
+         * select() on the async executor, see query_async(). With the nonblocking engine the query runs on its
+         * event loop instead, served from the query cache like select(); a failure is then reported as
+         * sql::SQLException with the server error code.
+         */
+        std::future<std::vector<std::map<std::string, std::string>>> select_async(const std::string &query);
+
+        /**
+         * Runs sql on the nonblocking engine, reads and writes alike. The future receives the affected rows or
+         * the rows of a SELECT, and the error if the statement failed.
+         * @throws std::runtime_error if the engine is not "nonblocking".
+         */
+        std::future<simple_mariadb::engine::Result> execute_async(const std::string &sql);
+
+        /**
+         * `co_await co_query(query)` suspends the coroutine while query() runs on the async executor and resumes it
+         * there with the result set, or the exception query() threw.
+         */
+        simple_mariadb::executor::Awaitable<std::unique_ptr<sql::ResultSet>> co_query(const std::string &query);
+
+        /**
+         * `co_await co_select(query)`, see co_query().
+         */
+        simple_mariadb::executor::Awaitable<std::vector<std::map<std::string, std::string>>>
+        co_select(const std::string &query);
+
+        /**
+         * Runs query on a pooled connection and returns a forward-only cursor streaming its rows, fetch_size
+         * rows per round trip (0 uses MariaDBConfig::fetch_size).
+         * @throws sql::SQLException if the query keeps failing after the retries.
+         */
+        simple_mariadb::cursor::Cursor open_cursor(const std::string &query, size_t fetch_size = 0);
+
+        /**
+         * Streams the rows of query to visitor without materializing the result. The visitor reads the current row
+         * by index or name and returns false to stop early.
+         * @return number of rows visited.
+         * @throws sql::SQLException if the query or fetching the rows fails.
+         */
+        size_t for_each_row(const std::string &query, const simple_mariadb::cursor::RowVisitor &visitor,
+                            size_t fetch_size = 0);
+
+        /**
+         * Streams the rows of query decoded into T through simple_mariadb::mapping::Descriptor<T>. The visitor
+         * takes a T & and returns false to stop early.
+         * @return number of rows visited.
+         * @throws std::runtime_error if a field of T has no column in the result.
+         * @throws sql::SQLException if the query or fetching the rows fails.
+         */
+        template<typename T, typename Visitor>
+        size_t for_each_as(const std::string &query, Visitor &&visitor, size_t fetch_size = 0) {
+            auto cursor = this->open_cursor(query, fetch_size);
+            auto meta = cursor.meta();
+            if (meta == nullptr) {
+                return 0;
+            }
+            const simple_mariadb::mapping::RowMapper<T> mapper(*meta);
+            while (cursor.next()) {
+                T row{};
+                mapper.read(cursor.row(), row);
+                if (!visitor(row)) {
+                    break;
+                }
+            }
+            return cursor.rows();
+        }
+
+        /**
+         * Rows of query as one contiguous typed vector per column (int64, double, bool or string) with a null
+         * bitmap, for scans and aggregation on the client. The result is streamed, only the columns are held.
+         * @throws sql::SQLException if the query or fetching the rows fails.
+         */
+        simple_mariadb::columnar::ColumnarResult select_columnar(const std::string &query, size_t fetch_size = 0);
+
+        /**
+         * Rows of query decoded into T through simple_mariadb::mapping::Descriptor<T>.
+         * @throws std::runtime_error if a field of T has no column in the result.
+         * @throws sql::SQLException if the query or fetching the rows fails.
+         */
+        template<typename T>
+        std::vector<T> select_as(const std::string &query) {
+            std::vector<T> result;
+            this->for_each_as<T>(query, [&result](T &row) {
+                result.push_back(std::move(row));
+                return true;
+            });
+            return result;
+        }
+
+        /**
+         * Executes a write statement with `?` placeholders through the cached prepared statement of the write
+         * connection. Parameters are bound by type (bool, integers, floating point, strings, std::optional, nullptr).
+         * @return false if the statement failed, the error is logged and counted in the error counter.
+         */
+        template<typename... Args>
+        bool execute_prepared(const std::string &sql, const Args &... params) {
+            return this->m_execute_prepared(sql, [&params...](sql::PreparedStatement &stmt) {
+                simple_mariadb::statement::bind_all(stmt, params...);
+            });
+        }
+
+        /**
+         * Runs a read statement with `?` placeholders on a pooled connection and returns the rows as json.
+         * The result is decoded before the connection, and its cached statement, go back to the pool.
+         * @throws sql::SQLException if the query keeps failing after the retry.
+         */
+        template<typename... Args>
+        json query_prepared(const std::string &sql, const Args &... params) {
+            return this->m_query_prepared(sql, [&params...](sql::PreparedStatement &stmt) {
+                simple_mariadb::statement::bind_all(stmt, params...);
+            });
+        }
+
+        /**
+         * Decodes every row of res. A cell that cannot be read is null.
+         * @param error if not nullptr, receives why the first unreadable cell could not be read.
+         */
+        static json resultset_to_json(sql::ResultSet &res, std::string *error = nullptr);
 
         bool drop_table(const std::string &table_name);
 
@@ -75,44 +402,219 @@ namespace simple_mariadb::client {
 
         size_t get_error_counter();
 
+        /**
+         * Called on the retry writer thread with every write given up on: a permanent error, a transient one out of
+         * retry_max_attempts, or one still failing at stop(). With spilling enabled the transient ones go to the
+         * spill log instead and are not dead letters. The dead letters are logged and written to dead_letter_path
+         * first, if it is set.
+         */
+        void set_dead_letter_callback(simple_mariadb::retry::DeadLetterCallback callback);
+
         void clear_queue();
 
         Stats get_stats();
 
+        simple_mariadb::pool::PoolStats get_read_pool_stats();
+
+        /**
+         * Latency histograms and write throughput. Takes no lock, so it can be polled while the writers run.
+         */
+        OperationStats get_operation_stats() const;
+
 
     private:
+        friend class Producer;
+
+        typedef std::function<void(sql::PreparedStatement &)> Binder;
+
+        bool m_enqueue_row(const std::string &table, const std::vector<std::string> &columns,
+                           std::vector<simple_mariadb::rows::Value> &&values);
+
+        bool m_execute_prepared(const std::string &sql, const Binder &binder);
+
+        json m_query_prepared(const std::string &sql, const Binder &binder);
+
+        /**
+         * resultset_to_json() logging the cells that could not be read.
+         */
+        json m_resultset_to_json(sql::ResultSet &res);
+
+        /**
+         * A queue consumer: one thread with its own write connection.
+         */
+        struct Writer {
+            size_t id = 0;
+            std::thread thread;
+            std::shared_ptr<sql::Connection> conn;
+            std::mutex mutex;
+            std::atomic<size_t> executed = 0;
+            std::atomic<size_t> failed = 0;
+            std::atomic<size_t> batches = 0;
+            std::atomic<size_t> reconnects = 0;
+            std::atomic<bool> down = false; ///< Lost its connection, counted in m_writers_down.
+            std::atomic<bool> connected = false; ///< Published by the threads using conn, read by get_stats().
+            std::unique_ptr<simple_mariadb::statement::StatementCache> statements;
+            std::string carry; ///< Statement that did not fit in the previous batch, it opens the next one.
+            // Batch buffers recycled between batches, they keep their capacity so a steady load allocates nothing
+            std::vector<std::string> batch;     ///< Statements taken from the queue for the current batch.
+            std::vector<std::string> rewritten; ///< batch merged into multi-row statements.
+            std::vector<size_t> merged;         ///< Queued statements each statement of rewritten stands for.
+            std::string wire;                   ///< The multi-statement sent to the server.
+        };
+
         bool m_is_connected(std::shared_ptr<sql::Connection> &conn);
 
         sql::Driver *m_driver = sql::mariadb::get_driver_instance();
 
         void m_get_connection(std::shared_ptr<sql::Connection> &conn);
 
-        bool m_insert(const std::string &query);
+        /**
+         * Reconnects writer.conn and publishes whether it is open. The caller holds writer.mutex.
+         */
+        void m_reconnect(Writer &writer);
+
+        /**
+         * @param failure set to the error when the statement fails, if not null.
+         */
+        bool m_insert(Writer &writer, const std::string &query, simple_mariadb::retry::Failure *failure = nullptr);
 
-        bool m_insert_multi(const std::vector<std::string> &queries);
+        bool m_insert_multi(Writer &writer, const std::vector<std::string> &queries);
 
         std::string m_dequeue();
 
+        void m_run_writer(Writer &writer);
+
+        void m_run_engine_writer(Writer &writer);
+
+        void m_submit_batch(Writer &writer, std::vector<std::string> &queries);
+
+        void m_form_batch(Writer &writer, std::vector<std::string> &queries);
+
+        void m_write_batch(Writer &writer, const std::vector<std::string> &queries);
+
+        void m_load_max_allowed_packet(Writer &writer);
+
+        void m_run_row_writer();
+
+        /**
+         * Logs and returns false when the statement should not be queued, invalidates the cached reads otherwise.
+         */
+        bool m_accept(std::string_view query, bool check_correctness);
+
+        bool m_push(std::string &&query);
+
+        /**
+         * Queues the accepted statements of a Producer and clears queries, keeping its capacity.
+         * @return number of statements queued.
+         */
+        size_t m_publish(std::vector<std::string> &queries);
+
+        bool m_spill_query(const std::string &query);
+
+        void m_run_spill_writer();
+
+        /**
+         * Marks writer as down or up, keeping m_writers_down in step.
+         */
+        void m_set_down(Writer &writer, bool down);
+
+        size_t m_replay(Writer &writer, const std::vector<std::string> &queries);
+
+        void m_run_retry_writer();
+
+        /**
+         * Runs the retries of due, the ones failing again go back to the retrier. The ones that cannot reach the
+         * server, after a single reconnect, are moved into unreached.
+         */
+        void m_retry_due(Writer &writer, std::vector<simple_mariadb::retry::Pending> &due,
+                         std::vector<simple_mariadb::retry::Pending> &unreached, bool may_retry);
+
+        bool m_write_rows(Writer &writer, const simple_mariadb::rows::RowBatch &batch);
+
+        WriterStats m_writer_stats(Writer &writer);
+
+        size_t m_batch_max_bytes() const;
+
+        void m_start_writers();
+
         void m_run_checker();
 
         void m_join_threads();
 
+        simple_mariadb::executor::Executor &m_executor();
+
+        std::vector<std::map<std::string, std::string>> m_select(const std::string &query);
+
+        /**
+         * Result of query from the cache, or from load stored in the cache for the next calls. A query that is not
+         * cache::is_cacheable() always runs.
+         */
+        template<typename T, typename Load>
+        T m_cached(char kind, const std::string &query, const Load &load) {
+            if (!simple_mariadb::cache::is_cacheable(query)) {
+                return load();
+            }
+            std::string key(1, kind);
+            key += query;
+            if (auto hit = m_cache->get(key)) {
+                return std::get<T>(*hit);
+            }
+            const auto started = m_cache->now();
+            T result = load();
+            m_cache->put(key, simple_mariadb::cache::read_tables(query), result, started);
+            return result;
+        }
+
+        /**
+         * Drops the cached results reading the tables statement writes.
+         */
+        void m_invalidate(std::string_view statement);
+
+        void m_invalidate_table(const std::string &table);
+
         std::shared_ptr<sql::Connection> m_conn_write;
-        std::shared_ptr<sql::Connection> m_conn_read;
-        std::mutex m_read_mutex;
+        std::unique_ptr<simple_mariadb::pool::ConnectionPool> m_read_pool;
         std::mutex m_write_mutex;
+        std::mutex m_async_mutex;
+        std::unique_ptr<simple_mariadb::executor::Executor> m_async; ///< Started by the first async read, guarded by m_async_mutex.
 
         simple_mariadb::config::MariaDBConfig &m_config;
         std::shared_ptr<simple_logger::Logger> m_logger = m_config.logger;
-        Queue m_queries = Queue(m_config.queue_size, m_config.queue_timeout);
-//        Queue m_queries = Queue(m_config.queue_size);
-//        Queue m_queries = Queue( m_config.queue_timeout);
+        simple_mariadb::logging::Log m_log{m_logger, m_config.get_loglevel()}; ///< Lazy messages of the hot paths.
+        simple_mariadb::logging::QueryLog m_query_log{m_log, m_config.log_queries_per_second,
+                                                      m_config.log_query_max_length}; ///< Failures of queued statements.
+        simple_mariadb::queue::QueryQueue m_queries{m_config};
         std::atomic<bool> m_queue_thread_is_running;
         std::atomic<bool> m_checker_thread_is_running;
         std::atomic<size_t> m_error_counter = 0; ///< Counter for errors encountered.
-        std::thread m_queue_thread;
+        std::vector<std::unique_ptr<Writer>> m_writers;
+        std::unique_ptr<Writer> m_row_writer;
+        std::unique_ptr<Writer> m_spill_writer;
+        std::unique_ptr<simple_mariadb::spill::SegmentLog> m_spill;
+        std::unique_ptr<simple_mariadb::retry::Retrier> m_retry; ///< Every failed write goes through it.
+        std::unique_ptr<Writer> m_retry_writer;
+        std::atomic<bool> m_retry_running = false;
+        std::atomic<bool> m_retry_forced = false; ///< Set by stop(true): pending retries are given up on without a last attempt.
+        std::unique_ptr<simple_mariadb::engine::Engine> m_engine; ///< Set with the nonblocking engine, it drains the queue in place of the writers.
+        std::unique_ptr<simple_mariadb::cache::ResultCache> m_cache; ///< Set when query_cache_size is not 0.
+
+        struct Metrics {
+            simple_mariadb::metrics::Histogram insert;
+            simple_mariadb::metrics::Histogram insert_multi;
+            simple_mariadb::metrics::Histogram query;
+            simple_mariadb::metrics::Histogram connect;
+            simple_mariadb::metrics::Histogram batch_rows;
+            simple_mariadb::metrics::RateMeter rows;
+        };
+        Metrics m_metrics;
+        std::atomic<size_t> m_writers_down = 0; ///< Writers without a connection, new statements are spilled while any is.
+        std::atomic<bool> m_rows_running = false;
+        simple_mariadb::rows::RowBuffer m_rows{m_config.batch_max_rows, m_config.queue_size};
         std::thread m_checker_thread;
-        bool m_multi_insert = m_config.multi_insert;
+        std::atomic<bool> m_multi_insert = m_config.multi_insert;
+        std::atomic<bool> m_multi_row_insert = m_config.multi_row_insert;
+        std::atomic<size_t> m_max_allowed_packet = 0; ///< Read from the server when a writer connects.
+        simple_mariadb::statement::StatementCache m_write_statements{m_config.statement_cache_size}; ///< Guarded by m_write_mutex.
 
     };
 
@@ -0,0 +1,153 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+#ifndef SIMPLE_MARIADB_COLUMNAR_H
+#define SIMPLE_MARIADB_COLUMNAR_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <conncpp.hpp>
+#include <simple_mariadb/decoder.h>
+
+namespace simple_mariadb::columnar {
+
+    /**
+     * Storage of a column. Integers are widened to int64 and floating point values to double.
+     */
+    enum class ColumnType {
+        INT64,
+        DOUBLE,
+        BOOLEAN,
+        STRING ///< Also dates, times and every other type, as their string representation.
+    };
+
+    ColumnType column_type_for(simple_mariadb::decoder::Decoder decoder);
+
+    /**
+     * One column of a result in contiguous buffers, laid out like an Arrow array.
+     *
+     * Values of the column type are stored back to back: int64s(), doubles(), bools() (one byte per value) or,
+     * for strings, data() with offsets() where value i spans [offsets[i], offsets[i + 1]). validity() is a
+     * bitmap with bit i, least significant first, set when value i is not NULL. A NULL keeps a zero or empty
+     * slot so indexes stay aligned across columns.
+     */
+    class Column {
+    public:
+        Column(std::string name, ColumnType type, sql::DataType sql_type = sql::VARCHAR);
+
+        [[nodiscard]] const std::string &name() const { return m_name; }
+
+        [[nodiscard]] ColumnType type() const { return m_type; }
+
+        [[nodiscard]] sql::DataType sql_type() const { return m_sql_type; }
+
+        [[nodiscard]] size_t size() const { return m_size; }
+
+        [[nodiscard]] size_t null_count() const { return m_null_count; }
+
+        [[nodiscard]] bool is_null(size_t row) const {
+            return (m_validity[row / 8] & (1u << (row % 8))) == 0;
+        }
+
+        [[nodiscard]] const std::vector<uint8_t> &validity() const { return m_validity; }
+
+        [[nodiscard]] const std::vector<int64_t> &int64s() const { return m_int64s; }
+
+        [[nodiscard]] const std::vector<double> &doubles() const { return m_doubles; }
+
+        [[nodiscard]] const std::vector<uint8_t> &bools() const { return m_bools; }
+
+        [[nodiscard]] const std::vector<uint64_t> &offsets() const { return m_offsets; }
+
+        [[nodiscard]] const std::string &data() const { return m_data; }
+
+        /**
+         * Value of a STRING column, empty for NULL. Valid while the column is not appended to.
+         */
+        [[nodiscard]] std::string_view string(size_t row) const {
+            return {m_data.data() + m_offsets[row], m_offsets[row + 1] - m_offsets[row]};
+        }
+
+        // The append matching type() has to be used, append_null() fits every type
+        void append_int64(int64_t value);
+
+        void append_double(double value);
+
+        void append_bool(bool value);
+
+        void append_string(std::string_view value);
+
+        void append_null();
+
+        void reserve(size_t rows);
+
+    private:
+        void m_push_validity(bool valid);
+
+        std::string m_name;
+        ColumnType m_type;
+        sql::DataType m_sql_type;
+        size_t m_size = 0;
+        size_t m_null_count = 0;
+        std::vector<uint8_t> m_validity;
+        std::vector<int64_t> m_int64s;
+        std::vector<double> m_doubles;
+        std::vector<uint8_t> m_bools;
+        std::vector<uint64_t> m_offsets{0};
+        std::string m_data;
+    };
+
+    /**
+     * A result as one Column per result column, all of rows() values.
+     */
+    class ColumnarResult {
+    public:
+        ColumnarResult() = default;
+
+        explicit ColumnarResult(std::vector<Column> columns);
+
+        [[nodiscard]] size_t rows() const { return m_columns.empty() ? 0 : m_columns.front().size(); }
+
+        [[nodiscard]] const std::vector<Column> &columns() const { return m_columns; }
+
+        [[nodiscard]] const Column &column(size_t index) const { return m_columns.at(index); }
+
+        /**
+         * @throws std::out_of_range if the result has no column called name.
+         */
+        [[nodiscard]] const Column &column(std::string_view name) const;
+
+    private:
+        std::vector<Column> m_columns;
+    };
+
+    /**
+     * Appends the rows of a result to typed columns. The getter of every column comes from the
+     * simple_mariadb::decoder::ColumnPlan of the result, so the types match resultset_to_json().
+     */
+    class ColumnarBuilder {
+    public:
+        explicit ColumnarBuilder(sql::ResultSetMetaData &meta);
+
+        /**
+         * Appends the current row of res.
+         * @throws sql::SQLException if a value cannot be read.
+         */
+        void append_row(sql::ResultSet &res);
+
+        /**
+         * Hands over the columns built so far and leaves the builder empty.
+         */
+        ColumnarResult finish();
+
+    private:
+        simple_mariadb::decoder::ColumnPlan m_plan;
+        std::vector<Column> m_columns;
+    };
+
+}
+
+#endif //SIMPLE_MARIADB_COLUMNAR_H
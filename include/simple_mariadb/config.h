@@ -16,6 +16,10 @@ using json = nlohmann::json;
 
 namespace simple_mariadb::config {
 
+    /**
+     * Formats value as a SQL literal. Strings are quoted but not escaped, prefer the typed binding of
+     * MariaDBManager::execute_prepared() / query_prepared() for values that are not trusted.
+     */
     template<typename T>
     std::string to_sql_literal(T const &value) {
         static std::string const true_literal = "TRUE";
@@ -52,12 +56,52 @@ namespace simple_mariadb::config {
         [[nodiscard]] std::string to_string() const override;
 
         bool multi_insert = common::get_env_variable_bool("MARIADB_MULTI_INSERT", false);
+        bool multi_row_insert = common::get_env_variable_bool("MARIADB_MULTI_ROW_INSERT", false); ///< Merge queued rows into multi-row INSERTs.
+        size_t batch_max_rows = common::get_env_variable_int("MARIADB_BATCH_MAX_ROWS", 1000); ///< Statements per multi-insert batch.
+        size_t batch_max_bytes = common::get_env_variable_int("MARIADB_BATCH_MAX_BYTES", 0); ///< 0 follows the server max_allowed_packet.
+        size_t batch_linger_ms = common::get_env_variable_int("MARIADB_BATCH_LINGER_MS", 0); ///< Wait to fill a batch, 0 sends what is queued.
         int checker_time = common::get_env_variable_int("CHECKER_TIME", 30);
         size_t queue_size = common::get_env_variable_int("MARIADB_QUEUE_SIZE", 30000);
         size_t queue_timeout = common::get_env_variable_int("MARIADB_QUEUE_TIMEOUT", 2);
+        std::string queue_backend = common::get_env_variable_string("MARIADB_QUEUE_BACKEND", "mutex"); ///< "mutex" or "ring" (lock free).
+        std::string queue_overflow_policy = common::get_env_variable_string("MARIADB_QUEUE_OVERFLOW_POLICY", "block"); ///< Ring only: block, drop_newest, drop_oldest or reject.
+        size_t writer_threads = common::get_env_variable_int("MARIADB_WRITER_THREADS", 1); ///< Writer connections draining the queue.
+        size_t read_pool_size = common::get_env_variable_int("MARIADB_READ_POOL_SIZE", 1); ///< Read connections opened up front.
+        size_t read_pool_max = common::get_env_variable_int("MARIADB_READ_POOL_MAX", 0); ///< Growth limit of the read pool, 0 disables growth.
+        size_t read_pool_timeout_ms = common::get_env_variable_int("MARIADB_READ_POOL_TIMEOUT_MS", 5000); ///< Checkout timeout.
+        size_t statement_cache_size = common::get_env_variable_int("MARIADB_STATEMENT_CACHE_SIZE", 64); ///< Prepared statements per connection.
+        size_t fetch_size = common::get_env_variable_int("MARIADB_FETCH_SIZE", 1000); ///< Rows fetched per round trip by cursors.
+        size_t load_chunk_size = common::get_env_variable_int("MARIADB_LOAD_CHUNK_SIZE", 1048576); ///< Bytes formatted per LOAD DATA chunk.
+        std::string spill_dir = common::get_env_variable_string("MARIADB_SPILL_DIR", ""); ///< Directory of the spill log, empty disables spilling.
+        size_t spill_segment_size = common::get_env_variable_int("MARIADB_SPILL_SEGMENT_SIZE", 67108864); ///< Bytes per spill segment file.
+        size_t spill_max_bytes = common::get_env_variable_int("MARIADB_SPILL_MAX_BYTES", 1073741824); ///< Spill segments kept on disk, 0 for no limit.
+        size_t spill_replay_rate = common::get_env_variable_int("MARIADB_SPILL_REPLAY_RATE", 5000); ///< Spilled statements replayed per second, 0 for no limit.
+        size_t async_threads = common::get_env_variable_int("MARIADB_ASYNC_THREADS", 0); ///< Threads running the async reads, 0 matches the read pool.
+        std::string engine = common::get_env_variable_string("MARIADB_ENGINE", "threads"); ///< "threads" or "nonblocking" (one event loop over engine_connections).
+        size_t engine_connections = common::get_env_variable_int("MARIADB_ENGINE_CONNECTIONS", 16); ///< Connections of the nonblocking engine.
+        size_t query_cache_size = common::get_env_variable_int("MARIADB_QUERY_CACHE_SIZE", 0); ///< Cached select() and query_to_json() results, 0 disables the cache.
+        size_t query_cache_ttl_ms = common::get_env_variable_int("MARIADB_QUERY_CACHE_TTL_MS", 5000); ///< Time to live of a cached result.
+        size_t log_queries_per_second = common::get_env_variable_int("MARIADB_LOG_QUERIES_PER_SECOND", 10); ///< Write path log lines carrying statement text, 0 for no limit.
+        size_t log_query_max_length = common::get_env_variable_int("MARIADB_LOG_QUERY_MAX_LENGTH", 1024); ///< Bytes of statement text per log line, 0 keeps it whole.
+        size_t retry_max_attempts = common::get_env_variable_int("MARIADB_RETRY_MAX_ATTEMPTS", 5); ///< Attempts reaching the server of a write failing with a transient error, 1 never retries.
+        size_t retry_backoff_ms = common::get_env_variable_int("MARIADB_RETRY_BACKOFF_MS", 100); ///< Delay before the first retry, doubled at every attempt.
+        size_t retry_max_backoff_ms = common::get_env_variable_int("MARIADB_RETRY_MAX_BACKOFF_MS", 30000); ///< Cap of the retry delay.
+        std::string dead_letter_path = common::get_env_variable_string("MARIADB_DEAD_LETTER_PATH", ""); ///< File the writes given up on are appended to as JSON lines, empty for none.
 
         std::map<sql::SQLString, sql::SQLString> get_options();
 
+        [[nodiscard]] const std::string &get_hostname() const { return m_hostname; }
+
+        [[nodiscard]] int get_port() const { return m_port; }
+
+        [[nodiscard]] const std::string &get_user() const { return m_user; }
+
+        [[nodiscard]] const std::string &get_password() const { return m_password; }
+
+        [[nodiscard]] const std::string &get_database() const { return m_database; }
+
+        [[nodiscard]] const std::string &get_loglevel() const { return loglevel; }
+
     protected:
         std::string m_database = common::get_env_variable_string("MARIADB_DATABASE", "");
         std::string m_password = common::get_env_variable_string("MARIADB_PASSWORD", "");
@@ -68,6 +112,7 @@ namespace simple_mariadb::config {
         std::string m_tcpkeepalive = common::get_env_variable_string("MARIADB_TCPKEEPALIVE", "true");
         std::string m_connecttimeout = common::get_env_variable_string("MARIADB_CONNECTTIMEOUT", "30");
         std::string m_sockettimeout = common::get_env_variable_string("MARIADB_SOCKETTIMEOUT", "10000");
+        std::string m_usebulkstmts = common::get_env_variable_string("MARIADB_USEBULKSTMTS", "true");
 
     public:
         std::string uri = "jdbc:mariadb://" + m_hostname + ":" + std::to_string(m_port) + "/" + m_database;
@@ -0,0 +1,83 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+#ifndef SIMPLE_MARIADB_CURSOR_H
+#define SIMPLE_MARIADB_CURSOR_H
+
+#include <functional>
+#include <memory>
+#include <conncpp.hpp>
+#include <simple_mariadb/pool.h>
+
+namespace simple_mariadb::cursor {
+
+    /**
+     * Visits the current row of a result set. Return false to stop early.
+     */
+    typedef std::function<bool(sql::ResultSet &row)> RowVisitor;
+
+    /**
+     * Forward-only cursor over a streamed result set.
+     *
+     * The rows are fetched from the server fetch_size at a time, so memory stays flat whatever the size of the
+     * result. The cursor holds its pooled connection until it reaches the end or is closed: keep it short lived
+     * and do not run other queries from inside the iteration with a pool of one connection.
+     */
+    class Cursor {
+    public:
+        Cursor() = default;
+
+        Cursor(simple_mariadb::pool::ConnectionPool::Lease lease, std::unique_ptr<sql::Statement> statement,
+               std::unique_ptr<sql::ResultSet> result);
+
+        Cursor(const Cursor &other) = delete;
+
+        Cursor &operator=(const Cursor &other) = delete;
+
+        Cursor(Cursor &&other) noexcept = default;
+
+        Cursor &operator=(Cursor &&other) noexcept;
+
+        ~Cursor();
+
+        /**
+         * Moves to the next row. At the end the cursor closes and its connection goes back to the pool.
+         * @return false when there are no more rows.
+         * @throws sql::SQLException if fetching fails, the connection is then dropped from the pool.
+         */
+        bool next();
+
+        /**
+         * The current row, valid after next() returned true.
+         */
+        sql::ResultSet &row() { return *m_result; }
+
+        /**
+         * Column names and types of the result, nullptr once the cursor is closed.
+         */
+        sql::ResultSetMetaData *meta() { return m_result ? m_result->getMetaData() : nullptr; }
+
+        /**
+         * Rows returned by next() so far.
+         */
+        [[nodiscard]] size_t rows() const { return m_rows; }
+
+        [[nodiscard]] bool is_open() const { return m_result != nullptr; }
+
+        /**
+         * Discards the remaining rows and returns the connection to the pool.
+         */
+        void close();
+
+    private:
+        // Declaration order is destruction order reversed: result, statement, then the connection
+        simple_mariadb::pool::ConnectionPool::Lease m_lease;
+        std::unique_ptr<sql::Statement> m_statement;
+        std::unique_ptr<sql::ResultSet> m_result;
+        size_t m_rows = 0;
+    };
+
+}
+
+#endif //SIMPLE_MARIADB_CURSOR_H
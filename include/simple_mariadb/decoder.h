@@ -0,0 +1,114 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+#ifndef SIMPLE_MARIADB_DECODER_H
+#define SIMPLE_MARIADB_DECODER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <conncpp.hpp>
+#include <nlohmann/json.hpp>
+
+namespace simple_mariadb::decoder {
+
+    /**
+     * Getter used to read a column.
+     */
+    enum class Decoder {
+        INT,     ///< getInt()
+        INT64,   ///< getInt64()
+        BOOLEAN, ///< getBoolean()
+        DOUBLE,  ///< getDouble()
+        FLOAT,   ///< getFloat()
+        STRING   ///< getString(), also dates, times and every other type
+    };
+
+    Decoder decoder_for(sql::DataType type);
+
+    struct Column {
+        int32_t index = 0; ///< 1-based position in the result.
+        std::string name;
+        sql::DataType type = sql::VARCHAR;
+        Decoder decoder = Decoder::STRING;
+    };
+
+    /**
+     * Per-result decoding plan: the columns with their names and decoders, read once from the metadata.
+     *
+     * Rows are then decoded by index in a tight loop, with no metadata call or name lookup per cell. NULL is
+     * detected with wasNull() after reading the value, as the connector only sets it on a read. The row is read
+     * through the getters of sql::ResultSet only, so any type with the same getters can be decoded, which is how
+     * the benchmarks measure the decoding without a server.
+     */
+    class ColumnPlan {
+    public:
+        explicit ColumnPlan(sql::ResultSetMetaData &meta);
+
+        explicit ColumnPlan(std::vector<Column> columns);
+
+        [[nodiscard]] const std::vector<Column> &columns() const { return m_columns; }
+
+        /**
+         * Decodes the current row of res into a json object keyed by column name.
+         * @param error if not nullptr and still empty, receives the first cell that could not be read.
+         */
+        template<typename Result>
+        [[nodiscard]] nlohmann::json decode_row(Result &res, std::string *error = nullptr) const {
+            nlohmann::json row = nlohmann::json::object();
+            for (const auto &column: m_columns) {
+                row[column.name] = this->decode(res, column, error);
+            }
+            return row;
+        }
+
+        /**
+         * Decodes one cell of the current row, json null for SQL NULL and for a cell that could not be read.
+         * @param error if not nullptr and still empty, receives why the cell could not be read.
+         */
+        template<typename Result>
+        [[nodiscard]] nlohmann::json decode(Result &res, const Column &column, std::string *error = nullptr) const {
+            nlohmann::json value;
+            try {
+                switch (column.decoder) {
+                    case Decoder::INT:
+                        value = res.getInt(column.index);
+                        break;
+                    case Decoder::INT64:
+                        value = res.getInt64(column.index);
+                        break;
+                    case Decoder::BOOLEAN:
+                        value = res.getBoolean(column.index);
+                        break;
+                    case Decoder::DOUBLE:
+                        value = res.getDouble(column.index);
+                        break;
+                    case Decoder::FLOAT:
+                        value = res.getFloat(column.index);
+                        break;
+                    case Decoder::STRING:
+                    default:
+                        value = std::string(res.getString(column.index));
+                        break;
+                }
+            } catch (sql::SQLException &e) {
+                if (error != nullptr && error->empty()) {
+                    *error = "column " + column.name + " type " + std::to_string(column.type) + ": " + e.what();
+                }
+                return nullptr;
+            }
+            // wasNull() reports on the last value read, so it is checked after the read
+            if (res.wasNull()) {
+                return nullptr;
+            }
+            return value;
+        }
+
+    private:
+        std::vector<Column> m_columns;
+    };
+
+}
+
+#endif //SIMPLE_MARIADB_DECODER_H
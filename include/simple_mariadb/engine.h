@@ -0,0 +1,204 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+#ifndef SIMPLE_MARIADB_ENGINE_H
+#define SIMPLE_MARIADB_ENGINE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include <simple_mariadb/config.h>
+#include <simple_mariadb/table.h>
+
+typedef struct st_mysql MYSQL;
+typedef struct st_mysql_res MYSQL_RES;
+
+namespace simple_mariadb::engine {
+
+    /**
+     * Outcome of one statement. Errors are reported here, not thrown.
+     */
+    struct Result {
+        bool ok = true;
+        unsigned int error_code = 0;
+        std::string error;
+        uint64_t affected_rows = 0;
+        uint64_t insert_id = 0;
+        simple_mariadb::table::ResultTable rows; ///< Rows of a SELECT, empty for other statements.
+    };
+
+    /**
+     * Receives the result of a statement on the event loop thread; it must be short and must not block.
+     */
+    typedef std::function<void(Result &&result)> Callback;
+
+    struct EngineStats {
+        size_t connections = 0;
+        size_t connected = 0;
+        size_t busy = 0;       ///< Connections with a statement in flight.
+        size_t queued = 0;     ///< Statements waiting for a connection.
+        size_t submitted = 0;
+        size_t completed = 0;  ///< Statements that succeeded.
+        size_t failed = 0;
+        size_t retried = 0;    ///< Statements sent again after their connection was found gone.
+        size_t reconnects = 0;
+
+        [[nodiscard]] nlohmann::json to_json() const;
+    };
+
+    /**
+     * Applies the options of config that Connector/C knows (connectTimeout, socketTimeout, useTls, tlsKey,
+     * tlsCert, tlsCA) to mysql, before it connects.
+     */
+    void set_options(MYSQL *mysql, simple_mariadb::config::MariaDBConfig &config);
+
+    /**
+     * Applies the socket options of config (tcpKeepAlive) to the socket of mysql, once it is connected.
+     */
+    void set_socket_options(MYSQL *mysql, simple_mariadb::config::MariaDBConfig &config);
+
+    /**
+     * Runs statements on a set of connections driven by one event loop thread.
+     *
+     * The connections use the non-blocking API of MariaDB Connector/C (mysql_real_query_start / _cont and
+     * mysql_store_result_start / _cont); the loop waits on their sockets with epoll and resumes whichever is ready, so
+     * every connection has a statement in flight with a single thread. Statements submitted with the same key run on
+     * the same connection, in submission order; statements without a key are taken by the first idle connection and may
+     * complete out of order. Only the first result of a multi-result statement is reported, the others are read and
+     * dropped so the connection stays in sync. A connection that is gone is reopened without blocking the loop, and a
+     * statement that could not be sent on it (CR_SERVER_GONE_ERROR) is sent again once.
+     */
+    class Engine {
+    public:
+        /**
+         * Opens the connections, blocking until they are up.
+         * @throws std::runtime_error if a connection cannot be opened.
+         */
+        Engine(simple_mariadb::config::MariaDBConfig &config, size_t connections);
+
+        Engine(const Engine &other) = delete;
+
+        Engine &operator=(const Engine &other) = delete;
+
+        ~Engine();
+
+        /**
+         * Queues sql, callback receives its result on the event loop thread. Statements with the same key run in
+         * the order they were submitted.
+         * @throws std::runtime_error once the engine is stopped.
+         */
+        void submit(std::string sql, Callback callback, std::optional<size_t> key = std::nullopt);
+
+        /**
+         * Queues sql, the future receives its result.
+         * @throws std::runtime_error once the engine is stopped.
+         */
+        std::future<Result> submit(std::string sql);
+
+        /**
+         * Blocks until fewer than limit statements are queued or in flight.
+         */
+        void wait_below(size_t limit);
+
+        /**
+         * Blocks until every submitted statement completed.
+         */
+        void wait_idle();
+
+        /**
+         * Completes the submitted statements, then stops the loop and closes the connections.
+         */
+        void stop();
+
+        [[nodiscard]] size_t connections() const { return m_connections.size(); }
+
+        EngineStats get_stats();
+
+    private:
+        enum class State {
+            IDLE,
+            CONNECTING,
+            QUERY,
+            STORE,
+            NEXT, ///< Moving to the next result of a multi-result statement.
+            DRAIN ///< Reading a result that is not reported.
+        };
+
+        struct Task {
+            std::string sql;
+            Callback callback;
+            bool retried = false;
+        };
+
+        struct Connection {
+            size_t id = 0;
+            MYSQL *mysql = nullptr;
+            MYSQL *connected = nullptr; ///< Set by mysql_real_connect_*, nullptr until the connection is up.
+            State state = State::IDLE;
+            bool up = false;
+            int fd = -1;             ///< Socket registered in epoll, -1 when not registered.
+            int query_result = 0;
+            int next_result = 0;
+            MYSQL_RES *result = nullptr;
+            std::optional<Result> first; ///< Result reported once the other results are drained.
+            std::optional<std::chrono::steady_clock::time_point> deadline;
+            std::optional<Task> task;
+            std::deque<Task> tasks; ///< Statements routed to this connection by key, guarded by m_mutex.
+        };
+
+        MYSQL *m_open();
+
+        void m_loop();
+
+        void m_dispatch();
+
+        void m_start(Connection &conn);
+
+        void m_resume(Connection &conn, int events);
+
+        void m_advance(Connection &conn, int status);
+
+        void m_wait(Connection &conn, int status);
+
+        void m_unregister(Connection &conn);
+
+        bool m_complete(Connection &conn);
+
+        void m_finish(Connection &conn);
+
+        void m_fail(Connection &conn);
+
+        void m_reconnect(Connection &conn);
+
+        void m_set_up(Connection &conn, bool up);
+
+        void m_done(Connection &conn, Result &&result);
+
+        simple_mariadb::config::MariaDBConfig &m_config;
+        std::vector<std::unique_ptr<Connection>> m_connections;
+        int m_epoll = -1;
+        int m_wakeup = -1; ///< eventfd written by submit() and stop() to wake the loop.
+
+        std::mutex m_mutex;
+        std::condition_variable m_cv; ///< Signalled when a statement completes.
+        std::deque<Task> m_tasks;
+        size_t m_pending = 0; ///< Statements queued or in flight.
+        bool m_stopping = false;
+        EngineStats m_stats;  ///< Counters, guarded by m_mutex.
+        std::thread m_thread;
+    };
+
+}
+
+#endif //SIMPLE_MARIADB_ENGINE_H
@@ -0,0 +1,133 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+#ifndef SIMPLE_MARIADB_EXECUTOR_H
+#define SIMPLE_MARIADB_EXECUTOR_H
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace simple_mariadb::executor {
+
+    struct ExecutorStats {
+        size_t threads = 0;
+        size_t queued = 0;    ///< Tasks waiting for a thread.
+        size_t running = 0;
+        size_t submitted = 0;
+        size_t completed = 0;
+
+        [[nodiscard]] nlohmann::json to_json() const;
+    };
+
+    /**
+     * Fixed set of threads running tasks in submission order.
+     *
+     * Sized to the read pool, so every thread can hold a connection and the tasks never wait on each other for
+     * one. Stopping runs the tasks already queued, then joins the threads.
+     */
+    class Executor {
+    public:
+        explicit Executor(size_t threads);
+
+        Executor(const Executor &other) = delete;
+
+        Executor &operator=(const Executor &other) = delete;
+
+        ~Executor();
+
+        /**
+         * Queues job, which must not throw.
+         * @throws std::runtime_error once the executor is stopped.
+         */
+        void post(std::function<void()> job);
+
+        /**
+         * Queues task and returns a future of its result; an exception thrown by task is rethrown by get().
+         * @throws std::runtime_error once the executor is stopped.
+         */
+        template<typename F>
+        std::future<std::invoke_result_t<F>> submit(F &&task) {
+            using R = std::invoke_result_t<F>;
+            auto job = std::make_shared<std::packaged_task<R()>>(std::forward<F>(task));
+            auto future = job->get_future();
+            this->post([job]() { (*job)(); });
+            return future;
+        }
+
+        /**
+         * Runs the queued tasks and joins the threads. Not to be called from a task.
+         */
+        void stop();
+
+        [[nodiscard]] size_t threads() const { return m_threads.size(); }
+
+        ExecutorStats get_stats();
+
+    private:
+        void m_run();
+
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+        std::deque<std::function<void()>> m_jobs;
+        bool m_stopped = false;
+        std::vector<std::thread> m_threads;
+        size_t m_running = 0;
+        size_t m_submitted = 0;
+        size_t m_completed = 0;
+    };
+
+    /**
+     * co_await-able task run on an executor.
+     *
+     * The awaiting coroutine is suspended, task runs on an executor thread and the coroutine resumes there with
+     * its result, or with the exception it threw. Works with any coroutine type; the awaitable has to be awaited
+     * once, and the executor must outlive the suspension.
+     */
+    template<typename R>
+    class Awaitable {
+    public:
+        Awaitable(Executor &executor, std::function<R()> task) : m_executor(&executor), m_task(std::move(task)) {}
+
+        [[nodiscard]] bool await_ready() const noexcept { return false; }
+
+        void await_suspend(std::coroutine_handle<> handle) {
+            m_executor->post([this, handle]() {
+                try {
+                    m_result.emplace(m_task());
+                } catch (...) {
+                    m_error = std::current_exception();
+                }
+                handle.resume();
+            });
+        }
+
+        R await_resume() {
+            if (m_error) {
+                std::rethrow_exception(m_error);
+            }
+            return std::move(*m_result);
+        }
+
+    private:
+        Executor *m_executor;
+        std::function<R()> m_task;
+        std::optional<R> m_result;
+        std::exception_ptr m_error;
+    };
+
+}
+
+#endif //SIMPLE_MARIADB_EXECUTOR_H
@@ -0,0 +1,77 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+#ifndef SIMPLE_MARIADB_LOADER_H
+#define SIMPLE_MARIADB_LOADER_H
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include <common/sql_utils.h>
+#include <simple_logger/logger.h>
+#include <simple_mariadb/config.h>
+#include <simple_mariadb/rows.h>
+
+namespace simple_mariadb::loader {
+
+    using ::common::sql_utils::InsertType;
+
+    /**
+     * Counters of one bulk load. Throughput is measured over the whole statement, server side work included.
+     */
+    struct LoadStats {
+        size_t rows = 0;        ///< Rows produced by the source and sent.
+        size_t affected = 0;    ///< Rows the server reports as inserted or replaced.
+        size_t bytes = 0;       ///< Bytes of row data sent.
+        size_t chunks = 0;      ///< Chunks handed to the client library.
+        size_t elapsed_us = 0;
+
+        [[nodiscard]] double rows_per_second() const;
+
+        [[nodiscard]] double bytes_per_second() const;
+
+        [[nodiscard]] nlohmann::json to_json() const;
+    };
+
+    /**
+     * Fills row with the values of the next row, one per column.
+     * @return false when there are no more rows.
+     */
+    typedef std::function<bool(std::vector<simple_mariadb::rows::Value> &row)> RowSource;
+
+    /**
+     * Appends value as a LOAD DATA field: NULL as `\N`, booleans as 1 / 0, and tab, newline, carriage return,
+     * NUL and backslash escaped with a backslash.
+     */
+    void append_field(std::string &out, const simple_mariadb::rows::Value &value);
+
+    /**
+     * Appends the row as tab separated fields terminated by a newline.
+     */
+    void append_row(std::string &out, const std::vector<simple_mariadb::rows::Value> &row);
+
+    /**
+     * `LOAD DATA LOCAL INFILE ... INTO TABLE `table` (`c1`,`c2`)` reading the default tab separated format.
+     * REPLACE and IGNORE select the handling of duplicate keys.
+     */
+    std::string load_statement(const std::string &table, const std::vector<std::string> &columns,
+                               InsertType type = InsertType::INSERT);
+
+    /**
+     * Streams rows from source into `LOAD DATA LOCAL INFILE` on a dedicated connection.
+     *
+     * Rows are formatted into a chunk of about chunk_size bytes and handed to the client library from its local
+     * infile callback, so no temporary file is written and memory stays bounded by the chunk. The server must
+     * allow local_infile. The connection takes the timeouts, TLS and keepalive options of config like the others.
+     * @throws std::runtime_error if the connection cannot be opened, the source throws or the server rejects the load.
+     */
+    LoadStats load_data(simple_mariadb::config::MariaDBConfig &config, const std::string &table,
+                        const std::vector<std::string> &columns, const RowSource &source,
+                        size_t chunk_size, InsertType type = InsertType::INSERT);
+
+}
+
+#endif //SIMPLE_MARIADB_LOADER_H
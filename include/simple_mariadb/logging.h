@@ -0,0 +1,149 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+#ifndef SIMPLE_MARIADB_LOGGING_H
+#define SIMPLE_MARIADB_LOGGING_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <simple_logger/logger.h>
+
+/**
+ * Highest simple_logger::LogLevel compiled in: 7 (DEBUG) keeps every site, 6 removes the DEBUG sites of the hot
+ * paths, 3 keeps only errors and worse. Set by the SIMPLE_MARIADB_LOG_LEVEL cache variable of CMake.
+ */
+#ifndef SIMPLE_MARIADB_LOG_LEVEL
+#define SIMPLE_MARIADB_LOG_LEVEL 7
+#endif
+
+namespace simple_mariadb::logging {
+
+    using simple_logger::LogLevel;
+
+    /**
+     * Parses the loglevel names of simple_config: "emergency", "alert", "critical", "error", "warning", "notice",
+     * "info" / "informational" and "debug", in any case.
+     * @return false for an unknown name, level is left untouched.
+     */
+    bool parse_level(std::string_view name, LogLevel &level);
+
+    constexpr bool compiled_in(LogLevel level) {
+        return static_cast<int>(level) <= SIMPLE_MARIADB_LOG_LEVEL;
+    }
+
+    /**
+     * Front of simple_logger::Logger for the hot paths. The message is built by a callable, only when its level is
+     * compiled in and enabled: a disabled site costs one comparison and a compiled out one costs nothing.
+     */
+    class Log {
+    public:
+        /**
+         * @param level_name the loglevel of the configuration, an unknown name enables every level and leaves the
+         * filtering to the logger.
+         */
+        Log(std::shared_ptr<simple_logger::Logger> logger, std::string_view level_name);
+
+        [[nodiscard]] bool enabled(LogLevel level) const {
+            return static_cast<int>(level) <= static_cast<int>(m_level);
+        }
+
+        template<LogLevel level, typename Format>
+        void send(Format &&format) const {
+            if constexpr (compiled_in(level)) {
+                if (this->enabled(level)) {
+                    m_logger->template send<level>(std::forward<Format>(format)());
+                }
+            }
+        }
+
+    private:
+        std::shared_ptr<simple_logger::Logger> m_logger;
+        LogLevel m_level = LogLevel::DEBUG;
+    };
+
+    /**
+     * Lets through at most per_second events per second, lock free. The events held back are counted and handed to
+     * the next one let through.
+     */
+    class RateLimiter {
+    public:
+        /**
+         * @param per_second 0 lets every event through.
+         */
+        explicit RateLimiter(size_t per_second);
+
+        RateLimiter(const RateLimiter &other) = delete;
+
+        RateLimiter &operator=(const RateLimiter &other) = delete;
+
+        /**
+         * @param suppressed set to the events held back since the last one let through.
+         * @return true if the event may go on.
+         */
+        bool allow(size_t &suppressed);
+
+        [[nodiscard]] size_t get_suppressed() const { return m_suppressed.load(std::memory_order_relaxed); }
+
+    private:
+        static constexpr unsigned COUNT_BITS = 24;
+        static constexpr uint64_t COUNT_MASK = (uint64_t(1) << COUNT_BITS) - 1;
+
+        const size_t m_per_second;
+        const std::chrono::steady_clock::time_point m_start;
+        std::atomic<uint64_t> m_window = 0; ///< Second since m_start above COUNT_BITS, events let through in it below.
+        std::atomic<size_t> m_pending = 0;    ///< Held back since the last event let through.
+        std::atomic<size_t> m_suppressed = 0; ///< Held back in total.
+    };
+
+    /**
+     * query cut to max_length bytes for a log line, with the number of bytes left out.
+     * @param max_length 0 keeps the whole query.
+     */
+    std::string abbreviate(std::string_view query, size_t max_length);
+
+    /**
+     * Log lines carrying statement text, on the write path where a failing server can reject thousands of
+     * statements a second: at most per_second lines a second with the statement cut to max_length bytes. The first
+     * line let through after a quiet period tells how many were held back.
+     */
+    class QueryLog {
+    public:
+        QueryLog(const Log &log, size_t per_second, size_t max_length);
+
+        /**
+         * @param format builds the message from the abbreviated query, it is only called for lines that are written.
+         */
+        template<LogLevel level, typename Format>
+        void send(std::string_view query, Format &&format) {
+            if constexpr (compiled_in(level)) {
+                size_t suppressed = 0;
+                if (!m_log.enabled(level) || !m_limiter.allow(suppressed)) {
+                    return;
+                }
+                m_log.send<level>([&]() {
+                    std::string message = std::forward<Format>(format)(abbreviate(query, m_max_length));
+                    if (suppressed > 0) {
+                        message += " (" + std::to_string(suppressed) + " similar messages suppressed)";
+                    }
+                    return message;
+                });
+            }
+        }
+
+        [[nodiscard]] size_t get_suppressed() const { return m_limiter.get_suppressed(); }
+
+    private:
+        Log m_log;
+        RateLimiter m_limiter;
+        const size_t m_max_length;
+    };
+
+}
+
+#endif //SIMPLE_MARIADB_LOGGING_H
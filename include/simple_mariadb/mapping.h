@@ -0,0 +1,133 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+#ifndef SIMPLE_MARIADB_MAPPING_H
+#define SIMPLE_MARIADB_MAPPING_H
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <conncpp.hpp>
+#include <simple_mariadb/statement.h>
+
+namespace simple_mariadb::mapping {
+
+    /**
+     * A column of the result and the member of T it is decoded into.
+     */
+    template<typename T, typename M>
+    struct Field {
+        const char *column;
+        M T::*member;
+    };
+
+    template<typename T, typename M>
+    constexpr Field<T, M> field(const char *column, M T::*member) {
+        return {column, member};
+    }
+
+    /**
+     * Field descriptor of a mapped type, specialized once per type:
+     *
+     *     template<>
+     *     struct simple_mariadb::mapping::Descriptor<Trade> {
+     *         static constexpr auto fields = std::make_tuple(field("id", &Trade::id), field("price", &Trade::price));
+     *     };
+     */
+    template<typename T>
+    struct Descriptor;
+
+    /**
+     * 1-based index of column in the result, matched on the label (the `AS` alias) first and then on the name,
+     * case insensitive like the server.
+     * @throws std::runtime_error if the result has no such column.
+     */
+    int32_t column_index(sql::ResultSetMetaData &meta, std::string_view column);
+
+    /**
+     * Reads the column at the 1-based index of the current row into out with the getter matching its C++ type.
+     * SQL NULL leaves std::nullopt in an std::optional member; other members get what the getter returns for
+     * NULL, zero or an empty string.
+     */
+    template<typename M>
+    void read(sql::ResultSet &res, int32_t index, M &out) {
+        if constexpr (simple_mariadb::statement::is_optional<M>::value) {
+            typename M::value_type value{};
+            read(res, index, value);
+            // wasNull() reports on the last value read, so it is checked after the read
+            if (res.wasNull()) {
+                out.reset();
+            } else {
+                out = std::move(value);
+            }
+        } else if constexpr (std::is_same_v<M, bool>) {
+            out = res.getBoolean(index);
+        } else if constexpr (std::is_integral_v<M> && std::is_signed_v<M> && sizeof(M) <= sizeof(int32_t)) {
+            out = static_cast<M>(res.getInt(index));
+        } else if constexpr (std::is_integral_v<M> && std::is_signed_v<M>) {
+            out = static_cast<M>(res.getInt64(index));
+        } else if constexpr (std::is_integral_v<M> && sizeof(M) <= sizeof(uint32_t)) {
+            out = static_cast<M>(res.getUInt(index));
+        } else if constexpr (std::is_integral_v<M>) {
+            out = static_cast<M>(res.getUInt64(index));
+        } else if constexpr (std::is_same_v<M, float>) {
+            out = res.getFloat(index);
+        } else if constexpr (std::is_floating_point_v<M>) {
+            out = static_cast<M>(res.getDouble(index));
+        } else if constexpr (std::is_same_v<M, std::string>) {
+            out = std::string(res.getString(index));
+        } else {
+            static_assert(sizeof(M) == 0, "simple_mariadb::mapping::read: unsupported member type");
+        }
+    }
+
+    /**
+     * Decodes rows straight into T through Descriptor<T>::fields.
+     *
+     * The column of every field is looked up once per result; each row is then read by index into the members,
+     * with no json or string map in between.
+     */
+    template<typename T>
+    class RowMapper {
+    public:
+        static constexpr size_t field_count = std::tuple_size_v<std::decay_t<decltype(Descriptor<T>::fields)>>;
+
+        /**
+         * @throws std::runtime_error if a field has no column in the result.
+         */
+        explicit RowMapper(sql::ResultSetMetaData &meta) {
+            m_resolve(meta, std::make_index_sequence<field_count>{});
+        }
+
+        /**
+         * Decodes the current row of res into row.
+         */
+        void read(sql::ResultSet &res, T &row) const {
+            m_read(res, row, std::make_index_sequence<field_count>{});
+        }
+
+        [[nodiscard]] const std::array<int32_t, field_count> &indexes() const { return m_indexes; }
+
+    private:
+        template<size_t... I>
+        void m_resolve(sql::ResultSetMetaData &meta, std::index_sequence<I...>) {
+            ((m_indexes[I] = column_index(meta, std::get<I>(Descriptor<T>::fields).column)), ...);
+        }
+
+        template<size_t... I>
+        void m_read(sql::ResultSet &res, T &row, std::index_sequence<I...>) const {
+            (mapping::read(res, m_indexes[I], row.*(std::get<I>(Descriptor<T>::fields).member)), ...);
+        }
+
+        std::array<int32_t, field_count> m_indexes{};
+    };
+
+}
+
+#endif //SIMPLE_MARIADB_MAPPING_H
@@ -0,0 +1,115 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+#ifndef SIMPLE_MARIADB_METRICS_H
+#define SIMPLE_MARIADB_METRICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+
+namespace simple_mariadb::metrics {
+
+    struct HistogramSnapshot {
+        uint64_t count = 0;
+        uint64_t min = 0;
+        uint64_t max = 0;
+        double mean = 0;
+        uint64_t p50 = 0;
+        uint64_t p90 = 0;
+        uint64_t p99 = 0;
+        uint64_t p999 = 0;
+
+        [[nodiscard]] nlohmann::json to_json() const;
+    };
+
+    /**
+     * Lock-free log-linear histogram in the style of HdrHistogram.
+     *
+     * Values below 64 have their own bucket; above, each power of two is split in 64 buckets, so a percentile is
+     * reported within 1/64 (1.6%) of the recorded value. Values from 2^44 up, over four hours in nanoseconds, go to
+     * the last bucket. record() is a few relaxed atomic increments, snapshot() reads the buckets without stopping
+     * the writers, so a snapshot taken while values are recorded may miss the newest ones.
+     */
+    class Histogram {
+    public:
+        static constexpr unsigned SUB_BUCKET_BITS = 6;
+        static constexpr uint64_t SUB_BUCKETS = uint64_t(1) << SUB_BUCKET_BITS;
+        static constexpr unsigned MAX_VALUE_BITS = 44;
+        static constexpr size_t BUCKETS = (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+        Histogram() = default;
+
+        Histogram(const Histogram &other) = delete;
+
+        Histogram &operator=(const Histogram &other) = delete;
+
+        void record(uint64_t value);
+
+        /**
+         * Records the nanoseconds elapsed since start.
+         */
+        void record_since(std::chrono::steady_clock::time_point start);
+
+        [[nodiscard]] HistogramSnapshot snapshot() const;
+
+        void reset();
+
+        static size_t bucket_index(uint64_t value);
+
+        /**
+         * Highest value that falls in bucket index.
+         */
+        static uint64_t bucket_upper(size_t index);
+
+    private:
+        std::array<std::atomic<uint64_t>, BUCKETS> m_buckets{};
+        std::atomic<uint64_t> m_sum = 0;
+        std::atomic<uint64_t> m_min = UINT64_MAX;
+        std::atomic<uint64_t> m_max = 0;
+    };
+
+    struct RateSnapshot {
+        uint64_t total = 0;
+        double per_second = 0; ///< Over the last complete seconds, up to RateMeter::WINDOW_SECONDS.
+        double average = 0;    ///< Since the meter started.
+
+        [[nodiscard]] nlohmann::json to_json() const;
+    };
+
+    /**
+     * Lock-free event counter with the rate of the last seconds. Each one second slot packs its second and its
+     * count in one atomic word, so add() is a single compare-and-swap.
+     */
+    class RateMeter {
+    public:
+        static constexpr size_t WINDOW_SECONDS = 5;
+
+        RateMeter();
+
+        RateMeter(const RateMeter &other) = delete;
+
+        RateMeter &operator=(const RateMeter &other) = delete;
+
+        void add(uint64_t events);
+
+        [[nodiscard]] RateSnapshot snapshot() const;
+
+    private:
+        static constexpr unsigned COUNT_BITS = 40;
+        static constexpr uint64_t COUNT_MASK = (uint64_t(1) << COUNT_BITS) - 1;
+        static constexpr size_t SLOTS = WINDOW_SECONDS + 2; ///< The window, the current second and one being reused.
+
+        [[nodiscard]] uint64_t m_second() const;
+
+        const std::chrono::steady_clock::time_point m_start;
+        std::atomic<uint64_t> m_total = 0;
+        std::array<std::atomic<uint64_t>, SLOTS> m_slots{};
+    };
+
+}
+
+#endif //SIMPLE_MARIADB_METRICS_H
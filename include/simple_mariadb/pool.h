@@ -0,0 +1,171 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+#ifndef SIMPLE_MARIADB_POOL_H
+#define SIMPLE_MARIADB_POOL_H
+
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <chrono>
+#include <atomic>
+#include <memory>
+#include <conncpp.hpp>
+#include <nlohmann/json.hpp>
+#include <simple_mariadb/statement.h>
+#include <simple_mariadb/metrics.h>
+
+namespace simple_mariadb::pool {
+
+    typedef std::shared_ptr<sql::Connection> Connection;
+    typedef std::shared_ptr<simple_mariadb::statement::StatementCache> StatementCachePtr;
+
+    /**
+     * Snapshot of the pool counters. Wait times are in microseconds.
+     */
+    struct PoolStats {
+        size_t size = 0;          ///< Connections currently owned by the pool (idle + in use).
+        size_t idle = 0;
+        size_t in_use = 0;
+        size_t peak_in_use = 0;
+        size_t min_size = 0;
+        size_t max_size = 0;
+        size_t acquired = 0;      ///< Successful checkouts.
+        size_t waited = 0;        ///< Checkouts that had to wait for a connection.
+        size_t timeouts = 0;      ///< Checkouts that gave up after the timeout.
+        size_t created = 0;       ///< Connections opened over the pool lifetime.
+        size_t discarded = 0;     ///< Broken connections dropped from the pool.
+        size_t total_wait_us = 0;
+        size_t max_wait_us = 0;
+        simple_mariadb::metrics::HistogramSnapshot acquire_ns; ///< Time to check out a connection, waits and opens included.
+
+        [[nodiscard]] double utilization() const;
+
+        [[nodiscard]] double average_wait_us() const;
+
+        [[nodiscard]] nlohmann::json to_json() const;
+    };
+
+    /**
+     * Bounded pool of connections with checkout/return semantics.
+     *
+     * The pool opens min_size connections up front and grows on demand up to max_size. When every
+     * connection is checked out, acquire() waits up to the checkout timeout and then throws.
+     */
+    class ConnectionPool {
+    public:
+        typedef std::function<Connection()> Factory;
+        typedef std::function<bool(Connection &)> Validator;
+
+        /**
+         * RAII handle of a checked out connection, the connection goes back to the pool on destruction.
+         */
+        class Lease {
+        public:
+            Lease() = default;
+
+            Lease(ConnectionPool *pool, Connection conn, StatementCachePtr statements);
+
+            Lease(const Lease &other) = delete;
+
+            Lease &operator=(const Lease &other) = delete;
+
+            Lease(Lease &&other) noexcept;
+
+            Lease &operator=(Lease &&other) noexcept;
+
+            ~Lease();
+
+            sql::Connection *operator->() const { return m_conn.get(); }
+
+            Connection &get() { return m_conn; }
+
+            /**
+             * Prepared statements cached for this connection.
+             */
+            simple_mariadb::statement::StatementCache &statements() { return *m_statements; }
+
+            explicit operator bool() const { return m_conn != nullptr; }
+
+            /**
+             * Marks the connection as broken, it is closed instead of being returned to the pool.
+             */
+            void invalidate() { m_valid = false; }
+
+            void release();
+
+        private:
+            ConnectionPool *m_pool = nullptr;
+            Connection m_conn;
+            StatementCachePtr m_statements;
+            bool m_valid = true;
+        };
+
+        ConnectionPool(size_t min_size, size_t max_size, std::chrono::milliseconds timeout,
+                       Factory factory, Validator validator, size_t statement_cache_size = 0);
+
+        ConnectionPool(const ConnectionPool &other) = delete;
+
+        ConnectionPool &operator=(const ConnectionPool &other) = delete;
+
+        /**
+         * Checks out a connection, waiting up to the checkout timeout.
+         * @throws std::runtime_error if no connection is available in time or a new one cannot be opened.
+         */
+        Lease acquire();
+
+        /**
+         * Validates the idle connections one at a time, the others stay available. A broken one is dropped at
+         * once and replaced afterwards if the pool fell under min_size.
+         */
+        void check_idle();
+
+        /**
+         * True when the pool holds at least one usable connection.
+         */
+        bool is_connected();
+
+        PoolStats get_stats();
+
+        /**
+         * Checkout latency, without taking the pool lock.
+         */
+        simple_mariadb::metrics::HistogramSnapshot get_acquire_latency() const;
+
+        /**
+         * Statement cache counters summed over the idle connections.
+         */
+        simple_mariadb::statement::StatementCacheStats get_statement_stats();
+
+    private:
+        struct Slot {
+            Connection conn;
+            StatementCachePtr statements;
+        };
+
+        void m_release(Slot slot, bool valid);
+
+        Slot m_create();
+
+        const size_t m_min_size;
+        const size_t m_max_size;
+        const std::chrono::milliseconds m_timeout;
+        Factory m_factory;
+        Validator m_validator;
+        const size_t m_statement_cache_size;
+
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+        std::deque<Slot> m_idle;
+        size_t m_size = 0;
+        size_t m_in_use = 0;
+        size_t m_checking = 0; ///< Idle connections taken out by check_idle() to validate them.
+        PoolStats m_stats;
+        simple_mariadb::metrics::Histogram m_acquire; ///< Recorded outside m_mutex.
+    };
+
+}
+
+#endif //SIMPLE_MARIADB_POOL_H
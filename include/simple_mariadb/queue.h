@@ -0,0 +1,419 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+#ifndef SIMPLE_MARIADB_QUEUE_H
+#define SIMPLE_MARIADB_QUEUE_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <common/common.h>
+#include <nlohmann/json.hpp>
+
+namespace simple_mariadb::config {
+    class MariaDBConfig;
+}
+
+namespace simple_mariadb::queue {
+
+    enum class Backend {
+        MUTEX, ///< common::ThreadQueueWithMaxSize, a deque behind a mutex.
+        RING   ///< RingQueue, lock free.
+    };
+
+    /**
+     * What RingQueue::enqueue() does when the queue is full.
+     */
+    enum class OverflowPolicy {
+        BLOCK,       ///< Wait for room up to the deadline, then fail.
+        DROP_NEWEST, ///< Discard the new element and report success.
+        DROP_OLDEST, ///< Discard the oldest queued element to make room.
+        REJECT       ///< Fail right away.
+    };
+
+    /**
+     * Parses "mutex" / "ring".
+     * @return false for an unknown name, backend is left untouched.
+     */
+    bool parse_backend(const std::string &name, Backend &backend);
+
+    /**
+     * Parses "block" / "drop_newest" / "drop_oldest" / "reject".
+     * @return false for an unknown name, policy is left untouched.
+     */
+    bool parse_overflow_policy(const std::string &name, OverflowPolicy &policy);
+
+    std::string to_string(Backend backend);
+
+    std::string to_string(OverflowPolicy policy);
+
+    /**
+     * Counters of the write queue. Overflow counters are kept per policy, only the configured policy moves.
+     */
+    struct QueueStats {
+        std::string backend;
+        std::string policy;
+        size_t capacity = 0;
+        size_t size = 0;
+        size_t enqueued = 0;       ///< Elements accepted into the queue.
+        size_t dequeued = 0;       ///< Elements taken out by consumers.
+        size_t blocked = 0;        ///< BLOCK: enqueues that found the queue full and waited.
+        size_t block_timeouts = 0; ///< BLOCK: waits that hit the deadline, the element was not queued.
+        size_t dropped_newest = 0; ///< DROP_NEWEST: new elements discarded.
+        size_t dropped_oldest = 0; ///< DROP_OLDEST: queued elements discarded to make room.
+        size_t rejected = 0;       ///< REJECT, and failed enqueues of the mutex backend.
+
+        [[nodiscard]] nlohmann::json to_json() const;
+    };
+
+    /**
+     * Spins briefly, then yields, then sleeps up to 1 ms per round until the deadline.
+     */
+    class Backoff {
+    public:
+        explicit Backoff(std::chrono::milliseconds timeout) :
+                m_deadline(std::chrono::steady_clock::now() + timeout) {}
+
+        bool wait() {
+            if (std::chrono::steady_clock::now() >= m_deadline) {
+                return false;
+            }
+            if (m_round < 16) {
+                std::this_thread::yield();
+            } else {
+                std::this_thread::sleep_for(m_sleep);
+                m_sleep = std::min(m_sleep * 2, std::chrono::microseconds(1000));
+            }
+            m_round++;
+            return true;
+        }
+
+    private:
+        std::chrono::steady_clock::time_point m_deadline;
+        size_t m_round = 0;
+        std::chrono::microseconds m_sleep{50};
+    };
+
+    /**
+     * Bounded lock free queue for many producers, based on Dmitry Vyukov's bounded MPMC ring.
+     *
+     * Every cell carries a sequence number telling producers and consumers whose turn it is, so a push or pop is a
+     * single CAS on the tail or head index and producers never share a lock. Consumers may be several as well,
+     * which lets more than one writer thread drain the queue and lets DROP_OLDEST pop from the producer side.
+     * Waiting (BLOCK on a full queue, dequeue_blocking() on an empty one) backs off from yielding to short sleeps.
+     */
+    template<typename T>
+    class RingQueue {
+    public:
+        /**
+         * @param capacity elements the ring holds, at least 2: with a single cell a full and an empty ring have
+         * the same sequence numbers.
+         * @param timeout deadline of BLOCK enqueues and of dequeue_blocking().
+         */
+        RingQueue(size_t capacity, OverflowPolicy policy, std::chrono::milliseconds timeout) :
+                m_capacity(std::max<size_t>(capacity, 2)),
+                m_policy(policy),
+                m_timeout(timeout),
+                m_cells(new Cell[m_capacity]) {
+            for (size_t i = 0; i < m_capacity; ++i) {
+                m_cells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        RingQueue(const RingQueue &other) = delete;
+
+        RingQueue &operator=(const RingQueue &other) = delete;
+
+        /**
+         * Pushes without waiting.
+         * @return false if the queue is full, value is left untouched.
+         */
+        bool try_push(T &value) {
+            size_t pos = m_tail.load(std::memory_order_relaxed);
+            while (true) {
+                Cell &cell = m_cells[pos % m_capacity];
+                size_t sequence = cell.sequence.load(std::memory_order_acquire);
+                auto diff = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(pos);
+                if (diff == 0) {
+                    if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        cell.value = std::move(value);
+                        cell.sequence.store(pos + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    pos = m_tail.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        /**
+         * Pushes values[0, count) without waiting. All their cells are claimed with a single CAS on the tail, so the
+         * values stay contiguous and producers synchronize once per run instead of once per element.
+         * @return false if fewer than count cells are free, values are left untouched.
+         */
+        bool try_push_bulk(T *values, size_t count) {
+            if (count == 0) {
+                return true;
+            }
+            if (count > m_capacity) {
+                return false;
+            }
+            size_t pos = m_tail.load(std::memory_order_relaxed);
+            while (true) {
+                // Every cell of the run must be free for this lap; a cell claimed ahead means the tail moved
+                std::intptr_t diff = 0;
+                for (size_t i = 0; i < count && diff == 0; ++i) {
+                    size_t sequence = m_cells[(pos + i) % m_capacity].sequence.load(std::memory_order_acquire);
+                    diff = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(pos + i);
+                }
+                if (diff < 0) {
+                    return false;
+                }
+                if (diff > 0) {
+                    pos = m_tail.load(std::memory_order_relaxed);
+                    continue;
+                }
+                if (m_tail.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed)) {
+                    for (size_t i = 0; i < count; ++i) {
+                        Cell &cell = m_cells[(pos + i) % m_capacity];
+                        cell.value = std::move(values[i]);
+                        cell.sequence.store(pos + i + 1, std::memory_order_release);
+                    }
+                    return true;
+                }
+            }
+        }
+
+        /**
+         * Pops without waiting.
+         * @return false if the queue is empty.
+         */
+        bool try_pop(T &value) {
+            size_t pos = m_head.load(std::memory_order_relaxed);
+            while (true) {
+                Cell &cell = m_cells[pos % m_capacity];
+                size_t sequence = cell.sequence.load(std::memory_order_acquire);
+                auto diff = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(pos + 1);
+                if (diff == 0) {
+                    if (m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        value = std::move(cell.value);
+                        cell.value = T();
+                        cell.sequence.store(pos + m_capacity, std::memory_order_release);
+                        return true;
+                    }
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    pos = m_head.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        /**
+         * Pushes value applying the overflow policy when the queue is full.
+         * @return false if the value was not queued: BLOCK timed out or REJECT. DROP_NEWEST returns true.
+         */
+        bool enqueue(T value) {
+            if (try_push(value)) {
+                return true;
+            }
+            switch (m_policy) {
+                case OverflowPolicy::REJECT:
+                    m_rejected.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                case OverflowPolicy::DROP_NEWEST:
+                    m_dropped_newest.fetch_add(1, std::memory_order_relaxed);
+                    return true;
+                case OverflowPolicy::DROP_OLDEST: {
+                    T oldest;
+                    while (!try_push(value)) {
+                        if (try_pop(oldest)) {
+                            m_dropped_oldest.fetch_add(1, std::memory_order_relaxed);
+                        }
+                    }
+                    return true;
+                }
+                case OverflowPolicy::BLOCK:
+                default:
+                    break;
+            }
+            m_blocked.fetch_add(1, std::memory_order_relaxed);
+            Backoff backoff(m_timeout);
+            while (backoff.wait()) {
+                if (try_push(value)) {
+                    return true;
+                }
+            }
+            m_block_timeouts.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        /**
+         * Pushes values[0, count) in order, as runs of cells claimed at once. When the queue has no room for the
+         * rest, the next value goes through enqueue() and its overflow policy before the next run is tried.
+         * @return number of values queued before the first refusal, the refused value is consumed.
+         */
+        size_t enqueue_bulk(T *values, size_t count) {
+            size_t done = 0;
+            while (done < count) {
+                const size_t run = std::min(count - done, m_capacity);
+                if (try_push_bulk(values + done, run)) {
+                    done += run;
+                    continue;
+                }
+                if (!enqueue(std::move(values[done]))) {
+                    return done;
+                }
+                done++;
+            }
+            return done;
+        }
+
+        /**
+         * Pops, waiting up to the timeout for an element.
+         * @return false if the queue stayed empty.
+         */
+        bool dequeue_blocking(T &value) {
+            return dequeue_for(value, m_timeout);
+        }
+
+        /**
+         * Pops, waiting up to timeout for an element.
+         * @return false if the queue stayed empty.
+         */
+        bool dequeue_for(T &value, std::chrono::milliseconds timeout) {
+            if (try_pop(value)) {
+                return true;
+            }
+            Backoff backoff(timeout);
+            while (backoff.wait()) {
+                if (try_pop(value)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool dequeue(T &value) {
+            return try_pop(value);
+        }
+
+        /**
+         * Approximate while producers or consumers are active.
+         */
+        size_t size() const {
+            size_t head = m_head.load(std::memory_order_relaxed);
+            size_t tail = m_tail.load(std::memory_order_relaxed);
+            return tail > head ? std::min(tail - head, m_capacity) : 0;
+        }
+
+        size_t capacity() const { return m_capacity; }
+
+        void wipeout() {
+            T value;
+            while (try_pop(value)) {
+            }
+        }
+
+        QueueStats get_stats() const {
+            QueueStats stats;
+            stats.backend = to_string(Backend::RING);
+            stats.policy = to_string(m_policy);
+            stats.capacity = m_capacity;
+            stats.size = this->size();
+            // The indexes already count every push and pop, no shared counter is touched on the fast path
+            stats.enqueued = m_tail.load(std::memory_order_relaxed);
+            stats.dequeued = m_head.load(std::memory_order_relaxed);
+            stats.blocked = m_blocked.load(std::memory_order_relaxed);
+            stats.block_timeouts = m_block_timeouts.load(std::memory_order_relaxed);
+            stats.dropped_newest = m_dropped_newest.load(std::memory_order_relaxed);
+            stats.dropped_oldest = m_dropped_oldest.load(std::memory_order_relaxed);
+            stats.rejected = m_rejected.load(std::memory_order_relaxed);
+            stats.dequeued -= std::min(stats.dequeued, stats.dropped_oldest);
+            return stats;
+        }
+
+    private:
+        static constexpr size_t cache_line = 64;
+
+        struct alignas(cache_line) Cell {
+            std::atomic<size_t> sequence;
+            T value;
+        };
+
+        const size_t m_capacity;
+        const OverflowPolicy m_policy;
+        const std::chrono::milliseconds m_timeout;
+        std::unique_ptr<Cell[]> m_cells;
+        alignas(cache_line) std::atomic<size_t> m_tail = 0; ///< Next position producers write.
+        alignas(cache_line) std::atomic<size_t> m_head = 0; ///< Next position consumers read.
+        alignas(cache_line) std::atomic<size_t> m_blocked = 0;
+        std::atomic<size_t> m_block_timeouts = 0;
+        std::atomic<size_t> m_dropped_newest = 0;
+        std::atomic<size_t> m_dropped_oldest = 0;
+        std::atomic<size_t> m_rejected = 0;
+    };
+
+    /**
+     * The write queue of MariaDBManager: the mutex based common::ThreadQueueWithMaxSize or a RingQueue,
+     * as selected by MariaDBConfig::queue_backend.
+     */
+    class QueryQueue {
+    public:
+        explicit QueryQueue(const simple_mariadb::config::MariaDBConfig &config);
+
+        bool enqueue(const std::string &query);
+
+        /**
+         * Moves the query into the queue without copying it. The query is consumed even when it is refused,
+         * callers that fall back to something else on failure use the copying overload.
+         */
+        bool enqueue(std::string &&query);
+
+        /**
+         * Moves queries into the queue in order. The ring backend publishes them as runs of cells claimed with one
+         * CAS each, the mutex backend takes them one by one.
+         * @return number of queries queued before the first refusal.
+         */
+        size_t enqueue_bulk(std::vector<std::string> &queries);
+
+        /**
+         * Waits up to queue_timeout seconds for a query.
+         */
+        bool dequeue_blocking(std::string &query);
+
+        /**
+         * Waits up to timeout for a query, a zero timeout only takes one that is already queued.
+         */
+        bool dequeue_for(std::string &query, std::chrono::milliseconds timeout);
+
+        size_t size();
+
+        void wipeout();
+
+        /**
+         * Counters of the mutex backend, default values with the ring backend which reports through
+         * get_queue_stats().
+         */
+        ::common::Stats get_stats();
+
+        QueueStats get_queue_stats();
+
+    private:
+        Backend m_backend = Backend::MUTEX;
+        std::unique_ptr<::common::ThreadQueueWithMaxSize<std::string>> m_mutex_queue;
+        std::unique_ptr<RingQueue<std::string>> m_ring_queue;
+        std::atomic<size_t> m_rejected = 0; ///< Failed enqueues of the mutex backend.
+    };
+
+}
+
+#endif //SIMPLE_MARIADB_QUEUE_H
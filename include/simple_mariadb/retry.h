@@ -0,0 +1,298 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+#ifndef SIMPLE_MARIADB_RETRY_H
+#define SIMPLE_MARIADB_RETRY_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace simple_mariadb::retry {
+
+    enum class ErrorClass {
+        TRANSIENT, ///< The statement may succeed as it is later on.
+        PERMANENT  ///< Running it again gives the same error.
+    };
+
+    /**
+     * Transient errors are the lost, refused or killed connections (2002, 2003, 2006, 2013, 2055, 1040, 1053, 1077,
+     * 1152, 1154-1161, 1927), deadlocks and lock wait timeouts (1213, 1205), interrupted or timed out statements (1317,
+     * 3024, 1969), read-only or full servers (1290, 1836, 1021, 1114) and every SQLSTATE of class 08 or 40001;
+     * code 0 comes from the connector without a server answer and is transient too. Everything else (syntax,
+     * constraints, unknown tables or columns, data too long...) is permanent.
+     */
+    ErrorClass classify(int error_code, std::string_view sql_state = {});
+
+    std::string to_string(ErrorClass error_class);
+
+    struct Failure {
+        int error_code = 0;
+        std::string sql_state;
+        std::string message;
+    };
+
+    /**
+     * How often and when a statement that failed with a transient error runs again.
+     */
+    struct Policy {
+        size_t max_attempts = 5; ///< Attempts of a statement, the first one included; 1 never retries.
+        std::chrono::milliseconds initial_backoff{100};
+        std::chrono::milliseconds max_backoff{30000};
+
+        /**
+         * Delay before attempt number attempt, 2 being the first retry: initial_backoff doubled at every attempt
+         * and capped at max_backoff.
+         */
+        [[nodiscard]] std::chrono::milliseconds backoff(size_t attempt) const;
+    };
+
+    /**
+     * Hashed timer wheel: slots buckets of one tick each, an entry further than one turn stays in its bucket until
+     * the turn of its deadline. Scheduling is O(1), advancing visits the buckets of the elapsed ticks only.
+     * Deadlines are rounded up to the next tick. Not thread safe.
+     */
+    template<typename T>
+    class TimerWheel {
+    public:
+        TimerWheel(std::chrono::milliseconds tick, size_t slots,
+                   std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now()) :
+                m_tick(std::max<std::chrono::milliseconds>(tick, std::chrono::milliseconds(1))),
+                m_start(start),
+                m_slots(std::max<size_t>(slots, 1)) {}
+
+        void schedule(T value, std::chrono::steady_clock::time_point when) {
+            const uint64_t deadline = std::max(this->m_ticks_until(when, true), m_current + 1);
+            m_slots[deadline % m_slots.size()].push_back({deadline, std::move(value)});
+            m_size++;
+        }
+
+        /**
+         * Moves the entries due at now into due.
+         */
+        void advance(std::chrono::steady_clock::time_point now, std::vector<T> &due) {
+            const uint64_t target = this->m_ticks_until(now, false);
+            if (target <= m_current) {
+                return;
+            }
+            // A full turn visits every bucket, ticks further back have nothing else to give
+            const uint64_t first = target - m_current > m_slots.size() ? target - m_slots.size() + 1 : m_current + 1;
+            for (uint64_t tick = first; tick <= target && m_size > 0; ++tick) {
+                auto &slot = m_slots[tick % m_slots.size()];
+                for (size_t i = 0; i < slot.size();) {
+                    if (slot[i].deadline <= target) {
+                        due.push_back(std::move(slot[i].value));
+                        slot[i] = std::move(slot.back());
+                        slot.pop_back();
+                        m_size--;
+                    } else {
+                        ++i;
+                    }
+                }
+            }
+            m_current = target;
+        }
+
+        /**
+         * Moves every entry into out, due or not.
+         */
+        void drain(std::vector<T> &out) {
+            for (auto &slot: m_slots) {
+                for (auto &entry: slot) {
+                    out.push_back(std::move(entry.value));
+                }
+                slot.clear();
+            }
+            m_size = 0;
+        }
+
+        /**
+         * Time of the next tick holding entries, or time_point::max() if the wheel is empty.
+         */
+        [[nodiscard]] std::chrono::steady_clock::time_point next_deadline() const {
+            uint64_t next = UINT64_MAX;
+            for (const auto &slot: m_slots) {
+                for (const auto &entry: slot) {
+                    next = std::min(next, entry.deadline);
+                }
+            }
+            if (next == UINT64_MAX) {
+                return std::chrono::steady_clock::time_point::max();
+            }
+            return m_start + m_tick * next;
+        }
+
+        [[nodiscard]] size_t size() const { return m_size; }
+
+    private:
+        struct Entry {
+            uint64_t deadline; ///< Tick at which the entry is due.
+            T value;
+        };
+
+        uint64_t m_ticks_until(std::chrono::steady_clock::time_point when, bool round_up) const {
+            if (when <= m_start) {
+                return 0;
+            }
+            const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(when - m_start);
+            const auto ticks = static_cast<uint64_t>(elapsed / m_tick);
+            return round_up && elapsed % m_tick != std::chrono::milliseconds(0) ? ticks + 1 : ticks;
+        }
+
+        const std::chrono::milliseconds m_tick;
+        const std::chrono::steady_clock::time_point m_start;
+        std::vector<std::vector<Entry>> m_slots;
+        uint64_t m_current = 0; ///< Last tick advanced to.
+        size_t m_size = 0;
+    };
+
+    /**
+     * A statement waiting for its next attempt.
+     */
+    struct Pending {
+        std::string statement;
+        size_t attempts = 0; ///< Attempts made so far.
+        Failure failure;     ///< Error of the last attempt.
+    };
+
+    /**
+     * A statement given up on.
+     */
+    struct DeadLetter {
+        std::string statement;
+        size_t attempts = 0;
+        Failure failure;
+        std::string reason; ///< "permanent", "exhausted" or "stopped".
+        std::chrono::system_clock::time_point time;
+
+        [[nodiscard]] nlohmann::json to_json() const;
+    };
+
+    typedef std::function<void(const DeadLetter &letter)> DeadLetterCallback;
+
+    /**
+     * Offered a statement given up on after transient failures; returns true if it kept the statement, which is
+     * then not a dead letter.
+     */
+    typedef std::function<bool(const std::string &statement)> Fallback;
+
+    struct RetryStats {
+        size_t transient = 0;     ///< Failures classified as transient.
+        size_t permanent = 0;     ///< Failures classified as permanent.
+        size_t scheduled = 0;     ///< Retries put on the wheel.
+        size_t retried = 0;       ///< Retries taken from the wheel to run.
+        size_t recovered = 0;     ///< Retries that succeeded.
+        size_t pending = 0;       ///< Retries waiting on the wheel.
+        size_t postponed = 0;     ///< Retries put back without using an attempt, the server was out of reach.
+        size_t fallen_back = 0;   ///< Statements given up on that the fallback kept.
+        size_t dead_lettered = 0; ///< Statements given to the dead letter sinks.
+        size_t sink_errors = 0;   ///< Dead letters the file or the callback failed to take.
+
+        [[nodiscard]] nlohmann::json to_json() const;
+    };
+
+    /**
+     * Routes failed statements. A transient failure is scheduled on a timer wheel for another attempt after the
+     * backoff of the policy; a permanent failure, or a transient one out of attempts, becomes a dead letter.
+     *
+     * A statement given up on after transient failures is offered to the fallback first, if any. Dead letters are
+     * appended as JSON lines to the file given, if any, and passed to the callback, if any. Both happen on the
+     * consumer in wait() or flush(): the threads reporting failures never do I/O, which keeps fail() usable from
+     * the event loop of the nonblocking engine. fail() is thread safe, wait(), take_all() and flush() are meant for
+     * a single consumer thread.
+     */
+    class Retrier {
+    public:
+        static constexpr std::chrono::milliseconds TICK{10};
+        static constexpr size_t SLOTS = 512; ///< About 5 s per turn of the wheel.
+
+        /**
+         * @param dead_letter_path file the dead letters are appended to, empty for none.
+         * @throws std::runtime_error if the file cannot be opened.
+         */
+        Retrier(Policy policy, const std::string &dead_letter_path);
+
+        Retrier(const Retrier &other) = delete;
+
+        Retrier &operator=(const Retrier &other) = delete;
+
+        void set_callback(DeadLetterCallback callback);
+
+        void set_fallback(Fallback fallback);
+
+        /**
+         * Records that attempt number attempts of statement failed.
+         * @param may_retry false gives up on the statement even if the error is transient, with reason "stopped".
+         * @return true if the statement was scheduled again.
+         */
+        bool fail(std::string statement, size_t attempts, Failure failure, bool may_retry = true);
+
+        /**
+         * Schedules pending again after delay without using an attempt, for retries that never reached the server.
+         * Clears pending.
+         */
+        void postpone(std::vector<Pending> &pending, std::chrono::milliseconds delay);
+
+        /**
+         * Gives up on pending with reason "stopped", keeping their last failure. Clears pending.
+         */
+        void give_up(std::vector<Pending> &pending);
+
+        /**
+         * Counts a retry that succeeded.
+         */
+        void recovered();
+
+        /**
+         * Waits up to timeout for a retry to be due, or for stop(). Moves the due retries into due and hands the
+         * dead letters to the sinks.
+         */
+        void wait(std::chrono::milliseconds timeout, std::vector<Pending> &due);
+
+        /**
+         * Moves every scheduled retry into out, due or not.
+         */
+        void take_all(std::vector<Pending> &out);
+
+        /**
+         * Hands the dead letters to the sinks.
+         */
+        void flush();
+
+        /**
+         * Wakes up wait().
+         */
+        void stop();
+
+        size_t pending();
+
+        RetryStats get_stats();
+
+    private:
+        void m_dead_letter(std::string &&statement, size_t attempts, Failure &&failure, const char *reason);
+
+        const Policy m_policy;
+        std::mutex m_mutex; ///< Guards the wheel, the letters, the stop flag and the counters.
+        std::condition_variable m_cv;
+        TimerWheel<Pending> m_wheel{TICK, SLOTS};
+        std::vector<DeadLetter> m_letters; ///< Waiting for the consumer to write them.
+        bool m_stopped = false;
+        RetryStats m_stats;
+
+        std::mutex m_sink_mutex; ///< Guards the file, the callback and the fallback.
+        std::ofstream m_file;
+        DeadLetterCallback m_callback;
+        Fallback m_fallback;
+    };
+
+}
+
+#endif //SIMPLE_MARIADB_RETRY_H
@@ -0,0 +1,176 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+#ifndef SIMPLE_MARIADB_ROWS_H
+#define SIMPLE_MARIADB_ROWS_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <variant>
+#include <vector>
+#include <conncpp.hpp>
+#include <simple_mariadb/statement.h>
+
+namespace simple_mariadb::rows {
+
+    /**
+     * A buffered column value. Integers and floating point values are widened, strings are owned.
+     */
+    typedef std::variant<std::nullptr_t, bool, int64_t, uint64_t, double, std::string> Value;
+
+    template<typename T>
+    Value to_value(const T &value) {
+        using U = std::decay_t<T>;
+        if constexpr (std::is_same_v<U, std::nullptr_t> || std::is_same_v<U, std::nullopt_t>) {
+            return nullptr;
+        } else if constexpr (std::is_same_v<U, Value>) {
+            return value;
+        } else if constexpr (simple_mariadb::statement::is_optional<U>::value) {
+            return value.has_value() ? to_value(*value) : Value(nullptr);
+        } else if constexpr (std::is_same_v<U, bool>) {
+            return value;
+        } else if constexpr (std::is_integral_v<U> && std::is_signed_v<U>) {
+            return static_cast<int64_t>(value);
+        } else if constexpr (std::is_integral_v<U>) {
+            return static_cast<uint64_t>(value);
+        } else if constexpr (std::is_floating_point_v<U>) {
+            return static_cast<double>(value);
+        } else if constexpr (std::is_convertible_v<U, std::string_view>) {
+            return std::string(std::string_view(value));
+        } else {
+            static_assert(sizeof(U) == 0, "simple_mariadb::rows::to_value: unsupported column type");
+        }
+    }
+
+    /**
+     * Binds value to the 1-based parameter index with the setter matching the held type.
+     */
+    void bind_value(sql::PreparedStatement &stmt, int32_t index, const Value &value);
+
+    /**
+     * `INSERT INTO `table` (`c1`,`c2`) VALUES (?,?)` for the given columns.
+     */
+    std::string insert_statement(const std::string &table, const std::vector<std::string> &columns);
+
+    /**
+     * Rows of one table and column list, stored row-major in values.
+     */
+    struct RowBatch {
+        std::string sql;
+        size_t columns = 0;
+        std::vector<Value> values;
+
+        [[nodiscard]] size_t rows() const { return columns == 0 ? 0 : values.size() / columns; }
+    };
+
+    /**
+     * Value as a SQL literal: NULL, a number, or a quoted string with quotes, backslashes and control characters
+     * escaped.
+     */
+    std::string to_literal(const Value &value);
+
+    /**
+     * Text statement writing one row of batch, sql with its placeholders replaced by the literals of the row. Used
+     * where only text statements go, like the retries and the spill log.
+     */
+    std::string row_statement(const RowBatch &batch, size_t row);
+
+    /**
+     * Thread-safe per-table accumulation of typed rows waiting to be written as batches.
+     */
+    class RowBuffer {
+    public:
+        /**
+         * @param max_rows rows per batch handed to the writer.
+         * @param max_pending rows buffered in total before add() rejects new rows.
+         */
+        RowBuffer(size_t max_rows, size_t max_pending);
+
+        /**
+         * Buffers a row. The row must have one value per column.
+         * @return false if the row does not match the columns or the buffer is full.
+         */
+        bool add(const std::string &table, const std::vector<std::string> &columns, std::vector<Value> &&row);
+
+        /**
+         * Waits until rows are pending and either a batch is full, the oldest row waited linger, or running turns
+         * false. Returns the batches to write, at most max_rows rows each; empty when woken without work.
+         */
+        std::vector<RowBatch> wait_batches(std::chrono::milliseconds linger, const std::atomic<bool> &running);
+
+        /**
+         * Takes every pending row without waiting.
+         */
+        std::vector<RowBatch> take_all();
+
+        /**
+         * Marks batches returned by wait_batches() / take_all() as written so pending_rows() drops.
+         */
+        void done(size_t rows);
+
+        /**
+         * Rows buffered or handed out but not written yet.
+         */
+        size_t pending_rows();
+
+        void wipeout();
+
+        /**
+         * Ends the linger wait so the pending rows are handed out right away.
+         */
+        void flush();
+
+        void notify();
+
+    private:
+        struct Key {
+            std::string table;
+            std::vector<std::string> columns;
+        };
+
+        struct KeyRef {
+            const std::string &table;
+            const std::vector<std::string> &columns;
+        };
+
+        struct KeyLess {
+            using is_transparent = void;
+
+            template<typename A, typename B>
+            bool operator()(const A &a, const B &b) const {
+                return std::tie(a.table, a.columns) < std::tie(b.table, b.columns);
+            }
+        };
+
+        struct Table {
+            std::string sql;
+            size_t columns = 0;
+            std::vector<Value> values;
+            std::chrono::steady_clock::time_point oldest;
+        };
+
+        void m_take(std::vector<RowBatch> &batches);
+
+        const size_t m_max_rows;
+        const size_t m_max_pending;
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+        std::map<Key, Table, KeyLess> m_tables;
+        size_t m_buffered = 0;  ///< Rows in m_tables.
+        size_t m_in_flight = 0; ///< Rows handed out and not confirmed by done().
+        bool m_full = false;    ///< Some table holds a complete batch.
+    };
+
+}
+
+#endif //SIMPLE_MARIADB_ROWS_H
@@ -0,0 +1,123 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+#ifndef SIMPLE_MARIADB_SPILL_H
+#define SIMPLE_MARIADB_SPILL_H
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace simple_mariadb::spill {
+
+    struct SpillStats {
+        size_t segments = 0;
+        size_t bytes = 0;     ///< Size of the segment files on disk.
+        size_t pending = 0;   ///< Records appended and not committed yet.
+        size_t appended = 0;
+        size_t committed = 0; ///< Records replayed and marked as done.
+        size_t recovered = 0; ///< Pending records found when the log was opened.
+        size_t rejected = 0;  ///< Appends refused because the record is too large or the log is full.
+
+        [[nodiscard]] nlohmann::json to_json() const;
+    };
+
+    /**
+     * CRC-32 (IEEE 802.3) of data.
+     */
+    uint32_t crc32(std::string_view data);
+
+    /**
+     * Append-only log of records in memory-mapped segment files.
+     *
+     * A segment is a preallocated file `segment-<sequence>.log` holding a header and records laid out as
+     * `[u32 length][u32 crc][payload]`, padded to 8 bytes. The length is stored last, so a record cut short by a
+     * crash reads as the end of the segment. A replayed record is committed by setting the top bit of its
+     * length in place; fully committed segments are deleted. Opening the log scans the existing segments and
+     * resumes from the first record that was not committed.
+     *
+     * Data survives a crash of the process once append() returns; sync() flushes it to the device as well.
+     * Thread safe, committing is meant for a single consumer.
+     */
+    class SegmentLog {
+    public:
+        /**
+         * Opens or creates the log in directory and recovers the records left by a previous process.
+         * @param segment_size bytes per segment file, it bounds the largest record.
+         * @param max_bytes bytes of segment files kept on disk, 0 for no limit.
+         * @throws std::runtime_error if the directory or a segment cannot be created or mapped.
+         */
+        SegmentLog(std::string directory, size_t segment_size, size_t max_bytes);
+
+        SegmentLog(const SegmentLog &other) = delete;
+
+        SegmentLog &operator=(const SegmentLog &other) = delete;
+
+        ~SegmentLog();
+
+        /**
+         * @return false if the record does not fit in a segment, the log is full or a new segment cannot be created.
+         */
+        bool append(std::string_view record);
+
+        /**
+         * Copies up to max pending records, oldest first, without committing them.
+         * @return number of records added to records.
+         */
+        size_t peek(size_t max, std::vector<std::string> &records);
+
+        /**
+         * Marks the count oldest pending records as replayed.
+         */
+        void commit(size_t count);
+
+        size_t pending();
+
+        /**
+         * Flushes the mapped segments to the device.
+         */
+        void sync();
+
+        SpillStats get_stats();
+
+    private:
+        struct Segment {
+            uint64_t sequence = 0;
+            std::string path;
+            int fd = -1;
+            char *data = nullptr;
+            size_t size = 0;
+            size_t end = 0; ///< Offset after the last complete record.
+        };
+
+        std::string m_path(uint64_t sequence) const;
+
+        void m_recover();
+
+        bool m_open(Segment &segment, bool create);
+
+        void m_close(Segment &segment, bool remove);
+
+        bool m_roll();
+
+        void m_drop_committed();
+
+        const std::string m_directory;
+        const size_t m_segment_size;
+        const size_t m_max_bytes;
+
+        std::mutex m_mutex;
+        std::deque<Segment> m_segments; ///< Oldest first, the last one takes appends.
+        size_t m_read_offset = 0;       ///< First pending record in the oldest segment.
+        uint64_t m_next_sequence = 1;
+        SpillStats m_stats;
+    };
+
+}
+
+#endif //SIMPLE_MARIADB_SPILL_H
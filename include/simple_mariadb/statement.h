@@ -0,0 +1,136 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+#ifndef SIMPLE_MARIADB_STATEMENT_H
+#define SIMPLE_MARIADB_STATEMENT_H
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <conncpp.hpp>
+#include <nlohmann/json.hpp>
+
+namespace simple_mariadb::statement {
+
+    struct StatementCacheStats {
+        size_t size = 0;
+        size_t capacity = 0;
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t evictions = 0;
+        size_t resets = 0; ///< Times the cache was dropped because its connection was replaced.
+
+        StatementCacheStats &operator+=(const StatementCacheStats &other);
+
+        [[nodiscard]] nlohmann::json to_json() const;
+    };
+
+    /**
+     * LRU cache of prepared statements of one connection, keyed by SQL text.
+     *
+     * The cache shares ownership of the connection its statements were prepared on, so a reconnect that replaces the
+     * caller's connection never leaves a statement pointing at a freed one, nor lets a new connection allocated at
+     * the same address pick up the old statements. When a different connection is handed in the cache is dropped
+     * and statements are prepared again on first use.
+     * Not thread safe: callers hold the connection exclusively while they use it. The counters are atomics, so
+     * get_stats() can be called from any thread without taking the caller's lock.
+     */
+    class StatementCache {
+    public:
+        explicit StatementCache(size_t capacity);
+
+        StatementCache(const StatementCache &other) = delete;
+
+        StatementCache &operator=(const StatementCache &other) = delete;
+
+        /**
+         * Returns the cached statement for sql on conn, preparing it on a miss.
+         * @throws sql::SQLException if the server rejects the statement.
+         */
+        sql::PreparedStatement &get(const std::shared_ptr<sql::Connection> &conn, const std::string &sql);
+
+        void evict(const std::string &sql);
+
+        void clear();
+
+        [[nodiscard]] StatementCacheStats get_stats() const;
+
+    private:
+        typedef std::pair<std::string, std::unique_ptr<sql::PreparedStatement>> Entry;
+
+        size_t m_capacity;
+        std::shared_ptr<sql::Connection> m_conn; ///< Declared before m_lru: the statements are destroyed first.
+        std::list<Entry> m_lru; ///< Most recently used first.
+        std::unordered_map<std::string, std::list<Entry>::iterator> m_index;
+        std::atomic<size_t> m_size = 0; ///< m_lru.size(), published for get_stats().
+        std::atomic<size_t> m_hits = 0;
+        std::atomic<size_t> m_misses = 0;
+        std::atomic<size_t> m_evictions = 0;
+        std::atomic<size_t> m_resets = 0;
+    };
+
+    /**
+     * True for server errors after which the statement has to be prepared again.
+     */
+    bool needs_reprepare(const sql::SQLException &e);
+
+    template<typename T>
+    struct is_optional : std::false_type {
+    };
+
+    template<typename T>
+    struct is_optional<std::optional<T>> : std::true_type {
+    };
+
+    /**
+     * Binds value to the 1-based parameter index with the setter matching its C++ type.
+     */
+    template<typename T>
+    void bind(sql::PreparedStatement &stmt, int32_t index, const T &value) {
+        using U = std::decay_t<T>;
+        if constexpr (std::is_same_v<U, std::nullptr_t> || std::is_same_v<U, std::nullopt_t>) {
+            stmt.setNull(index, sql::VARCHAR);
+        } else if constexpr (is_optional<U>::value) {
+            if (value.has_value()) {
+                bind(stmt, index, *value);
+            } else {
+                stmt.setNull(index, sql::VARCHAR);
+            }
+        } else if constexpr (std::is_same_v<U, bool>) {
+            stmt.setBoolean(index, value);
+        } else if constexpr (std::is_integral_v<U> && std::is_signed_v<U> && sizeof(U) <= sizeof(int32_t)) {
+            stmt.setInt(index, static_cast<int32_t>(value));
+        } else if constexpr (std::is_integral_v<U> && std::is_signed_v<U>) {
+            stmt.setInt64(index, static_cast<int64_t>(value));
+        } else if constexpr (std::is_integral_v<U> && sizeof(U) <= sizeof(uint32_t)) {
+            stmt.setUInt(index, static_cast<uint32_t>(value));
+        } else if constexpr (std::is_integral_v<U>) {
+            stmt.setUInt64(index, static_cast<uint64_t>(value));
+        } else if constexpr (std::is_same_v<U, float>) {
+            stmt.setFloat(index, value);
+        } else if constexpr (std::is_floating_point_v<U>) {
+            stmt.setDouble(index, static_cast<double>(value));
+        } else if constexpr (std::is_same_v<U, std::string_view>) {
+            stmt.setString(index, sql::SQLString(std::string(value)));
+        } else if constexpr (std::is_convertible_v<U, std::string>) {
+            stmt.setString(index, sql::SQLString(value));
+        } else {
+            static_assert(sizeof(U) == 0, "simple_mariadb::statement::bind: unsupported parameter type");
+        }
+    }
+
+    template<typename... Args>
+    void bind_all(sql::PreparedStatement &stmt, const Args &... args) {
+        int32_t index = 1;
+        (bind(stmt, index++, args), ...);
+    }
+
+}
+
+#endif //SIMPLE_MARIADB_STATEMENT_H
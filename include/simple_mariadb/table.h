@@ -0,0 +1,143 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+#ifndef SIMPLE_MARIADB_TABLE_H
+#define SIMPLE_MARIADB_TABLE_H
+
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace simple_mariadb::table {
+
+    /**
+     * Rows of text cells in one arena.
+     *
+     * The column names are stored once in a header shared by the copies of the table. Cells are appended row-major
+     * into a single string; cell i spans [offsets[i], offsets[i + 1]) of it. Reading a cell is an index into the
+     * offsets and returns a std::string_view into the arena, valid until the table is modified or destroyed.
+     * NULL reads as an empty string, like select(); is_null() tells them apart.
+     */
+    class ResultTable {
+    public:
+        /**
+         * View of one row of a table.
+         */
+        class Row {
+        public:
+            Row(const ResultTable &table, size_t row) : m_table(&table), m_row(row) {}
+
+            std::string_view operator[](size_t column) const { return m_table->at(m_row, column); }
+
+            std::string_view operator[](std::string_view column) const { return m_table->at(m_row, column); }
+
+            [[nodiscard]] bool is_null(size_t column) const { return m_table->is_null(m_row, column); }
+
+            [[nodiscard]] size_t size() const { return m_table->column_count(); }
+
+            [[nodiscard]] size_t index() const { return m_row; }
+
+        private:
+            const ResultTable *m_table;
+            size_t m_row;
+        };
+
+        class const_iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = Row;
+            using difference_type = std::ptrdiff_t;
+            using pointer = void;
+            using reference = Row;
+
+            const_iterator(const ResultTable &table, size_t row) : m_table(&table), m_row(row) {}
+
+            Row operator*() const { return {*m_table, m_row}; }
+
+            const_iterator &operator++() {
+                ++m_row;
+                return *this;
+            }
+
+            const_iterator operator++(int) {
+                const_iterator previous = *this;
+                ++m_row;
+                return previous;
+            }
+
+            bool operator==(const const_iterator &other) const { return m_row == other.m_row; }
+
+            bool operator!=(const const_iterator &other) const { return m_row != other.m_row; }
+
+        private:
+            const ResultTable *m_table;
+            size_t m_row;
+        };
+
+        ResultTable();
+
+        explicit ResultTable(std::vector<std::string> columns);
+
+        /**
+         * Drops the rows and sets a new header. The arena keeps its capacity for the next result.
+         */
+        void reset(std::vector<std::string> columns);
+
+        [[nodiscard]] size_t rows() const { return m_columns->empty() ? 0 : m_nulls.size() / m_columns->size(); }
+
+        [[nodiscard]] size_t column_count() const { return m_columns->size(); }
+
+        [[nodiscard]] bool empty() const { return this->rows() == 0; }
+
+        [[nodiscard]] const std::vector<std::string> &header() const { return *m_columns; }
+
+        /**
+         * @throws std::out_of_range if the table has no column called name.
+         */
+        [[nodiscard]] size_t column_index(std::string_view name) const;
+
+        [[nodiscard]] std::string_view at(size_t row, size_t column) const {
+            const size_t cell = row * m_columns->size() + column;
+            return {m_arena.data() + m_offsets[cell], m_offsets[cell + 1] - m_offsets[cell]};
+        }
+
+        [[nodiscard]] std::string_view at(size_t row, std::string_view column) const {
+            return this->at(row, this->column_index(column));
+        }
+
+        [[nodiscard]] bool is_null(size_t row, size_t column) const {
+            return m_nulls[row * m_columns->size() + column];
+        }
+
+        Row operator[](size_t row) const { return {*this, row}; }
+
+        [[nodiscard]] const_iterator begin() const { return {*this, 0}; }
+
+        [[nodiscard]] const_iterator end() const { return {*this, this->rows()}; }
+
+        /**
+         * Appends the next cell, row-major. A row is complete once column_count() cells were appended.
+         */
+        void append(std::string_view value);
+
+        void append_null();
+
+        /**
+         * Bytes of cell data in the arena.
+         */
+        [[nodiscard]] size_t arena_bytes() const { return m_arena.size(); }
+
+    private:
+        std::shared_ptr<const std::vector<std::string>> m_columns;
+        std::string m_arena;
+        std::vector<size_t> m_offsets{0};
+        std::vector<bool> m_nulls;
+    };
+
+}
+
+#endif //SIMPLE_MARIADB_TABLE_H
@@ -0,0 +1,566 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+#include "simple_mariadb/batch.h"
+
+namespace simple_mariadb::batch {
+
+    namespace {
+
+        bool is_space(char c) {
+            return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+        }
+
+        bool is_identifier_char(char c) {
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+                   c == '_' || c == '$' || static_cast<unsigned char>(c) >= 0x80;
+        }
+
+        char to_upper_ascii(char c) {
+            return (c >= 'a' && c <= 'z') ? static_cast<char>(c - 'a' + 'A') : c;
+        }
+
+        void skip_spaces(std::string_view query, size_t &pos) {
+            while (pos < query.size() && is_space(query[pos])) {
+                ++pos;
+            }
+        }
+
+        // Case-insensitive keyword match that does not accept a prefix of a longer word
+        bool match_keyword(std::string_view query, size_t &pos, std::string_view keyword) {
+            if (query.size() - pos < keyword.size()) {
+                return false;
+            }
+            for (size_t i = 0; i < keyword.size(); ++i) {
+                if (to_upper_ascii(query[pos + i]) != keyword[i]) {
+                    return false;
+                }
+            }
+            if (pos + keyword.size() < query.size() && is_identifier_char(query[pos + keyword.size()])) {
+                return false;
+            }
+            pos += keyword.size();
+            return true;
+        }
+
+        // query[pos] is the opening quote. Backslash escapes apply to string literals, doubled quotes to all
+        bool skip_quoted(std::string_view query, size_t &pos) {
+            const char quote = query[pos++];
+            while (pos < query.size()) {
+                const char c = query[pos];
+                if (c == '\\' && quote != '`') {
+                    pos += 2;
+                    continue;
+                }
+                if (c == quote) {
+                    if (pos + 1 < query.size() && query[pos + 1] == quote) {
+                        pos += 2;
+                        continue;
+                    }
+                    ++pos;
+                    return true;
+                }
+                ++pos;
+            }
+            return false;
+        }
+
+        bool parse_identifier_part(std::string_view query, size_t &pos) {
+            if (pos >= query.size()) {
+                return false;
+            }
+            if (query[pos] == '`') {
+                return skip_quoted(query, pos);
+            }
+            const size_t start = pos;
+            while (pos < query.size() && is_identifier_char(query[pos])) {
+                ++pos;
+            }
+            return pos > start;
+        }
+
+        // [schema.]table, each part bare or backticked
+        bool parse_identifier(std::string_view query, size_t &pos) {
+            if (!parse_identifier_part(query, pos)) {
+                return false;
+            }
+            if (pos < query.size() && query[pos] == '.') {
+                ++pos;
+                return parse_identifier_part(query, pos);
+            }
+            return true;
+        }
+
+        // query[pos] is '('. Leaves pos after the matching ')'
+        bool skip_parenthesized(std::string_view query, size_t &pos) {
+            size_t depth = 0;
+            while (pos < query.size()) {
+                const char c = query[pos];
+                if (c == '\'' || c == '"' || c == '`') {
+                    if (!skip_quoted(query, pos)) {
+                        return false;
+                    }
+                    continue;
+                }
+                ++pos;
+                if (c == '(') {
+                    ++depth;
+                } else if (c == ')') {
+                    if (--depth == 0) {
+                        return true;
+                    }
+                }
+            }
+            return false;
+        }
+
+        bool has_statement_separator(std::string_view text) {
+            size_t pos = 0;
+            while (pos < text.size()) {
+                const char c = text[pos];
+                if (c == '\'' || c == '"' || c == '`') {
+                    if (!skip_quoted(text, pos)) {
+                        return true; // unterminated quote, treat as unsafe
+                    }
+                    continue;
+                }
+                if (c == ';') {
+                    return true;
+                }
+                ++pos;
+            }
+            return false;
+        }
+
+        std::string_view trim_statement_end(std::string_view text) {
+            while (!text.empty() && is_space(text.back())) {
+                text.remove_suffix(1);
+            }
+            if (!text.empty() && text.back() == ';') {
+                text.remove_suffix(1);
+                while (!text.empty() && is_space(text.back())) {
+                    text.remove_suffix(1);
+                }
+            }
+            return text;
+        }
+
+        void append_normalized(std::string &key, std::string_view identifier) {
+            for (char c: identifier) {
+                if (!is_space(c) && c != '`') {
+                    key.push_back(c);
+                }
+            }
+        }
+
+        bool is_digit(char c) {
+            return c >= '0' && c <= '9';
+        }
+
+        bool skip_digits(std::string_view query, size_t &pos) {
+            const size_t start = pos;
+            while (pos < query.size() && is_digit(query[pos])) {
+                ++pos;
+            }
+            return pos > start;
+        }
+
+        // [+-]digits[.digits][e[+-]digits], .digits, 0x... or 0b...; the number must end at a word boundary
+        bool parse_number(std::string_view query, size_t &pos) {
+            if (query[pos] == '+' || query[pos] == '-') {
+                ++pos;
+            }
+            if (query.substr(pos, 2) == "0x" || query.substr(pos, 2) == "0b") {
+                pos += 2;
+                const size_t start = pos;
+                while (pos < query.size() && is_identifier_char(query[pos])) {
+                    ++pos;
+                }
+                return pos > start;
+            }
+            bool digits = skip_digits(query, pos);
+            if (pos < query.size() && query[pos] == '.') {
+                ++pos;
+                digits = skip_digits(query, pos) || digits;
+            }
+            if (!digits) {
+                return false;
+            }
+            if (pos < query.size() && (query[pos] == 'e' || query[pos] == 'E')) {
+                ++pos;
+                if (pos < query.size() && (query[pos] == '+' || query[pos] == '-')) {
+                    ++pos;
+                }
+                if (!skip_digits(query, pos)) {
+                    return false;
+                }
+            }
+            return pos == query.size() || !is_identifier_char(query[pos]);
+        }
+
+        bool parse_value_list(std::string_view query, size_t &pos, size_t depth, bool allow_empty, size_t &count);
+
+        // A quoted string, a number, a word (NULL, DEFAULT, a charset introducer before a string) or a call
+        bool parse_value(std::string_view query, size_t &pos, size_t depth) {
+            if (pos >= query.size()) {
+                return false;
+            }
+            const char c = query[pos];
+            if (c == '\'' || c == '"') {
+                return skip_quoted(query, pos);
+            }
+            if (c == '+' || c == '-' || c == '.' || is_digit(c)) {
+                return parse_number(query, pos);
+            }
+            if (!is_identifier_char(c)) {
+                return false;
+            }
+            while (pos < query.size() && is_identifier_char(query[pos])) {
+                ++pos;
+            }
+            if (pos < query.size() && query[pos] == '\'') { // _utf8mb4'...', X'...', b'...'
+                return skip_quoted(query, pos);
+            }
+            size_t next = pos;
+            skip_spaces(query, next);
+            if (next < query.size() && query[next] == '(') {
+                const size_t max_depth = 8;
+                size_t arguments = 0;
+                pos = next;
+                return depth < max_depth && parse_value_list(query, pos, depth + 1, true, arguments);
+            }
+            return true;
+        }
+
+        // query[pos] is expected to be '('. Counts the comma separated values up to the matching ')'
+        bool parse_value_list(std::string_view query, size_t &pos, size_t depth, bool allow_empty, size_t &count) {
+            if (pos >= query.size() || query[pos] != '(') {
+                return false;
+            }
+            ++pos;
+            skip_spaces(query, pos);
+            count = 0;
+            if (allow_empty && pos < query.size() && query[pos] == ')') {
+                ++pos;
+                return true;
+            }
+            while (true) {
+                if (!parse_value(query, pos, depth)) {
+                    return false;
+                }
+                ++count;
+                skip_spaces(query, pos);
+                if (pos >= query.size()) {
+                    return false;
+                }
+                if (query[pos] == ')') {
+                    ++pos;
+                    return true;
+                }
+                if (query[pos] != ',') {
+                    return false;
+                }
+                ++pos;
+                skip_spaces(query, pos);
+            }
+        }
+
+        // query[pos] is expected to be '('. Counts the columns, each one bare or backticked and not empty
+        bool parse_column_list(std::string_view query, size_t &pos, size_t &count) {
+            if (pos >= query.size() || query[pos] != '(') {
+                return false;
+            }
+            ++pos;
+            count = 0;
+            while (true) {
+                skip_spaces(query, pos);
+                const size_t start = pos;
+                if (!parse_identifier_part(query, pos) || (query[start] == '`' && pos - start <= 2)) {
+                    return false;
+                }
+                ++count;
+                skip_spaces(query, pos);
+                if (pos >= query.size()) {
+                    return false;
+                }
+                if (query[pos] == ')') {
+                    ++pos;
+                    return true;
+                }
+                if (query[pos] != ',') {
+                    return false;
+                }
+                ++pos;
+            }
+        }
+
+        std::string_view insert_head(InsertType type) {
+            switch (type) {
+                case InsertType::REPLACE:
+                    return "REPLACE INTO ";
+                case InsertType::IGNORE:
+                    return "INSERT IGNORE INTO ";
+                default:
+                    return "INSERT INTO ";
+            }
+        }
+
+    }
+
+    bool is_insert_or_replace(std::string_view query) {
+        size_t pos = 0;
+        skip_spaces(query, pos);
+        if (match_keyword(query, pos, "INSERT")) {
+            skip_spaces(query, pos);
+            match_keyword(query, pos, "IGNORE");
+        } else if (!match_keyword(query, pos, "REPLACE")) {
+            return false;
+        }
+        skip_spaces(query, pos);
+        // The server takes INTO`t`, the regular expressions want a blank after INTO
+        if (!match_keyword(query, pos, "INTO") || pos == query.size() || !is_space(query[pos])) {
+            return false;
+        }
+        skip_spaces(query, pos);
+        if (!parse_identifier(query, pos)) {
+            return false;
+        }
+        skip_spaces(query, pos);
+        size_t columns = 0;
+        if (!parse_column_list(query, pos, columns)) {
+            return false;
+        }
+        skip_spaces(query, pos);
+        if (!match_keyword(query, pos, "VALUES")) {
+            return false;
+        }
+        while (true) {
+            skip_spaces(query, pos);
+            size_t values = 0;
+            if (!parse_value_list(query, pos, 0, false, values) || values != columns) {
+                return false;
+            }
+            skip_spaces(query, pos);
+            if (pos < query.size() && query[pos] == ',') {
+                ++pos;
+                continue;
+            }
+            break;
+        }
+        if (pos < query.size() && query[pos] == ';') {
+            ++pos;
+            skip_spaces(query, pos);
+        }
+        return pos == query.size();
+    }
+
+    bool parse_insert(std::string_view query, ParsedInsert &parsed) {
+        size_t pos = 0;
+        skip_spaces(query, pos);
+        if (match_keyword(query, pos, "INSERT")) {
+            parsed.type = InsertType::INSERT;
+            skip_spaces(query, pos);
+            if (match_keyword(query, pos, "IGNORE")) {
+                parsed.type = InsertType::IGNORE;
+            }
+        } else if (match_keyword(query, pos, "REPLACE")) {
+            parsed.type = InsertType::REPLACE;
+        } else {
+            return false;
+        }
+        skip_spaces(query, pos);
+        if (!match_keyword(query, pos, "INTO")) {
+            return false;
+        }
+
+        skip_spaces(query, pos);
+        size_t start = pos;
+        if (!parse_identifier(query, pos)) {
+            return false;
+        }
+        parsed.table = query.substr(start, pos - start);
+
+        skip_spaces(query, pos);
+        if (pos >= query.size() || query[pos] != '(') {
+            return false;
+        }
+        start = pos;
+        if (!skip_parenthesized(query, pos)) {
+            return false;
+        }
+        parsed.columns = query.substr(start, pos - start);
+
+        skip_spaces(query, pos);
+        if (!match_keyword(query, pos, "VALUES") && !match_keyword(query, pos, "VALUE")) {
+            return false;
+        }
+
+        skip_spaces(query, pos);
+        start = pos;
+        size_t end = pos;
+        while (true) {
+            if (pos >= query.size() || query[pos] != '(') {
+                return false;
+            }
+            if (!skip_parenthesized(query, pos)) {
+                return false;
+            }
+            end = pos;
+            skip_spaces(query, pos);
+            if (pos < query.size() && query[pos] == ',') {
+                ++pos;
+                skip_spaces(query, pos);
+                continue;
+            }
+            break;
+        }
+        parsed.values = query.substr(start, end - start);
+
+        std::string_view rest = trim_statement_end(query.substr(pos));
+        if (!rest.empty()) {
+            size_t suffix_pos = 0;
+            if (!match_keyword(rest, suffix_pos, "ON")) {
+                return false;
+            }
+            skip_spaces(rest, suffix_pos);
+            if (!match_keyword(rest, suffix_pos, "DUPLICATE")) {
+                return false;
+            }
+            skip_spaces(rest, suffix_pos);
+            if (!match_keyword(rest, suffix_pos, "KEY")) {
+                return false;
+            }
+            skip_spaces(rest, suffix_pos);
+            if (!match_keyword(rest, suffix_pos, "UPDATE")) {
+                return false;
+            }
+        }
+        if (has_statement_separator(rest)) {
+            return false;
+        }
+        parsed.suffix = rest;
+        return true;
+    }
+
+    std::string group_key(const ParsedInsert &parsed) {
+        std::string key;
+        key.reserve(parsed.table.size() + parsed.columns.size() + parsed.suffix.size() + 4);
+        key.push_back(static_cast<char>('0' + static_cast<int>(parsed.type)));
+        key.push_back('\x1f');
+        append_normalized(key, parsed.table);
+        key.push_back('\x1f');
+        append_normalized(key, parsed.columns);
+        key.push_back('\x1f');
+        key.append(parsed.suffix);
+        return key;
+    }
+
+    std::vector<std::string> rewrite_multi_row(const std::vector<std::string> &queries) {
+        std::vector<std::string> result;
+        rewrite_multi_row(queries, result);
+        return result;
+    }
+
+    void rewrite_multi_row(const std::vector<std::string> &queries, std::vector<std::string> &result,
+                           std::vector<size_t> *merged) {
+        struct Slot {
+            size_t first_query = 0;
+            ParsedInsert first;
+            size_t bytes = 0;
+            std::vector<std::string_view> values; ///< Empty for a statement passed through.
+        };
+
+        std::vector<Slot> slots;
+        slots.reserve(queries.size());
+        std::string open_key; ///< Group key of the last slot, empty when it cannot take more rows.
+
+        for (size_t i = 0; i < queries.size(); ++i) {
+            const std::string &query = queries[i];
+            if (query.empty()) {
+                continue;
+            }
+            ParsedInsert parsed;
+            if (!parse_insert(query, parsed)) {
+                slots.push_back({i, {}, 0, {}});
+                open_key.clear();
+                continue;
+            }
+            // Only consecutive rows are merged, so every statement still runs after all the ones queued before it
+            std::string key = group_key(parsed);
+            if (key != open_key) {
+                slots.push_back({i, parsed, 0, {}});
+                open_key = std::move(key);
+            }
+            Slot &slot = slots.back();
+            slot.values.push_back(parsed.values);
+            slot.bytes += parsed.values.size() + 1;
+        }
+
+        // Statements are written over the previous content of result, so its strings keep their capacity
+        result.resize(slots.size());
+        if (merged != nullptr) {
+            merged->clear();
+            for (const Slot &slot: slots) {
+                merged->push_back(slot.values.empty() ? 1 : slot.values.size());
+            }
+        }
+        for (size_t n = 0; n < slots.size(); ++n) {
+            const Slot &slot = slots[n];
+            std::string &statement = result[n];
+            if (slot.values.size() <= 1) {
+                statement.assign(queries[slot.first_query]);
+                continue;
+            }
+            const std::string_view head = insert_head(slot.first.type);
+            statement.clear();
+            statement.reserve(head.size() + slot.first.table.size() + slot.first.columns.size() +
+                              slot.first.suffix.size() + slot.bytes + 16);
+            statement.append(head);
+            statement.append(slot.first.table);
+            statement.push_back(' ');
+            statement.append(slot.first.columns);
+            statement.append(" VALUES ");
+            for (size_t i = 0; i < slot.values.size(); ++i) {
+                if (i > 0) {
+                    statement.push_back(',');
+                }
+                statement.append(slot.values[i]);
+            }
+            if (!slot.first.suffix.empty()) {
+                statement.push_back(' ');
+                statement.append(slot.first.suffix);
+            }
+            statement.push_back(';');
+        }
+    }
+
+    std::string wrap_transaction(const std::vector<std::string> &statements) {
+        std::string sql;
+        wrap_transaction(statements, sql);
+        return sql;
+    }
+
+    void wrap_transaction(const std::vector<std::string> &statements, std::string &sql) {
+        static constexpr std::string_view begin = "START TRANSACTION;";
+        static constexpr std::string_view commit = "COMMIT;";
+        size_t size = begin.size() + commit.size();
+        for (const auto &statement: statements) {
+            size += statement.size() + 1;
+        }
+        sql.clear();
+        sql.reserve(size);
+        sql.append(begin);
+        for (const auto &statement: statements) {
+            if (statement.empty()) {
+                continue;
+            }
+            sql.append(statement);
+            if (statement.back() != ';') {
+                sql.push_back(';');
+            }
+        }
+        sql.append(commit);
+    }
+
+}
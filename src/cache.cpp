@@ -0,0 +1,461 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+#include "simple_mariadb/cache.h"
+#include <algorithm>
+#include <cctype>
+
+namespace simple_mariadb::cache {
+
+    namespace {
+
+        struct Token {
+            std::string_view text;
+            bool word = false; ///< Identifier or keyword, possibly quoted with backticks and qualified with dots.
+        };
+
+        bool is_word_char(char c) {
+            return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '$';
+        }
+
+        /**
+         * Splits a statement into words and punctuation, skipping comments and string literals.
+         */
+        std::vector<Token> tokenize(std::string_view sql) {
+            std::vector<Token> tokens;
+            size_t i = 0;
+            const size_t n = sql.size();
+            while (i < n) {
+                const char c = sql[i];
+                if (std::isspace(static_cast<unsigned char>(c))) {
+                    ++i;
+                } else if (c == '#' || (c == '-' && i + 2 <= n && sql[i + 1] == '-' &&
+                                        (i + 2 == n || std::isspace(static_cast<unsigned char>(sql[i + 2]))))) {
+                    while (i < n && sql[i] != '\n') {
+                        ++i;
+                    }
+                } else if (c == '/' && i + 1 < n && sql[i + 1] == '*') {
+                    const size_t end = sql.find("*/", i + 2);
+                    i = end == std::string_view::npos ? n : end + 2;
+                } else if (c == '\'' || c == '"') {
+                    const size_t start = i++;
+                    while (i < n) {
+                        if (sql[i] == '\\') {
+                            i += 2;
+                        } else if (sql[i] == c) {
+                            if (i + 1 < n && sql[i + 1] == c) {
+                                i += 2;
+                            } else {
+                                ++i;
+                                break;
+                            }
+                        } else {
+                            ++i;
+                        }
+                    }
+                    tokens.push_back({sql.substr(start, std::min(i, n) - start), false});
+                } else if (is_word_char(c) || c == '`') {
+                    const size_t start = i;
+                    while (i < n) {
+                        if (sql[i] == '`') {
+                            ++i;
+                            while (i < n && !(sql[i] == '`' && (i + 1 == n || sql[i + 1] != '`'))) {
+                                i += sql[i] == '`' ? 2 : 1;
+                            }
+                            ++i;
+                        } else {
+                            while (i < n && is_word_char(sql[i])) {
+                                ++i;
+                            }
+                        }
+                        if (i + 1 < n && sql[i] == '.' && (is_word_char(sql[i + 1]) || sql[i + 1] == '`')) {
+                            ++i;
+                        } else {
+                            break;
+                        }
+                    }
+                    i = std::min(i, n);
+                    tokens.push_back({sql.substr(start, i - start), true});
+                } else {
+                    tokens.push_back({sql.substr(i, 1), false});
+                    ++i;
+                }
+            }
+            return tokens;
+        }
+
+        bool is(const std::vector<Token> &tokens, size_t i, std::string_view keyword) {
+            if (i >= tokens.size() || !tokens[i].word || tokens[i].text.size() != keyword.size()) {
+                return false;
+            }
+            return std::equal(keyword.begin(), keyword.end(), tokens[i].text.begin(), [](char k, char c) {
+                return k == std::toupper(static_cast<unsigned char>(c));
+            });
+        }
+
+        bool is_any(const std::vector<Token> &tokens, size_t i, std::initializer_list<std::string_view> keywords) {
+            return std::any_of(keywords.begin(), keywords.end(), [&](std::string_view k) { return is(tokens, i, k); });
+        }
+
+        bool is_clause(const std::vector<Token> &tokens, size_t i) {
+            return is_any(tokens, i, {"WHERE", "JOIN", "INNER", "LEFT", "RIGHT", "CROSS", "NATURAL", "STRAIGHT_JOIN",
+                                      "FULL", "OUTER", "ON", "USING", "GROUP", "ORDER", "LIMIT", "HAVING", "WINDOW",
+                                      "UNION", "EXCEPT", "INTERSECT", "FOR", "LOCK", "INTO", "SET", "PARTITION", "USE",
+                                      "IGNORE", "FORCE", "PROCEDURE", "RETURNING", "WITH", "VALUES", "SELECT", "TO"});
+        }
+
+        bool is_punct(const std::vector<Token> &tokens, size_t i, char c) {
+            return i < tokens.size() && !tokens[i].word && tokens[i].text.size() == 1 && tokens[i].text[0] == c;
+        }
+
+        /**
+         * Reads a comma separated list of tables with optional aliases starting at i.
+         * @return the index after the list.
+         */
+        size_t table_list(const std::vector<Token> &tokens, size_t i, std::vector<std::string> &tables) {
+            while (i < tokens.size() && tokens[i].word && !is_clause(tokens, i)) {
+                if (!is(tokens, i, "DUAL")) {
+                    tables.push_back(table_key(tokens[i].text));
+                }
+                ++i;
+                if (is(tokens, i, "AS")) {
+                    i += 2;
+                } else if (i < tokens.size() && tokens[i].word && !is_clause(tokens, i)) {
+                    ++i;
+                }
+                if (!is_punct(tokens, i, ',')) {
+                    break;
+                }
+                ++i;
+            }
+            return i;
+        }
+
+        size_t skip(const std::vector<Token> &tokens, size_t i, std::initializer_list<std::string_view> keywords) {
+            while (is_any(tokens, i, keywords)) {
+                ++i;
+            }
+            return i;
+        }
+
+        /**
+         * Unquoted lower case name before the first dot of a qualified identifier, empty if there is no dot.
+         */
+        std::string qualifier(std::string_view identifier) {
+            std::string name;
+            bool quoted = false;
+            for (size_t i = 0; i < identifier.size(); ++i) {
+                const char c = identifier[i];
+                if (c == '`') {
+                    quoted = !quoted;
+                } else if (c == '.' && !quoted) {
+                    return name;
+                } else {
+                    name.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(c))));
+                }
+            }
+            return {};
+        }
+
+        void add_read_tables(const std::vector<Token> &tokens, std::vector<std::string> &tables) {
+            for (size_t i = 0; i < tokens.size(); ++i) {
+                if (is_any(tokens, i, {"FROM", "JOIN", "STRAIGHT_JOIN"})) {
+                    table_list(tokens, i + 1, tables);
+                }
+            }
+        }
+
+        /**
+         * Adds the table named at i, if any.
+         */
+        void single_table(const std::vector<Token> &tokens, size_t i, std::vector<std::string> &tables) {
+            if (i < tokens.size() && tokens[i].word) {
+                tables.push_back(table_key(tokens[i].text));
+            }
+        }
+
+        Written all() {
+            return {Written::ALL, {}};
+        }
+
+        Written parse_written(const std::vector<Token> &tokens) {
+            Written written{Written::TABLES, {}};
+            auto &tables = written.tables;
+            if (is_any(tokens, 0, {"SELECT", "SHOW", "DESCRIBE", "DESC", "EXPLAIN", "SET", "USE", "BEGIN", "START",
+                                   "COMMIT", "ROLLBACK", "SAVEPOINT", "RELEASE", "DO", "HELP"})) {
+                return {Written::NONE, {}};
+            } else if (is_any(tokens, 0, {"INSERT", "REPLACE"})) {
+                const size_t i = skip(tokens, 1, {"LOW_PRIORITY", "DELAYED", "HIGH_PRIORITY", "IGNORE", "INTO"});
+                single_table(tokens, i, tables);
+            } else if (is(tokens, 0, "UPDATE")) {
+                table_list(tokens, skip(tokens, 1, {"LOW_PRIORITY", "IGNORE"}), tables);
+                add_read_tables(tokens, tables);
+            } else if (is(tokens, 0, "DELETE")) {
+                // The targets of a multi-table DELETE may be aliases, the tables they stand for are in FROM and JOIN.
+                const size_t i = skip(tokens, 1, {"LOW_PRIORITY", "QUICK", "IGNORE"});
+                if (!is(tokens, i, "FROM")) {
+                    table_list(tokens, i, tables);
+                }
+                add_read_tables(tokens, tables);
+            } else if (is(tokens, 0, "TRUNCATE")) {
+                single_table(tokens, skip(tokens, 1, {"TABLE"}), tables);
+            } else if (is(tokens, 0, "DROP") || is(tokens, 0, "CREATE") || is(tokens, 0, "ALTER")) {
+                size_t i = skip(tokens, 1, {"OR", "REPLACE", "TEMPORARY", "ONLINE", "IGNORE", "UNIQUE", "FULLTEXT",
+                                            "SPATIAL"});
+                if (is(tokens, i, "TABLE")) {
+                    i = skip(tokens, i + 1, {"IF", "NOT", "EXISTS"});
+                    if (is(tokens, 0, "DROP")) {
+                        table_list(tokens, i, tables);
+                    } else {
+                        single_table(tokens, i, tables);
+                    }
+                } else if (is(tokens, i, "INDEX")) {
+                    i = skip(tokens, i + 1, {"IF", "NOT", "EXISTS"});
+                    if (!is(tokens, i + 1, "ON")) {
+                        return all();
+                    }
+                    single_table(tokens, i + 2, tables);
+                } else {
+                    return all();
+                }
+            } else if (is(tokens, 0, "RENAME")) {
+                if (!is(tokens, 1, "TABLE")) {
+                    return all();
+                }
+                for (size_t i = 2; i < tokens.size(); ++i) {
+                    if (tokens[i].word && !is(tokens, i, "TO")) {
+                        tables.push_back(table_key(tokens[i].text));
+                    }
+                }
+            } else if (is(tokens, 0, "LOAD")) {
+                for (size_t i = 1; i + 2 < tokens.size(); ++i) {
+                    if (is(tokens, i, "INTO") && is(tokens, i + 1, "TABLE")) {
+                        single_table(tokens, i + 2, tables);
+                        break;
+                    }
+                }
+            } else {
+                return all();
+            }
+            if (tables.empty()) {
+                return all();
+            }
+            std::sort(tables.begin(), tables.end());
+            tables.erase(std::unique(tables.begin(), tables.end()), tables.end());
+            return written;
+        }
+
+    }
+
+    std::string table_key(std::string_view identifier) {
+        size_t start = 0;
+        bool quoted = false;
+        for (size_t i = 0; i < identifier.size(); ++i) {
+            if (identifier[i] == '`') {
+                quoted = !quoted;
+            } else if (identifier[i] == '.' && !quoted) {
+                start = i + 1;
+            }
+        }
+        std::string key;
+        key.reserve(identifier.size() - start);
+        for (size_t i = start; i < identifier.size(); ++i) {
+            const char c = identifier[i];
+            if (c == '`') {
+                if (i + 1 < identifier.size() && identifier[i + 1] == '`') {
+                    key.push_back('`');
+                    ++i;
+                }
+                continue;
+            }
+            key.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(c))));
+        }
+        return key;
+    }
+
+    std::vector<std::string> read_tables(std::string_view query) {
+        std::vector<std::string> tables;
+        add_read_tables(tokenize(query), tables);
+        std::sort(tables.begin(), tables.end());
+        tables.erase(std::unique(tables.begin(), tables.end()), tables.end());
+        return tables;
+    }
+
+    bool is_cacheable(std::string_view query) {
+        const auto tokens = tokenize(query);
+        if (!is(tokens, 0, "SELECT")) {
+            return false;
+        }
+        for (const auto &token: tokens) {
+            if (!token.word) {
+                continue;
+            }
+            const auto schema = qualifier(token.text);
+            // Server state, changed by DDL and grants that name no table of their own
+            if (schema == "information_schema" || schema == "performance_schema" || schema == "mysql") {
+                return false;
+            }
+        }
+        std::vector<std::string> tables;
+        add_read_tables(tokens, tables);
+        return !tables.empty();
+    }
+
+    Written written_tables(std::string_view statement) {
+        auto tokens = tokenize(statement);
+        while (!tokens.empty() && is_punct(tokens, tokens.size() - 1, ';')) {
+            tokens.pop_back();
+        }
+        if (tokens.empty()) {
+            return {Written::NONE, {}};
+        }
+        if (std::any_of(tokens.begin(), tokens.end(), [](const Token &t) { return !t.word && t.text == ";"; })) {
+            return all();
+        }
+        return parse_written(tokens);
+    }
+
+    nlohmann::json CacheStats::to_json() const {
+        nlohmann::json j;
+        j["size"] = size;
+        j["capacity"] = capacity;
+        j["hits"] = hits;
+        j["misses"] = misses;
+        j["evictions"] = evictions;
+        j["expirations"] = expirations;
+        j["invalidations"] = invalidations;
+        return j;
+    }
+
+    ResultCache::ResultCache(size_t capacity, std::chrono::milliseconds ttl) : m_capacity(capacity), m_ttl(ttl) {}
+
+    std::shared_ptr<const CachedResult> ResultCache::get(const std::string &key) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto found = m_index.find(key);
+        if (found == m_index.end()) {
+            ++m_stats.misses;
+            return nullptr;
+        }
+        auto it = found->second;
+        if (std::chrono::steady_clock::now() >= it->expires) {
+            m_erase(it);
+            ++m_stats.expirations;
+            ++m_stats.misses;
+            return nullptr;
+        }
+        m_lru.splice(m_lru.begin(), m_lru, it);
+        ++m_stats.hits;
+        return it->value;
+    }
+
+    uint64_t ResultCache::now() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_clock;
+    }
+
+    void ResultCache::put(const std::string &key, const std::vector<std::string> &tables, CachedResult value,
+                          uint64_t started) {
+        if (m_capacity == 0) {
+            return;
+        }
+        auto shared = std::make_shared<const CachedResult>(std::move(value));
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_cleared_at > started) {
+            return;
+        }
+        for (const auto &table: tables) {
+            auto at = m_invalidated_at.find(table);
+            if (at != m_invalidated_at.end() && at->second > started) {
+                return;
+            }
+        }
+        auto found = m_index.find(key);
+        if (found != m_index.end()) {
+            m_erase(found->second);
+        }
+        while (m_lru.size() >= m_capacity) {
+            m_erase(std::prev(m_lru.end()));
+            ++m_stats.evictions;
+        }
+        m_lru.push_front({key, tables, std::move(shared), std::chrono::steady_clock::now() + m_ttl});
+        m_index.emplace(key, m_lru.begin());
+        for (const auto &table: tables) {
+            m_by_table[table].insert(key);
+        }
+    }
+
+    void ResultCache::invalidate(std::string_view statement) {
+        const auto written = written_tables(statement);
+        if (written.scope == Written::NONE) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (written.scope == Written::ALL) {
+            m_clear();
+            return;
+        }
+        for (const auto &table: written.tables) {
+            m_invalidate_table(table);
+        }
+    }
+
+    void ResultCache::invalidate_table(std::string_view table) {
+        const auto key = table_key(table);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_invalidate_table(key);
+    }
+
+    void ResultCache::clear() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_clear();
+    }
+
+    CacheStats ResultCache::get_stats() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        CacheStats stats = m_stats;
+        stats.size = m_lru.size();
+        stats.capacity = m_capacity;
+        return stats;
+    }
+
+    void ResultCache::m_erase(Iterator it) {
+        for (const auto &table: it->tables) {
+            auto keys = m_by_table.find(table);
+            if (keys != m_by_table.end()) {
+                keys->second.erase(it->key);
+                if (keys->second.empty()) {
+                    m_by_table.erase(keys);
+                }
+            }
+        }
+        m_index.erase(it->key);
+        m_lru.erase(it);
+    }
+
+    void ResultCache::m_invalidate_table(const std::string &table) {
+        m_invalidated_at[table] = ++m_clock;
+        auto keys = m_by_table.find(table);
+        if (keys == m_by_table.end()) {
+            return;
+        }
+        const auto stale = keys->second;
+        for (const auto &key: stale) {
+            auto found = m_index.find(key);
+            if (found != m_index.end()) {
+                m_erase(found->second);
+                ++m_stats.invalidations;
+            }
+        }
+    }
+
+    void ResultCache::m_clear() {
+        m_cleared_at = ++m_clock;
+        m_invalidated_at.clear();
+        m_stats.invalidations += m_lru.size();
+        m_lru.clear();
+        m_index.clear();
+        m_by_table.clear();
+    }
+
+}
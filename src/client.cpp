@@ -8,32 +8,126 @@ namespace simple_mariadb::client {
 
     MariaDBManager::MariaDBManager(simple_mariadb::config::MariaDBConfig &config) :
             m_config(config),
-            m_queue_thread(&MariaDBManager::run, this),
             m_checker_thread(&MariaDBManager::m_run_checker, this) {
         if (!m_config.validate()) {
             this->m_join_threads();
             m_logger->send<simple_logger::LogLevel::ERROR>("MariaDBConfig is not valid");
             throw std::runtime_error("MariaDBConfig is not valid");
         }
+        try {
+            m_retry = std::make_unique<simple_mariadb::retry::Retrier>(
+                    simple_mariadb::retry::Policy{m_config.retry_max_attempts,
+                                                  std::chrono::milliseconds(m_config.retry_backoff_ms),
+                                                  std::chrono::milliseconds(m_config.retry_max_backoff_ms)},
+                    m_config.dead_letter_path);
+        } catch (std::exception &e) {
+            this->m_join_threads();
+            m_logger->send<simple_logger::LogLevel::ERROR>(e.what());
+            throw;
+        }
+        this->set_dead_letter_callback(nullptr);
+        if (!m_config.spill_dir.empty()) {
+            try {
+                m_spill = std::make_unique<simple_mariadb::spill::SegmentLog>(
+                        m_config.spill_dir, m_config.spill_segment_size, m_config.spill_max_bytes);
+            } catch (std::exception &e) {
+                this->m_join_threads();
+                m_logger->send<simple_logger::LogLevel::ERROR>(e.what());
+                throw;
+            }
+            if (m_spill->pending() > 0) {
+                m_logger->send<simple_logger::LogLevel::INFORMATIONAL>(
+                        "Recovered " + std::to_string(m_spill->pending()) + " spilled statements from " +
+                        m_config.spill_dir);
+            }
+            // Writes given up on after transient failures are kept for a later replay rather than dropped
+            m_retry->set_fallback([this](const std::string &query) { return this->m_spill_query(query); });
+        }
 
         {
             std::lock_guard<std::mutex> lock(m_write_mutex);
             this->m_get_connection(m_conn_write);
         }
-        {
-            std::lock_guard<std::mutex> lock(m_read_mutex);
-            this->m_get_connection(m_conn_read);
-        }
+        m_read_pool = std::make_unique<simple_mariadb::pool::ConnectionPool>(
+                m_config.read_pool_size, m_config.read_pool_max,
+                std::chrono::milliseconds(m_config.read_pool_timeout_ms),
+                [this]() {
+                    std::shared_ptr<sql::Connection> conn;
+                    this->m_get_connection(conn);
+                    return conn;
+                },
+                [this](std::shared_ptr<sql::Connection> &conn) { return this->m_is_connected(conn); },
+                m_config.statement_cache_size);
         if (!this->is_connected()) {
+            this->m_join_threads();
             throw std::runtime_error("MariaDBManager failed to connect to database");
         }
+        if (m_config.query_cache_size > 0) {
+            m_cache = std::make_unique<simple_mariadb::cache::ResultCache>(
+                    m_config.query_cache_size, std::chrono::milliseconds(m_config.query_cache_ttl_ms));
+        }
+        if (m_config.engine == "nonblocking") {
+            try {
+                m_engine = std::make_unique<simple_mariadb::engine::Engine>(m_config, m_config.engine_connections);
+            } catch (std::exception &e) {
+                this->m_join_threads();
+                m_logger->send<simple_logger::LogLevel::ERROR>(e.what());
+                throw;
+            }
+        }
+        this->m_start_writers();
+    }
+
+    void MariaDBManager::m_start_writers() {
+        m_queue_thread_is_running = true;
+        // The engine keeps its connections busy from one thread, a single writer is enough to feed it
+        const size_t writers = m_engine ? 1 : m_config.writer_threads;
+        m_writers.reserve(writers);
+        for (size_t i = 0; i < writers; ++i) {
+            auto writer = std::make_unique<Writer>();
+            writer->id = i;
+            writer->statements = std::make_unique<simple_mariadb::statement::StatementCache>(
+                    m_config.statement_cache_size);
+            m_writers.push_back(std::move(writer));
+        }
+        // Threads are started once the vector is complete so no writer observes a reallocation
+        for (auto &writer: m_writers) {
+            if (m_engine) {
+                writer->thread = std::thread(&MariaDBManager::m_run_engine_writer, this, std::ref(*writer));
+            } else {
+                writer->thread = std::thread(&MariaDBManager::m_run_writer, this, std::ref(*writer));
+            }
+        }
+
+        m_row_writer = std::make_unique<Writer>();
+        m_row_writer->id = m_config.writer_threads;
+        m_row_writer->statements = std::make_unique<simple_mariadb::statement::StatementCache>(
+                m_config.statement_cache_size);
+        m_rows_running = true;
+        m_row_writer->thread = std::thread(&MariaDBManager::m_run_row_writer, this);
+
+        if (m_spill) {
+            m_spill_writer = std::make_unique<Writer>();
+            m_spill_writer->id = m_config.writer_threads + 1;
+            m_spill_writer->statements = std::make_unique<simple_mariadb::statement::StatementCache>(
+                    m_config.statement_cache_size);
+            m_spill_writer->thread = std::thread(&MariaDBManager::m_run_spill_writer, this);
+        }
+
+        m_retry_writer = std::make_unique<Writer>();
+        m_retry_writer->id = m_config.writer_threads + 2;
+        m_retry_writer->statements = std::make_unique<simple_mariadb::statement::StatementCache>(
+                m_config.statement_cache_size);
+        m_retry_running = true;
+        m_retry_writer->thread = std::thread(&MariaDBManager::m_run_retry_writer, this);
     }
 
     bool MariaDBManager::m_is_connected(std::shared_ptr<sql::Connection> &conn) {
         if (conn != nullptr) {
             if (conn->isClosed()) {
-                m_logger->send<simple_logger::LogLevel::DEBUG>(
-                        "Connection is not open on host: " + std::string(conn->getHostname()));
+                m_log.send<simple_logger::LogLevel::DEBUG>([&]() {
+                    return "Connection is not open on host: " + std::string(conn->getHostname());
+                });
                 return false;
             }
         } else {
@@ -47,14 +141,17 @@ namespace simple_mariadb::client {
             return;
         }
         try {
+            const auto start = std::chrono::steady_clock::now();
             sql::SQLString url(m_config.uri);
             sql::Properties properties(m_config.get_options());
             conn = std::shared_ptr<sql::Connection>(m_driver->connect(url, properties));
 
             if (this->m_is_connected(conn)) {
-                m_logger->send<simple_logger::LogLevel::DEBUG>(
-                        "MariaDB is now connected to: " + std::string(conn->getHostname())
-                        + " with network timeout: " + std::to_string(conn->getNetworkTimeout()));
+                m_metrics.connect.record_since(start);
+                m_log.send<simple_logger::LogLevel::DEBUG>([&]() {
+                    return "MariaDB is now connected to: " + std::string(conn->getHostname())
+                           + " with network timeout: " + std::to_string(conn->getNetworkTimeout());
+                });
                 return;
             }
         } catch (sql::SQLException &e) {
@@ -70,43 +167,239 @@ namespace simple_mariadb::client {
     void MariaDBManager::m_join_threads() {
         if (m_checker_thread_is_running or m_queue_thread_is_running)
             this->stop();
-        if (m_queue_thread.joinable()) {
-            m_queue_thread.join();
+        for (auto &writer: m_writers) {
+            if (writer->thread.joinable()) {
+                writer->thread.join();
+            }
+        }
+        if (m_row_writer && m_row_writer->thread.joinable()) {
+            m_row_writer->thread.join();
+        }
+        if (m_spill_writer && m_spill_writer->thread.joinable()) {
+            m_spill_writer->thread.join();
+        }
+        if (m_retry_writer && m_retry_writer->thread.joinable()) {
+            m_retry_writer->thread.join();
         }
         if (m_checker_thread.joinable()) {
             m_checker_thread.join();
         }
+        if (m_engine) {
+            m_engine->stop(); // after the writers, they wait for what they submitted
+        }
+        simple_mariadb::executor::Executor *async = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(m_async_mutex);
+            async = m_async.get();
+        }
+        if (async) {
+            async->stop(); // runs the queued reads while the read pool is still there
+        }
+        if (m_retry) {
+            m_retry->flush(); // failures reported after the retry writer left
+        }
     }
 
     std::vector<std::map<std::string, std::string>> MariaDBManager::select(const std::string &query) {
-        // use this->query_to_json and convert json to vector of maps
+        if (m_cache) {
+            return this->m_cached<std::vector<std::map<std::string, std::string>>>(
+                    's', query, [this, &query]() { return this->m_select(query); });
+        }
+        return this->m_select(query);
+    }
 
+    std::vector<std::map<std::string, std::string>> MariaDBManager::m_select(const std::string &query) {
         std::vector<std::map<std::string, std::string>> result;
-        json json_result = this->query_to_json(query);
-        result.reserve(json_result.size());
-        for (auto &row: json_result) {
+        auto cursor = this->open_cursor(query);
+        std::vector<std::string> names;
+        if (auto meta = cursor.meta()) {
+            names.reserve(meta->getColumnCount());
+            for (uint32_t i = 1; i <= meta->getColumnCount(); ++i) {
+                names.emplace_back(meta->getColumnName(i));
+            }
+        }
+        while (cursor.next()) {
+            auto &row = cursor.row();
             std::map<std::string, std::string> map_row;
-            for (auto &column: row.items()) {
-                map_row[column.key()] = column.value();
+            for (size_t i = 0; i < names.size(); ++i) {
+                map_row.emplace(names[i], std::string(row.getString(static_cast<int32_t>(i + 1))));
             }
-            result.push_back(map_row);
+            result.push_back(std::move(map_row));
         }
         return result;
     }
 
+    size_t MariaDBManager::select(const std::string &query, simple_mariadb::table::ResultTable &result) {
+        auto cursor = this->open_cursor(query);
+        std::vector<std::string> names;
+        if (auto meta = cursor.meta()) {
+            names.reserve(meta->getColumnCount());
+            for (uint32_t i = 1; i <= meta->getColumnCount(); ++i) {
+                names.emplace_back(meta->getColumnName(i));
+            }
+        }
+        const auto count = static_cast<int32_t>(names.size());
+        result.reset(std::move(names));
+        while (cursor.next()) {
+            auto &row = cursor.row();
+            for (int32_t i = 1; i <= count; ++i) {
+                const sql::SQLString value = row.getString(i);
+                if (row.wasNull()) {
+                    result.append_null();
+                } else {
+                    result.append(std::string_view(value.c_str(), value.length()));
+                }
+            }
+        }
+        return result.rows();
+    }
+
     bool MariaDBManager::enqueue(const std::string &query, bool check_correctness) {
         if (query.empty()) {
             return true;
         }
-        if (!check_correctness) {
-            return m_queries.enqueue(query);
+        return this->m_accept(query, check_correctness) && this->m_push(std::string(query));
+    }
+
+    bool MariaDBManager::enqueue(std::string &&query, bool check_correctness) {
+        if (query.empty()) {
+            return true;
+        }
+        return this->m_accept(query, check_correctness) && this->m_push(std::move(query));
+    }
+
+    bool MariaDBManager::enqueue(std::string_view query, bool check_correctness) {
+        if (query.empty()) {
+            return true;
+        }
+        return this->m_accept(query, check_correctness) && this->m_push(std::string(query));
+    }
+
+    bool MariaDBManager::enqueue(const char *query, bool check_correctness) {
+        return this->enqueue(std::string_view(query == nullptr ? "" : query), check_correctness);
+    }
+
+    bool MariaDBManager::m_accept(std::string_view query, bool check_correctness) {
+        if (check_correctness && !simple_mariadb::batch::is_insert_or_replace(query)) {
+            m_query_log.send<simple_logger::LogLevel::ERROR>(query, [](const std::string &shown) {
+                return "Enqueuing Error: query is not correct: <" + shown + ">";
+            });
+            return false;
         }
-        if (::common::sql_utils::is_insert_or_replace_query_correct(query)) {
-            return m_queries.enqueue(query);
+        this->m_invalidate(query);
+        return true;
+    }
+
+    bool MariaDBManager::m_push(std::string &&query) {
+        // Spill instead of waiting for room, the log keeps what the memory queue cannot hold. Once something is
+        // spilled new statements follow it there until it is replayed, so they never overtake older ones
+        if (m_spill && (m_writers_down > 0 || m_queries.size() >= m_config.queue_size || m_spill->pending() > 0)) {
+            return this->m_spill_query(query);
+        }
+        if (!m_spill) {
+            return m_queries.enqueue(std::move(query));
+        }
+        // The queue consumes what it is given, a copy keeps the statement for the spill log if it is refused
+        return m_queries.enqueue(static_cast<const std::string &>(query)) || this->m_spill_query(query);
+    }
+
+    size_t MariaDBManager::m_publish(std::vector<std::string> &queries) {
+        size_t queued = 0;
+        if (m_spill) { // one by one, so the spill log takes what the queue cannot hold
+            for (auto &query: queries) {
+                queued += this->m_push(std::move(query)) ? 1 : 0;
+            }
         } else {
-            m_logger->send<simple_logger::LogLevel::ERROR>("Query is not correct: <" + query + ">");
+            queued = m_queries.enqueue_bulk(queries);
+        }
+        if (queued < queries.size()) {
+            m_logger->send<simple_logger::LogLevel::ERROR>(
+                    "Enqueuing Error: " + std::to_string(queries.size() - queued) + " of " +
+                    std::to_string(queries.size()) + " staged statements were not queued");
         }
-        m_logger->send<simple_logger::LogLevel::ERROR>("Enqueuing Error: " + query);
+        queries.clear();
+        return queued;
+    }
+
+    Producer MariaDBManager::make_producer(size_t max_rows, std::chrono::milliseconds linger) {
+        return {*this, std::clamp<size_t>(max_rows, 1, std::max<size_t>(m_config.queue_size, 1)), linger};
+    }
+
+    Producer::Producer(MariaDBManager &manager, size_t max_rows, std::chrono::milliseconds linger) :
+            m_manager(&manager), m_max_rows(max_rows), m_linger(linger) {
+        m_buffer.reserve(m_max_rows);
+    }
+
+    Producer::Producer(Producer &&other) noexcept:
+            m_manager(std::exchange(other.m_manager, nullptr)),
+            m_max_rows(other.m_max_rows),
+            m_linger(other.m_linger),
+            m_first(other.m_first),
+            m_buffer(std::move(other.m_buffer)) {}
+
+    Producer &Producer::operator=(Producer &&other) noexcept {
+        if (this != &other) {
+            this->flush();
+            m_manager = std::exchange(other.m_manager, nullptr);
+            m_max_rows = other.m_max_rows;
+            m_linger = other.m_linger;
+            m_first = other.m_first;
+            m_buffer = std::move(other.m_buffer);
+        }
+        return *this;
+    }
+
+    Producer::~Producer() {
+        this->flush();
+    }
+
+    bool Producer::enqueue(const std::string &query, bool check_correctness) {
+        if (m_manager == nullptr) { // moved from
+            return false;
+        }
+        if (query.empty()) {
+            return true;
+        }
+        return m_manager->m_accept(query, check_correctness) && this->m_stage(std::string(query));
+    }
+
+    bool Producer::enqueue(std::string &&query, bool check_correctness) {
+        if (m_manager == nullptr) { // moved from
+            return false;
+        }
+        if (query.empty()) {
+            return true;
+        }
+        return m_manager->m_accept(query, check_correctness) && this->m_stage(std::move(query));
+    }
+
+    bool Producer::m_stage(std::string &&query) {
+        const auto now = std::chrono::steady_clock::now();
+        if (m_buffer.empty()) {
+            m_first = now;
+        }
+        m_buffer.push_back(std::move(query));
+        if (m_buffer.size() >= m_max_rows || now - m_first >= m_linger) {
+            return this->flush();
+        }
+        return true;
+    }
+
+    bool Producer::flush() {
+        if (m_manager == nullptr || m_buffer.empty()) {
+            return true;
+        }
+        const size_t staged = m_buffer.size();
+        return m_manager->m_publish(m_buffer) == staged;
+    }
+
+    bool MariaDBManager::m_spill_query(const std::string &query) {
+        if (m_spill->append(query)) {
+            return true;
+        }
+        m_query_log.send<simple_logger::LogLevel::ERROR>(query, [](const std::string &shown) {
+            return "Spill Error: log is full or the query is too large: " + shown;
+        });
         return false;
     }
 
@@ -119,63 +412,541 @@ namespace simple_mariadb::client {
         if (force) {
             m_queue_thread_is_running = false;
             std::string wipe_out_queries;
+            if (m_spill) { // keep the queued statements for the next start
+                while (m_queries.size() > 0 && m_queries.dequeue_blocking(wipe_out_queries)) {
+                    this->m_spill_query(wipe_out_queries);
+                }
+            }
             m_queries.wipeout();
+            m_rows.wipeout();
+            m_rows_running = false;
+            m_rows.notify();
+            m_retry_forced = true;
+            m_retry_running = false;
+            if (m_retry) {
+                m_retry->stop();
+            }
             return;
         }
         while (m_queries.size() > 0) {
             std::this_thread::sleep_for(std::chrono::milliseconds(100));
         }
+        // Writers finish the batch they hold before leaving their loop, join them so nothing is in flight
         m_queue_thread_is_running = false;
+        for (auto &writer: m_writers) {
+            if (writer->thread.joinable() && writer->thread.get_id() != std::this_thread::get_id()) {
+                writer->thread.join();
+            }
+        }
+        // The row writer drains the buffered rows before it leaves its loop
+        m_rows_running = false;
+        m_rows.notify();
+        if (m_row_writer && m_row_writer->thread.joinable()) {
+            m_row_writer->thread.join();
+        }
+        // What the spill writer did not replay yet stays on disk for the next start
+        if (m_spill_writer && m_spill_writer->thread.joinable()) {
+            m_spill_writer->thread.join();
+        }
+        // Retries stop last, every writer above may have handed it failures. It gives the pending ones a last try
+        m_retry_running = false;
+        if (m_retry) {
+            m_retry->stop();
+        }
+        if (m_retry_writer && m_retry_writer->thread.joinable()) {
+            m_retry_writer->thread.join();
+        }
     }
 
     void MariaDBManager::run() {
+        // The writer threads own their Writer, driving one of them from here as well would race with its thread
+    }
+
+    void MariaDBManager::m_run_engine_writer(Writer &writer) {
+        std::vector<std::string> &queries = writer.batch;
+        queries.reserve(m_config.batch_max_rows);
+        while (m_queue_thread_is_running) {
+            queries.clear();
+            if (m_multi_insert) {
+                this->m_form_batch(writer, queries);
+            } else {
+                std::string query = m_dequeue();
+                if (!query.empty()) {
+                    queries.push_back(std::move(query));
+                }
+            }
+            this->m_submit_batch(writer, queries);
+        }
+        if (!writer.carry.empty()) { // held back by the byte limit when the writer was stopped
+            queries.clear();
+            queries.push_back(std::move(writer.carry));
+            writer.carry.clear();
+            this->m_submit_batch(writer, queries);
+        }
+        m_engine->wait_idle();
+    }
+
+    void MariaDBManager::m_submit_batch(Writer &writer, std::vector<std::string> &queries) {
+        if (queries.empty()) {
+            return;
+        }
+        // Statements run one per connection, so a batch is not wrapped in a transaction; merging rows into
+        // multi-row INSERTs still cuts the round trips. The statements of a table are routed to the same connection
+        // and keep the order they were queued in; the ones without a known table share connection 0
+        const bool multi_row = m_multi_insert && m_multi_row_insert;
+        if (multi_row) {
+            simple_mariadb::batch::rewrite_multi_row(queries, writer.rewritten, &writer.merged);
+            writer.batches++;
+        }
+        m_metrics.batch_rows.record(queries.size());
+        const size_t in_flight = 2 * m_config.engine_connections; // the next statements wait next to the socket
+        auto &statements = multi_row ? writer.rewritten : queries;
+        for (size_t n = 0; n < statements.size(); ++n) {
+            auto &statement = statements[n];
+            // Counted in queued statements, like the threads writers do, however many of them were merged
+            const size_t rows = multi_row ? writer.merged[n] : 1;
+            m_engine->wait_below(in_flight);
+            // The callback keeps a copy for the log and the cache, the engine takes the statement itself
+            auto callback = [this, &writer, statement, rows](simple_mariadb::engine::Result &&result) {
+                if (result.ok) {
+                    writer.executed += rows;
+                    m_metrics.rows.add(rows);
+                    this->m_invalidate(statement);
+                    return;
+                }
+                writer.failed += rows;
+                m_error_counter++;
+                m_query_log.send<simple_logger::LogLevel::ERROR>(statement, [&result](const std::string &shown) {
+                    return std::to_string(result.error_code) + " INSERT failed: " + result.error + " QUERY: <" +
+                           shown + ">";
+                });
+                // The engine reports no SQLSTATE, the error code alone classifies the failure
+                m_retry->fail(statement, 1, {static_cast<int>(result.error_code), {}, std::move(result.error)});
+            };
+            const auto written = simple_mariadb::cache::written_tables(statement);
+            const size_t key = written.scope == simple_mariadb::cache::Written::TABLES && !written.tables.empty()
+                               ? std::hash<std::string>{}(written.tables.front()) : 0;
+            // A rewritten statement is copied so the recycled buffer keeps its capacity, a dequeued one is handed over
+            m_engine->submit(multi_row ? std::string(statement) : std::move(statement), std::move(callback), key);
+        }
+    }
+
+    void MariaDBManager::m_run_writer(Writer &writer) {
         {
-            std::lock_guard<std::mutex> lock(m_write_mutex);
-            this->m_get_connection(m_conn_write);
+            std::lock_guard<std::mutex> lock(writer.mutex);
+            this->m_reconnect(writer);
         }
-        m_queue_thread_is_running = true;
+        this->m_load_max_allowed_packet(writer);
         while (m_queue_thread_is_running) {
-            if (!m_is_connected(m_conn_write)) {
+            if (!m_is_connected(writer.conn)) {
                 m_logger->send<simple_logger::LogLevel::INFORMATIONAL>(
-                        "Thread Connection to database failed: " + m_config.uri);
+                        "Writer " + std::to_string(writer.id) + " connection to database failed: " + m_config.uri);
+                this->m_set_down(writer, true);
                 // sleep for 1 second
                 std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-                m_get_connection(m_conn_write);
+                writer.reconnects++;
+                {
+                    std::lock_guard<std::mutex> lock(writer.mutex);
+                    this->m_reconnect(writer);
+                }
+                this->m_load_max_allowed_packet(writer);
+                continue;
             }
+            this->m_set_down(writer, false); // reconnected here or by the checker
             if (m_multi_insert) {
-                std::vector<std::string> queries;
-                while (m_queries.size() > 0) {
-                    m_logger->send<simple_logger::LogLevel::DEBUG>("Queue size: " + std::to_string(m_queries.size()));
-                    queries.push_back(m_dequeue());
+                writer.batch.clear();
+                this->m_form_batch(writer, writer.batch);
+                this->m_write_batch(writer, writer.batch);
+            } else {
+                std::string query = m_dequeue();
+                simple_mariadb::retry::Failure failure;
+                if (!query.empty() && !m_insert(writer, query, &failure)) {
+                    m_retry->fail(std::move(query), 1, std::move(failure));
                 }
-                if (!queries.empty()) {
-                    if (!m_insert_multi(queries)) { // if insert fails, try individual m_insert
-                        for (auto &query: queries) {
-                            if (!m_insert(query)) // if m_insert fails, log error and discard query
-                                m_logger->send<simple_logger::LogLevel::ERROR>(
-                                        "DISCARD QUERY: " + query);
-                        }
-                    }
+            }
+        }
+        if (!writer.carry.empty()) { // held back by the byte limit when the writer was stopped
+            writer.batch.clear();
+            writer.batch.push_back(std::move(writer.carry));
+            writer.carry.clear();
+            this->m_write_batch(writer, writer.batch);
+        }
+    }
+
+    void MariaDBManager::m_form_batch(Writer &writer, std::vector<std::string> &queries) {
+        const size_t max_rows = m_config.batch_max_rows;
+        const size_t max_bytes = this->m_batch_max_bytes();
+        size_t bytes = 0;
+
+        if (!writer.carry.empty()) {
+            bytes += writer.carry.size() + 1;
+            queries.push_back(std::move(writer.carry));
+            writer.carry.clear();
+        } else {
+            std::string first = m_dequeue(); // blocks until there is work or the queue timeout expires
+            if (first.empty()) {
+                return;
+            }
+            bytes += first.size() + 1;
+            queries.push_back(std::move(first));
+        }
+
+        // Under light traffic wait up to the linger time for more rows, a full batch is sent right away
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(m_config.batch_linger_ms);
+        while (queries.size() < max_rows) {
+            // Bounded by the linger deadline: another writer may take what is queued, this one must not wait for
+            // the whole queue timeout then
+            const auto now = std::chrono::steady_clock::now();
+            const auto left = m_queue_thread_is_running && now < deadline
+                              ? std::chrono::ceil<std::chrono::milliseconds>(deadline - now)
+                              : std::chrono::milliseconds(0);
+            std::string query;
+            if (!m_queries.dequeue_for(query, left)) {
+                break;
+            }
+            if (query.empty()) {
+                continue;
+            }
+            if (bytes + query.size() + 1 > max_bytes) {
+                writer.carry = std::move(query);
+                break;
+            }
+            bytes += query.size() + 1;
+            queries.push_back(std::move(query));
+        }
+    }
+
+    void MariaDBManager::m_write_batch(Writer &writer, const std::vector<std::string> &queries) {
+        if (queries.empty()) {
+            return;
+        }
+        if (!m_insert_multi(writer, queries)) { // if insert fails, try individual m_insert
+            for (auto &query: queries) {
+                simple_mariadb::retry::Failure failure;
+                if (!m_insert(writer, query, &failure)) {
+                    m_retry->fail(query, 1, std::move(failure));
                 }
+            }
+        }
+    }
+
+    bool MariaDBManager::m_enqueue_row(const std::string &table, const std::vector<std::string> &columns,
+                                       std::vector<simple_mariadb::rows::Value> &&values) {
+        if (!m_rows_running) {
+            m_logger->send<simple_logger::LogLevel::ERROR>("Enqueuing row Error: row writer is stopped, table: " + table);
+            return false;
+        }
+        if (values.size() != columns.size()) {
+            m_logger->send<simple_logger::LogLevel::ERROR>(
+                    "Enqueuing row Error: " + std::to_string(values.size()) + " values for " +
+                    std::to_string(columns.size()) + " columns, table: " + table);
+            return false;
+        }
+        if (!m_rows.add(table, columns, std::move(values))) {
+            m_logger->send<simple_logger::LogLevel::ERROR>("Enqueuing row Error: row buffer is full, table: " + table);
+            return false;
+        }
+        this->m_invalidate_table(table);
+        return true;
+    }
+
+    void MariaDBManager::flush_rows() {
+        m_rows.flush();
+        while (m_rows_running && m_rows.pending_rows() > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+
+    size_t MariaDBManager::pending_rows() {
+        return m_rows.pending_rows();
+    }
+
+    simple_mariadb::loader::LoadStats MariaDBManager::load_data(const std::string &table,
+                                                                const std::vector<std::string> &columns,
+                                                                const simple_mariadb::loader::RowSource &source,
+                                                                simple_mariadb::loader::InsertType type) {
+        try {
+            auto stats = simple_mariadb::loader::load_data(m_config, table, columns, source,
+                                                           m_config.load_chunk_size, type);
+            this->m_invalidate_table(table);
+            m_logger->send<simple_logger::LogLevel::INFORMATIONAL>(
+                    "Loaded " + std::to_string(stats.rows) + " rows (" + std::to_string(stats.bytes) +
+                    " bytes) into " + table + ": " + std::to_string(static_cast<size_t>(stats.rows_per_second())) +
+                    " rows/s, " + std::to_string(static_cast<size_t>(stats.bytes_per_second())) + " bytes/s");
+            return stats;
+        } catch (std::exception &e) {
+            m_error_counter++;
+            m_logger->send<simple_logger::LogLevel::ERROR>("Load data Error: " + std::string(e.what()));
+            throw;
+        }
+    }
+
+    simple_mariadb::loader::LoadStats MariaDBManager::load_data(const std::string &table,
+                                                                const std::vector<std::string> &columns,
+                                                                const std::vector<std::vector<simple_mariadb::rows::Value>> &rows,
+                                                                simple_mariadb::loader::InsertType type) {
+        size_t next = 0;
+        return this->load_data(table, columns, [&rows, &next](std::vector<simple_mariadb::rows::Value> &row) {
+            if (next == rows.size()) {
+                return false;
+            }
+            row = rows[next++];
+            return true;
+        }, type);
+    }
+
+    void MariaDBManager::m_reconnect(Writer &writer) {
+        this->m_get_connection(writer.conn);
+        // isClosed() does not hit the network, it only reports what the connector already knows
+        writer.connected = writer.conn != nullptr && !writer.conn->isClosed();
+    }
+
+    void MariaDBManager::m_set_down(Writer &writer, bool down) {
+        writer.connected = !down;
+        if (writer.down.exchange(down) != down) {
+            if (down) {
+                m_writers_down++;
             } else {
-                std::string query = m_dequeue();
-                if (!query.empty()) {
-                    if (!m_insert(query)) // if m_insert fails, enqueue again
-                        enqueue(query);
+                m_writers_down--;
+            }
+        }
+    }
+
+    void MariaDBManager::m_run_spill_writer() {
+        Writer &writer = *m_spill_writer;
+        {
+            std::lock_guard<std::mutex> lock(writer.mutex);
+            this->m_reconnect(writer);
+        }
+        const size_t rate = m_config.spill_replay_rate;
+        const size_t max_rows = rate == 0 ? m_config.batch_max_rows : std::min(m_config.batch_max_rows, rate);
+        auto next = std::chrono::steady_clock::now();
+        std::vector<std::string> queries;
+        while (m_queue_thread_is_running) {
+            // Older statements still in the memory queue go first, the spilled ones are newer
+            if (m_writers_down > 0 || m_spill->pending() == 0 || m_queries.size() > 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                continue;
+            }
+            if (!m_is_connected(writer.conn)) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+                writer.reconnects++;
+                std::lock_guard<std::mutex> lock(writer.mutex);
+                this->m_reconnect(writer);
+                continue;
+            }
+            // Replay at most spill_replay_rate statements per second so live writes keep their share
+            std::this_thread::sleep_until(next);
+            queries.clear();
+            m_spill->peek(max_rows, queries);
+            const size_t max_bytes = this->m_batch_max_bytes();
+            size_t bytes = 0;
+            for (size_t i = 0; i < queries.size(); ++i) {
+                bytes += queries[i].size() + 1;
+                if (i > 0 && bytes > max_bytes) {
+                    queries.resize(i);
+                    break;
+                }
+            }
+            size_t replayed = this->m_replay(writer, queries);
+            m_spill->commit(replayed);
+            if (rate > 0) {
+                next = std::max(next, std::chrono::steady_clock::now()) +
+                       std::chrono::microseconds(queries.size() * 1000000 / rate);
+            }
+        }
+    }
+
+    size_t MariaDBManager::m_replay(Writer &writer, const std::vector<std::string> &queries) {
+        if (queries.empty() || m_insert_multi(writer, queries)) {
+            return queries.size();
+        }
+        // Statements are committed once the server answered for them: written or rejected for good
+        size_t replayed = 0;
+        for (const auto &query: queries) {
+            simple_mariadb::retry::Failure failure;
+            if (!m_insert(writer, query, &failure)) {
+                if (!m_is_connected(writer.conn)) {
+                    break;
+                }
+                m_retry->fail(query, 1, std::move(failure));
+            }
+            replayed++;
+        }
+        return replayed;
+    }
+
+    void MariaDBManager::m_run_retry_writer() {
+        Writer &writer = *m_retry_writer;
+        std::vector<simple_mariadb::retry::Pending> due;
+        std::vector<simple_mariadb::retry::Pending> unreached;
+        const std::chrono::milliseconds max_delay(m_config.retry_max_backoff_ms);
+        std::chrono::milliseconds delay(m_config.retry_backoff_ms);
+        while (m_retry_running) {
+            due.clear();
+            m_retry->wait(std::chrono::milliseconds(100), due);
+            this->m_retry_due(writer, due, unreached, true);
+            if (unreached.empty()) {
+                delay = std::chrono::milliseconds(m_config.retry_backoff_ms);
+                continue;
+            }
+            // The server is out of reach: the retries wait for it without using an attempt, and the reconnects
+            // back off like the retries do
+            m_retry->postpone(unreached, delay);
+            delay = std::min(delay * 2, max_delay);
+        }
+        // Stopping: the retries still on the wheel get one last attempt, unless the stop is forced. Those given
+        // up on go to the spill log when it is enabled, to the dead letter sinks otherwise
+        due.clear();
+        m_retry->take_all(due);
+        if (m_retry_forced) {
+            m_retry->give_up(due);
+        } else {
+            this->m_retry_due(writer, due, unreached, false);
+            m_retry->give_up(unreached);
+        }
+        m_retry->flush();
+    }
+
+    void MariaDBManager::m_retry_due(Writer &writer, std::vector<simple_mariadb::retry::Pending> &due,
+                                     std::vector<simple_mariadb::retry::Pending> &unreached, bool may_retry) {
+        if (due.empty()) {
+            return;
+        }
+        // One reconnect per round: during an outage each one can take the whole connect timeout
+        bool connected = m_is_connected(writer.conn);
+        if (!connected) {
+            std::lock_guard<std::mutex> lock(writer.mutex);
+            this->m_reconnect(writer);
+            writer.reconnects++;
+            connected = m_is_connected(writer.conn);
+        }
+        for (auto &pending: due) {
+            if (!connected) {
+                unreached.push_back(std::move(pending));
+                continue;
+            }
+            simple_mariadb::retry::Failure failure;
+            if (m_insert(writer, pending.statement, &failure)) {
+                m_retry->recovered();
+                continue;
+            }
+            m_retry->fail(std::move(pending.statement), pending.attempts + 1, std::move(failure), may_retry);
+            connected = m_is_connected(writer.conn);
+        }
+    }
+
+    void MariaDBManager::m_run_row_writer() {
+        Writer &writer = *m_row_writer;
+        const std::chrono::milliseconds linger(m_config.batch_linger_ms);
+        while (true) {
+            auto batches = m_rows.wait_batches(linger, m_rows_running);
+            if (batches.empty()) {
+                if (!m_rows_running) {
+                    break;
+                }
+                continue;
+            }
+            for (const auto &batch: batches) {
+                this->m_write_rows(writer, batch);
+                m_rows.done(batch.rows());
+            }
+        }
+    }
+
+    bool MariaDBManager::m_write_rows(Writer &writer, const simple_mariadb::rows::RowBatch &batch) {
+        const size_t rows = batch.rows();
+        const int max_attempts = 2; // the second attempt re-prepares after a reconnect or a stale statement
+        // Without a server answer the rows never reached it, like a statement sent on a lost connection
+        simple_mariadb::retry::Failure failure{2003, "08001", "row writer is not connected"};
+        for (int attempt = 0; attempt < max_attempts; ++attempt) {
+            std::lock_guard<std::mutex> lock(writer.mutex);
+            try {
+                if (writer.conn == nullptr || writer.conn->isClosed()) {
+                    writer.reconnects++;
+                    this->m_reconnect(writer);
+                }
+                if (!this->m_is_connected(writer.conn)) {
+                    break;
+                }
+                sql::PreparedStatement &stmt = writer.statements->get(writer.conn, batch.sql);
+                for (size_t row = 0; row < rows; ++row) {
+                    for (size_t column = 0; column < batch.columns; ++column) {
+                        simple_mariadb::rows::bind_value(stmt, static_cast<int32_t>(column + 1),
+                                                         batch.values[row * batch.columns + column]);
+                    }
+                    stmt.addBatch();
                 }
+                stmt.executeBatch();
+                writer.batches++;
+                writer.executed += rows;
+                m_metrics.batch_rows.record(rows);
+                m_metrics.rows.add(rows);
+                this->m_invalidate(batch.sql);
+                return true;
+            } catch (sql::SQLException &e) {
+                // Dropping the statement also drops the rows added to its batch
+                writer.statements->evict(batch.sql);
+                if (attempt + 1 < max_attempts && simple_mariadb::statement::needs_reprepare(e)) {
+                    this->m_reconnect(writer);
+                    continue;
+                }
+                m_query_log.send<simple_logger::LogLevel::ERROR>(batch.sql, [&e, rows](const std::string &shown) {
+                    return std::to_string(e.getErrorCode()) + " Bulk INSERT failed: " + std::string(e.what()) +
+                           " QUERY: <" + shown + "> ROWS: " + std::to_string(rows);
+                });
+                failure = {e.getErrorCode(), std::string(e.getSQLState()), e.what()};
+                break;
             }
         }
+        m_error_counter++;
+        writer.failed += rows;
+        // Each row goes on as a text statement: the retries write the transient failures once the server is back,
+        // or spill them, and dead letter the permanent ones
+        for (size_t row = 0; row < rows; ++row) {
+            m_retry->fail(simple_mariadb::rows::row_statement(batch, row), 1, failure);
+        }
+        return false;
+    }
+
+    void MariaDBManager::m_load_max_allowed_packet(Writer &writer) {
+        try {
+            std::lock_guard<std::mutex> lock(writer.mutex);
+            if (!this->m_is_connected(writer.conn)) {
+                return;
+            }
+            std::unique_ptr<sql::Statement> stmt(writer.conn->createStatement());
+            std::unique_ptr<sql::ResultSet> res(stmt->executeQuery("SELECT @@max_allowed_packet"));
+            if (res->next()) {
+                m_max_allowed_packet = static_cast<size_t>(res->getUInt64(1));
+            }
+        } catch (sql::SQLException &e) {
+            m_logger->send<simple_logger::LogLevel::WARNING>(
+                    "Reading max_allowed_packet failed: " + std::string(e.what()));
+        }
+    }
+
+    size_t MariaDBManager::m_batch_max_bytes() const {
+        const size_t default_max_bytes = 1024 * 1024;
+        const size_t packet_headroom = 1024; // START TRANSACTION / COMMIT wrapping and protocol header
+        size_t limit = m_config.batch_max_bytes;
+        const size_t packet = m_max_allowed_packet;
+        if (packet > packet_headroom) {
+            limit = limit == 0 ? packet - packet_headroom : std::min(limit, packet - packet_headroom);
+        }
+        return limit == 0 ? default_max_bytes : limit;
     }
 
     void MariaDBManager::m_run_checker() {
         m_checker_thread_is_running = true;
         std::this_thread::sleep_for(std::chrono::seconds(m_config.checker_time));
         while (m_checker_thread_is_running) {
-            if (!this->m_is_connected(m_conn_read)) {
-                m_logger->send<simple_logger::LogLevel::WARNING>(
-                        "MariaDBManager Checker Read Connection to database failed: " + m_config.uri);
-                std::lock_guard<std::mutex> lock(m_read_mutex);
-                m_get_connection(m_conn_read);
+            if (m_read_pool) {
+                m_read_pool->check_idle();
+                if (!m_read_pool->is_connected()) {
+                    m_logger->send<simple_logger::LogLevel::WARNING>(
+                            "MariaDBManager Checker Read Connection to database failed: " + m_config.uri);
+                }
             }
             if (!this->m_is_connected(m_conn_write)) {
                 m_logger->send<simple_logger::LogLevel::WARNING>(
@@ -183,65 +954,102 @@ namespace simple_mariadb::client {
                 std::lock_guard<std::mutex> lock(m_write_mutex);
                 m_get_connection(m_conn_write);
             }
+            for (auto &writer: m_writers) {
+                std::lock_guard<std::mutex> lock(writer->mutex);
+                if (!this->m_is_connected(writer->conn)) {
+                    m_logger->send<simple_logger::LogLevel::WARNING>(
+                            "MariaDBManager Checker Writer " + std::to_string(writer->id) +
+                            " Connection to database failed: " + m_config.uri);
+                    writer->reconnects++;
+                    this->m_reconnect(*writer);
+                }
+            }
             std::this_thread::sleep_for(std::chrono::seconds(m_config.checker_time));
         }
     }
 
-    bool MariaDBManager::m_insert(const std::string &query) {
+    bool MariaDBManager::m_insert(Writer &writer, const std::string &query, simple_mariadb::retry::Failure *failure) {
         if (query.empty()) {
             return true;
         }
         try {
-            std::lock_guard<std::mutex> lock(m_write_mutex);
-            std::unique_ptr<sql::Statement> stmt(m_conn_write->createStatement());
+            std::lock_guard<std::mutex> lock(writer.mutex);
+            const auto start = std::chrono::steady_clock::now();
+            std::unique_ptr<sql::Statement> stmt(writer.conn->createStatement());
             stmt->execute(query);
+            m_metrics.insert.record_since(start);
         } catch (sql::SQLException &e) {
             if (e.getErrorCode() == 1452) {
-                m_logger->send<simple_logger::LogLevel::WARNING>(
-                        std::to_string(e.getErrorCode()) + " INSERT warning: " + std::string(e.what()) + " QUERY: <" +
-                        query + ">");
+                m_query_log.send<simple_logger::LogLevel::WARNING>(query, [&e](const std::string &shown) {
+                    return std::to_string(e.getErrorCode()) + " INSERT warning: " + std::string(e.what()) +
+                           " QUERY: <" + shown + ">";
+                });
+                writer.executed++;
+                m_metrics.rows.add(1);
                 return true;
             }
             m_error_counter++;
-            m_logger->send<simple_logger::LogLevel::ERROR>(
-                    std::to_string(e.getErrorCode()) + " INSERT failed: " + std::string(e.what()) + " QUERY: <" +
-                    query + ">");
+            writer.failed++;
+            m_query_log.send<simple_logger::LogLevel::ERROR>(query, [&e](const std::string &shown) {
+                return std::to_string(e.getErrorCode()) + " INSERT failed: " + std::string(e.what()) +
+                       " QUERY: <" + shown + ">";
+            });
+            if (failure) {
+                failure->error_code = e.getErrorCode();
+                failure->sql_state = std::string(e.getSQLState());
+                failure->message = e.what();
+            }
             return false;
         }
-        m_logger->send<simple_logger::LogLevel::DEBUG>("Single INSERT success: " + query);
+        writer.executed++;
+        m_metrics.rows.add(1);
+        this->m_invalidate(query);
+        m_log.send<simple_logger::LogLevel::DEBUG>([&query]() { return "Single INSERT success: " + query; });
         return true;
     }
 
-    bool MariaDBManager::m_insert_multi(const std::vector<std::string> &queries) {
+    bool MariaDBManager::m_insert_multi(Writer &writer, const std::vector<std::string> &queries) {
         bool success = true;
-        std::stringstream multi_query;
+        // Assembled in the buffers of the writer, only its own thread touches them
+        std::string &multi_query = writer.wire;
 
         try {
+            // Compatible single-row statements become one INSERT ... VALUES (...),(...) per table
+            const bool multi_row = m_multi_row_insert;
+            if (multi_row) {
+                simple_mariadb::batch::rewrite_multi_row(queries, writer.rewritten);
+            }
+            const std::vector<std::string> &statements = multi_row ? writer.rewritten : queries;
 
-            multi_query << "START TRANSACTION;";
-            for (const auto &query: queries) {
-                if (query.empty())
-                    continue;
-                if (query.back() == ';') {
-                    multi_query << query;
-                } else {
-                    multi_query << query << ";";
+            simple_mariadb::batch::wrap_transaction(statements, multi_query);
+
+            std::lock_guard<std::mutex> lock(writer.mutex);
+            const auto start = std::chrono::steady_clock::now();
+            std::unique_ptr<sql::Statement> stmt(writer.conn->createStatement());
+            stmt->execute(multi_query);
+            m_metrics.insert_multi.record_since(start);
+            writer.batches++;
+            writer.executed += queries.size();
+            m_metrics.batch_rows.record(queries.size());
+            m_metrics.rows.add(queries.size());
+            if (m_cache) {
+                for (const auto &query: statements) {
+                    this->m_invalidate(query);
                 }
             }
-            multi_query << "COMMIT;";
-
-            std::lock_guard<std::mutex> lock(m_write_mutex);
-            std::unique_ptr<sql::Statement> stmt(m_conn_write->createStatement());
-            stmt->execute(multi_query.str());
 
         } catch (sql::SQLException &e) {
             // if fails, rollback
             m_logger->send<simple_logger::LogLevel::ERROR>("Multi INSERT failed: " + std::string(e.what()));
-            m_conn_write->rollback();
+            std::lock_guard<std::mutex> lock(writer.mutex);
+            writer.conn->rollback();
             success = false;
         }
-        if (!success)
-            m_logger->send<simple_logger::LogLevel::ERROR>("Multi INSERT failed: " + multi_query.str());
+        if (!success) {
+            m_query_log.send<simple_logger::LogLevel::ERROR>(multi_query, [](const std::string &shown) {
+                return "Multi INSERT failed: " + shown;
+            });
+        }
         return success;
     }
 
@@ -255,32 +1063,41 @@ namespace simple_mariadb::client {
     }
 
     bool MariaDBManager::is_connected() {
-        return this->m_is_connected(m_conn_write) && this->m_is_connected(m_conn_read);
+        return this->m_is_connected(m_conn_write) && m_read_pool && m_read_pool->is_connected();
     }
 
     bool MariaDBManager::is_thread_running() {
-        if (m_queue_thread.joinable() && m_queue_thread_is_running) {
-            return m_queue_thread_is_running;
+        if (!m_queue_thread_is_running) {
+            return false;
         }
-        return false;
+        return std::any_of(m_writers.begin(), m_writers.end(),
+                           [](const std::unique_ptr<Writer> &writer) { return writer->thread.joinable(); });
     }
 
     void MariaDBManager::set_multi_insert(bool multi_insert) {
         m_multi_insert = multi_insert;
     }
 
+    void MariaDBManager::set_multi_row_insert(bool multi_row_insert) {
+        m_multi_row_insert = multi_row_insert;
+    }
+
     std::unique_ptr<sql::ResultSet> MariaDBManager::query(const std::string &query) {
         const int max_retries = 3; // Max retries for query
+        const auto start = std::chrono::steady_clock::now();
         for (int attempt = 0; attempt < max_retries; ++attempt) {
+            // The result set is fully buffered on the client, the connection goes back to the pool on return
+            auto lease = m_read_pool->acquire();
             try {
-                if (!this->is_connected()) {
-                    m_conn_read->reconnect();
-                }
-                std::unique_ptr<sql::Statement> _stmnt(m_conn_read->createStatement());
+                std::unique_ptr<sql::Statement> _stmnt(lease->createStatement());
                 std::unique_ptr<sql::ResultSet> res(_stmnt->executeQuery(query));
+                m_metrics.query.record_since(start);
                 return res;
             } catch (sql::SQLException &e) {
                 m_logger->send<simple_logger::LogLevel::ERROR>("MariadbClient query ERROR: " + std::string(e.what()));
+                if (!this->m_is_connected(lease.get())) {
+                    lease.invalidate(); // broken connection, the pool opens a new one on the next checkout
+                }
                 if (attempt == max_retries - 1) {
                     throw; // last attempt, throw exception
                 }
@@ -290,66 +1107,237 @@ namespace simple_mariadb::client {
         throw std::runtime_error("Max retries reached for MariaDB query.");
     }
 
+    simple_mariadb::executor::Executor &MariaDBManager::m_executor() {
+        std::lock_guard<std::mutex> lock(m_async_mutex);
+        if (!m_async) {
+            size_t threads = m_config.async_threads;
+            if (threads == 0) {
+                // One thread per read connection, a thread never waits on the pool for another task
+                threads = m_config.read_pool_max == 0 ? m_config.read_pool_size : m_config.read_pool_max;
+            }
+            m_async = std::make_unique<simple_mariadb::executor::Executor>(threads);
+        }
+        return *m_async;
+    }
+
+    std::future<std::unique_ptr<sql::ResultSet>> MariaDBManager::query_async(const std::string &query) {
+        return this->m_executor().submit([this, query]() { return this->query(query); });
+    }
+
+    std::future<std::vector<std::map<std::string, std::string>>>
+    MariaDBManager::select_async(const std::string &query) {
+        if (!m_engine) {
+            return this->m_executor().submit([this, query]() { return this->select(query); });
+        }
+        typedef std::vector<std::map<std::string, std::string>> Rows;
+        auto promise = std::make_shared<std::promise<Rows>>();
+        auto future = promise->get_future();
+        // Same cache entries as select(), so the result does not depend on the engine
+        std::string key;
+        uint64_t started = 0;
+        if (m_cache && simple_mariadb::cache::is_cacheable(query)) {
+            key = "s" + query;
+            if (auto hit = m_cache->get(key)) {
+                promise->set_value(std::get<Rows>(*hit));
+                return future;
+            }
+            started = m_cache->now();
+        }
+        m_engine->submit(query, [this, promise, query, key, started](simple_mariadb::engine::Result &&result) {
+            if (!result.ok) {
+                m_error_counter++;
+                promise->set_exception(std::make_exception_ptr(
+                        sql::SQLException(result.error, "", static_cast<int32_t>(result.error_code))));
+                return;
+            }
+            const auto &header = result.rows.header();
+            std::vector<std::map<std::string, std::string>> rows;
+            rows.reserve(result.rows.rows());
+            for (auto row: result.rows) {
+                std::map<std::string, std::string> map_row;
+                for (size_t i = 0; i < header.size(); ++i) {
+                    map_row.emplace(header[i], std::string(row[i]));
+                }
+                rows.push_back(std::move(map_row));
+            }
+            if (!key.empty()) {
+                m_cache->put(key, simple_mariadb::cache::read_tables(query), rows, started);
+            }
+            promise->set_value(std::move(rows));
+        });
+        return future;
+    }
+
+    std::future<simple_mariadb::engine::Result> MariaDBManager::execute_async(const std::string &sql) {
+        if (!m_engine) {
+            throw std::runtime_error("execute_async() needs the nonblocking engine, engine is " + m_config.engine);
+        }
+        if (!m_cache) {
+            return m_engine->submit(sql);
+        }
+        auto promise = std::make_shared<std::promise<simple_mariadb::engine::Result>>();
+        auto future = promise->get_future();
+        m_engine->submit(sql, [this, promise, sql](simple_mariadb::engine::Result &&result) {
+            if (result.ok) {
+                this->m_invalidate(sql);
+            }
+            promise->set_value(std::move(result));
+        });
+        return future;
+    }
+
+    simple_mariadb::executor::Awaitable<std::unique_ptr<sql::ResultSet>>
+    MariaDBManager::co_query(const std::string &query) {
+        return {this->m_executor(), [this, query]() { return this->query(query); }};
+    }
+
+    simple_mariadb::executor::Awaitable<std::vector<std::map<std::string, std::string>>>
+    MariaDBManager::co_select(const std::string &query) {
+        return {this->m_executor(), [this, query]() { return this->select(query); }};
+    }
+
+    simple_mariadb::cursor::Cursor MariaDBManager::open_cursor(const std::string &query, size_t fetch_size) {
+        const int max_retries = 3; // nothing was handed to the caller yet, a failed execute can be retried
+        for (int attempt = 0; attempt < max_retries; ++attempt) {
+            auto lease = m_read_pool->acquire();
+            try {
+                std::unique_ptr<sql::Statement> stmt(lease->createStatement());
+                stmt->setFetchSize(static_cast<int32_t>(fetch_size == 0 ? m_config.fetch_size : fetch_size));
+                std::unique_ptr<sql::ResultSet> res(stmt->executeQuery(query));
+                return {std::move(lease), std::move(stmt), std::move(res)};
+            } catch (sql::SQLException &e) {
+                m_logger->send<simple_logger::LogLevel::ERROR>("MariadbClient cursor ERROR: " + std::string(e.what()));
+                if (!this->m_is_connected(lease.get())) {
+                    lease.invalidate();
+                }
+                if (attempt == max_retries - 1) {
+                    throw;
+                }
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(100 * (attempt + 1)));
+        }
+        throw std::runtime_error("Max retries reached for MariaDB cursor.");
+    }
+
+    size_t MariaDBManager::for_each_row(const std::string &query, const simple_mariadb::cursor::RowVisitor &visitor,
+                                        size_t fetch_size) {
+        auto cursor = this->open_cursor(query, fetch_size);
+        while (cursor.next()) {
+            if (!visitor(cursor.row())) {
+                break;
+            }
+        }
+        return cursor.rows();
+    }
+
+    simple_mariadb::columnar::ColumnarResult MariaDBManager::select_columnar(const std::string &query,
+                                                                             size_t fetch_size) {
+        auto cursor = this->open_cursor(query, fetch_size);
+        auto meta = cursor.meta();
+        if (meta == nullptr) {
+            return {};
+        }
+        simple_mariadb::columnar::ColumnarBuilder builder(*meta);
+        while (cursor.next()) {
+            builder.append_row(cursor.row());
+        }
+        return builder.finish();
+    }
+
     json MariaDBManager::query_to_json(const std::string &query) {
-        return simple_mariadb::client::MariaDBManager::resultset_to_json(*this->query(query));
+        if (m_cache) {
+            return this->m_cached<json>('j', query, [this, &query]() {
+                return this->m_resultset_to_json(*this->query(query));
+            });
+        }
+        return this->m_resultset_to_json(*this->query(query));
     }
 
-    json MariaDBManager::resultset_to_json(sql::ResultSet &res) {
-        json result;
-        auto meta = res.getMetaData();
-        const size_t numColumns = meta->getColumnCount();
+    void MariaDBManager::clear_query_cache() {
+        if (m_cache) {
+            m_cache->clear();
+        }
+    }
 
-        while (res.next()) {
-            json row;
-            for (size_t i = 1; i <= numColumns; ++i) {
-                const std::string columnName = std::string(meta->getColumnName(i));
-                const auto columnType = static_cast<sql::DataType>(meta->getColumnType(i));
+    void MariaDBManager::m_invalidate(std::string_view statement) {
+        if (m_cache) {
+            m_cache->invalidate(statement);
+        }
+    }
+
+    void MariaDBManager::m_invalidate_table(const std::string &table) {
+        if (m_cache) {
+            m_cache->invalidate_table(table);
+        }
+    }
 
-                if (res.wasNull()) {
-                    row[columnName] = nullptr;
+    bool MariaDBManager::m_execute_prepared(const std::string &sql, const Binder &binder) {
+        const int max_attempts = 2; // the second attempt re-prepares after a reconnect or a stale statement
+        for (int attempt = 0; attempt < max_attempts; ++attempt) {
+            std::lock_guard<std::mutex> lock(m_write_mutex);
+            try {
+                sql::PreparedStatement &stmt = m_write_statements.get(m_conn_write, sql);
+                stmt.clearParameters();
+                binder(stmt);
+                stmt.execute();
+                this->m_invalidate(sql);
+                return true;
+            } catch (sql::SQLException &e) {
+                if (attempt + 1 < max_attempts && simple_mariadb::statement::needs_reprepare(e)) {
+                    m_write_statements.evict(sql);
+                    this->m_get_connection(m_conn_write); // no-op if the connection is still valid
                     continue;
                 }
+                m_error_counter++;
+                m_logger->send<simple_logger::LogLevel::ERROR>(
+                        std::to_string(e.getErrorCode()) + " execute_prepared failed: " + std::string(e.what()) +
+                        " QUERY: <" + sql + ">");
+                return false;
+            }
+        }
+        return false;
+    }
 
-
-                try {
-                    switch (columnType) {
-                        case sql::INTEGER:
-                            row[columnName] = res.getInt(columnName);
-                            break;
-                        case sql::BIGINT:
-                            row[columnName] = res.getInt64(columnName);
-                            break;
-                        case sql::BOOLEAN:
-                            row[columnName] = res.getBoolean(columnName);
-                            break;
-                        case sql::DOUBLE:
-                            row[columnName] = res.getDouble(columnName);
-                            break;
-                        case sql::FLOAT:
-                        case sql::REAL: // REAL is often just a synonym for FLOAT
-                            row[columnName] = res.getFloat(columnName);
-                            break;
-                        case sql::DATE:
-                        case sql::TIME:
-                        case sql::TIME_WITH_TIMEZONE:
-                        case sql::TIMESTAMP:
-                        case sql::TIMESTAMP_WITH_TIMEZONE:
-                            row[columnName] = res.getString(columnName); // Use getString for date/time types
-                            break;
-                            // Add cases for other types as necessary
-                        default:
-                            // For all other types, default to string representation
-                            row[columnName] = res.getString(columnName);
-                            break;
+    json MariaDBManager::m_query_prepared(const std::string &sql, const Binder &binder) {
+        const int max_attempts = 2;
+        for (int attempt = 0; attempt < max_attempts; ++attempt) {
+            auto lease = m_read_pool->acquire();
+            try {
+                sql::PreparedStatement &stmt = lease.statements().get(lease.get(), sql);
+                stmt.clearParameters();
+                binder(stmt);
+                std::unique_ptr<sql::ResultSet> res(stmt.executeQuery());
+                return this->m_resultset_to_json(*res);
+            } catch (sql::SQLException &e) {
+                m_logger->send<simple_logger::LogLevel::ERROR>("MariadbClient query_prepared ERROR: " + std::string(e.what()));
+                if (attempt + 1 < max_attempts && simple_mariadb::statement::needs_reprepare(e)) {
+                    lease.statements().evict(sql);
+                    if (!this->m_is_connected(lease.get())) {
+                        lease.invalidate();
                     }
-                } catch (sql::SQLException &e) {
-                    std::cout << "columnName: " << columnName << " type: " << columnType << std::endl;
-                    std::cout << "MariaDBManager::resultset_to_json ERROR " << e.what() << std::endl;
-
-                    row[columnName] = nullptr;
+                    continue;
                 }
+                throw;
             }
-            result.push_back(row);
+        }
+        throw std::runtime_error("Max retries reached for MariaDB query_prepared.");
+    }
+
+    json MariaDBManager::resultset_to_json(sql::ResultSet &res, std::string *error) {
+        json result;
+        // Names, types and decoders are resolved once per result, rows are then read by index
+        const simple_mariadb::decoder::ColumnPlan plan(*res.getMetaData());
+        while (res.next()) {
+            result.push_back(plan.decode_row(res, error));
+        }
+        return result;
+    }
+
+    json MariaDBManager::m_resultset_to_json(sql::ResultSet &res) {
+        std::string error;
+        json result = MariaDBManager::resultset_to_json(res, &error);
+        if (!error.empty()) {
+            m_logger->send<simple_logger::LogLevel::ERROR>("MariaDBManager::resultset_to_json ERROR " + error);
         }
         return result;
     }
@@ -357,7 +1345,8 @@ namespace simple_mariadb::client {
     bool MariaDBManager::ping() {
         try {
             std::string query = "select 1;";
-            json is_one = this->query_to_json(query);
+            // Straight to the server, a cached answer would hide that it is gone
+            json is_one = this->m_resultset_to_json(*this->query(query));
             return is_one.size() == 1 && is_one[0].contains("1") && is_one[0]["1"] == 1;
         } catch (std::exception &gc) {
             m_logger->send<simple_logger::LogLevel::ERROR>("Ping ERROR: " + std::string(gc.what()));
@@ -370,6 +1359,7 @@ namespace simple_mariadb::client {
             std::lock_guard<std::mutex> lock(m_write_mutex);
             std::unique_ptr<sql::Statement> _stmnt(m_conn_write->createStatement());
             _stmnt->execute("DROP TABLE IF EXISTS " + table_name);
+            this->m_invalidate_table(table_name);
             return true;
         } catch (std::exception &gc) {
             m_logger->send<simple_logger::LogLevel::ERROR>("drop_table ERROR: " + table_name + " " + gc.what());
@@ -391,6 +1381,7 @@ namespace simple_mariadb::client {
                 std::unique_ptr<sql::Statement> _stmnt(m_conn_write->createStatement());
                 _stmnt->execute(base_query);
             }
+            this->m_invalidate_table(table_name);
             return true;
         } catch (std::exception &gc) {
             m_logger->send<simple_logger::LogLevel::ERROR>("create_table ERROR: " + table_name + " " + gc.what());
@@ -412,6 +1403,7 @@ namespace simple_mariadb::client {
                 std::unique_ptr<sql::Statement> _stmnt(m_conn_write->createStatement());
                 _stmnt->execute(base_query);
             }
+            this->m_invalidate_table(table_name);
             return true;
         } catch (std::exception &gc) {
             m_logger->send<simple_logger::LogLevel::ERROR>(
@@ -422,8 +1414,8 @@ namespace simple_mariadb::client {
 
     std::map<std::string, std::string> MariaDBManager::get_table_columns(const std::string &table_name) {
         try {
-            std::lock_guard<std::mutex> lock(m_read_mutex);
-            std::unique_ptr<sql::Statement> _stmnt(m_conn_read->createStatement());
+            auto lease = m_read_pool->acquire();
+            std::unique_ptr<sql::Statement> _stmnt(lease->createStatement());
             std::unique_ptr<sql::ResultSet> res(_stmnt->executeQuery("SHOW COLUMNS FROM " + table_name));
             std::map<std::string, std::string> columns;
             while (res->next()) {
@@ -451,6 +1443,7 @@ namespace simple_mariadb::client {
                 std::unique_ptr<sql::Statement> _stmnt(m_conn_write->createStatement());
                 _stmnt->execute(base_query);
             }
+            this->m_invalidate_table(table_name);
             return true;
         } catch (std::exception &gc) {
             m_logger->send<simple_logger::LogLevel::ERROR>(
@@ -473,6 +1466,7 @@ namespace simple_mariadb::client {
                 std::unique_ptr<sql::Statement> _stmnt(m_conn_write->createStatement());
                 _stmnt->execute(base_query);
             }
+            this->m_invalidate_table(table_name);
             return true;
         } catch (std::exception &gc) {
             m_logger->send<simple_logger::LogLevel::ERROR>("create_index ERROR: " + table_name + " " + gc.what());
@@ -486,12 +1480,118 @@ namespace simple_mariadb::client {
         return error_counter;
     }
 
+    void MariaDBManager::set_dead_letter_callback(simple_mariadb::retry::DeadLetterCallback callback) {
+        m_retry->set_callback([this, callback = std::move(callback)](const simple_mariadb::retry::DeadLetter &letter) {
+            m_query_log.send<simple_logger::LogLevel::ERROR>(letter.statement, [&letter](const std::string &shown) {
+                return "DISCARD QUERY (" + letter.reason + " after " + std::to_string(letter.attempts) +
+                       " attempts): " + shown + " " + letter.failure.message;
+            });
+            if (callback) {
+                callback(letter);
+            }
+        });
+    }
+
     void MariaDBManager::clear_queue() {
         m_queries.wipeout();
     }
 
     Stats MariaDBManager::get_stats() {
-        return m_queries.get_stats();
+        Stats stats;
+        static_cast<::common::Stats &>(stats) = m_queries.get_stats();
+        stats.queue = m_queries.get_queue_stats();
+        if (m_spill) {
+            stats.spill = m_spill->get_stats();
+        }
+        if (m_spill_writer) {
+            stats.spill_writer = this->m_writer_stats(*m_spill_writer);
+        }
+        stats.writers.reserve(m_writers.size());
+        for (auto &writer: m_writers) {
+            stats.writers.push_back(this->m_writer_stats(*writer));
+        }
+        if (m_row_writer) {
+            stats.row_writer = this->m_writer_stats(*m_row_writer);
+        }
+        if (m_retry) {
+            stats.retry = m_retry->get_stats();
+        }
+        if (m_retry_writer) {
+            stats.retry_writer = this->m_writer_stats(*m_retry_writer);
+        }
+        stats.read_pool = this->get_read_pool_stats();
+        stats.operations = this->get_operation_stats();
+        if (m_engine) {
+            stats.engine = m_engine->get_stats();
+        }
+        if (m_cache) {
+            stats.cache = m_cache->get_stats();
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_async_mutex);
+            if (m_async) {
+                stats.async = m_async->get_stats();
+            }
+        }
+        if (m_read_pool) {
+            stats.statements += m_read_pool->get_statement_stats();
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_write_mutex);
+            stats.statements += m_write_statements.get_stats();
+        }
+        // The statement caches count with atomics: a writer holds its mutex across a whole batch or reconnect
+        for (auto &writer: m_writers) {
+            stats.statements += writer->statements->get_stats();
+        }
+        if (m_row_writer) {
+            stats.statements += m_row_writer->statements->get_stats();
+        }
+        return stats;
+    }
+
+    WriterStats MariaDBManager::m_writer_stats(Writer &writer) {
+        WriterStats writer_stats;
+        writer_stats.id = writer.id;
+        writer_stats.executed = writer.executed;
+        writer_stats.failed = writer.failed;
+        writer_stats.batches = writer.batches;
+        writer_stats.reconnects = writer.reconnects;
+        writer_stats.connected = writer.connected;
+        return writer_stats;
+    }
+
+    OperationStats MariaDBManager::get_operation_stats() const {
+        OperationStats stats;
+        stats.insert = m_metrics.insert.snapshot();
+        stats.insert_multi = m_metrics.insert_multi.snapshot();
+        stats.query = m_metrics.query.snapshot();
+        if (m_read_pool) {
+            stats.acquire = m_read_pool->get_acquire_latency();
+        }
+        stats.connect = m_metrics.connect.snapshot();
+        stats.batch_rows = m_metrics.batch_rows.snapshot();
+        stats.rows = m_metrics.rows.snapshot();
+        return stats;
+    }
+
+    nlohmann::json OperationStats::to_json() const {
+        nlohmann::json j;
+        j["insert"] = insert.to_json();
+        j["insert_multi"] = insert_multi.to_json();
+        j["query"] = query.to_json();
+        j["acquire"] = acquire.to_json();
+        j["connect"] = connect.to_json();
+        j["batch_rows"] = batch_rows.to_json();
+        j["rows"] = rows.to_json();
+        return j;
+    }
+
+    simple_mariadb::pool::PoolStats MariaDBManager::get_read_pool_stats() {
+        if (!m_read_pool) {
+            return {};
+        }
+        return m_read_pool->get_stats();
     }
 
 }
@@ -0,0 +1,176 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+#include "simple_mariadb/columnar.h"
+#include <stdexcept>
+
+namespace simple_mariadb::columnar {
+
+    using simple_mariadb::decoder::Decoder;
+
+    ColumnType column_type_for(Decoder decoder) {
+        switch (decoder) {
+            case Decoder::INT:
+            case Decoder::INT64:
+                return ColumnType::INT64;
+            case Decoder::DOUBLE:
+            case Decoder::FLOAT:
+                return ColumnType::DOUBLE;
+            case Decoder::BOOLEAN:
+                return ColumnType::BOOLEAN;
+            case Decoder::STRING:
+            default:
+                return ColumnType::STRING;
+        }
+    }
+
+    Column::Column(std::string name, ColumnType type, sql::DataType sql_type) :
+            m_name(std::move(name)), m_type(type), m_sql_type(sql_type) {}
+
+    void Column::m_push_validity(bool valid) {
+        if (m_size % 8 == 0) {
+            m_validity.push_back(0);
+        }
+        if (valid) {
+            m_validity.back() |= static_cast<uint8_t>(1u << (m_size % 8));
+        } else {
+            m_null_count++;
+        }
+        m_size++;
+    }
+
+    void Column::append_int64(int64_t value) {
+        m_int64s.push_back(value);
+        this->m_push_validity(true);
+    }
+
+    void Column::append_double(double value) {
+        m_doubles.push_back(value);
+        this->m_push_validity(true);
+    }
+
+    void Column::append_bool(bool value) {
+        m_bools.push_back(value ? 1 : 0);
+        this->m_push_validity(true);
+    }
+
+    void Column::append_string(std::string_view value) {
+        m_data.append(value);
+        m_offsets.push_back(m_data.size());
+        this->m_push_validity(true);
+    }
+
+    void Column::append_null() {
+        switch (m_type) {
+            case ColumnType::INT64:
+                m_int64s.push_back(0);
+                break;
+            case ColumnType::DOUBLE:
+                m_doubles.push_back(0.0);
+                break;
+            case ColumnType::BOOLEAN:
+                m_bools.push_back(0);
+                break;
+            case ColumnType::STRING:
+                m_offsets.push_back(m_data.size());
+                break;
+        }
+        this->m_push_validity(false);
+    }
+
+    void Column::reserve(size_t rows) {
+        m_validity.reserve((rows + 7) / 8);
+        switch (m_type) {
+            case ColumnType::INT64:
+                m_int64s.reserve(rows);
+                break;
+            case ColumnType::DOUBLE:
+                m_doubles.reserve(rows);
+                break;
+            case ColumnType::BOOLEAN:
+                m_bools.reserve(rows);
+                break;
+            case ColumnType::STRING:
+                m_offsets.reserve(rows + 1);
+                break;
+        }
+    }
+
+    ColumnarResult::ColumnarResult(std::vector<Column> columns) : m_columns(std::move(columns)) {}
+
+    const Column &ColumnarResult::column(std::string_view name) const {
+        for (const auto &column: m_columns) {
+            if (column.name() == name) {
+                return column;
+            }
+        }
+        throw std::out_of_range("simple_mariadb::columnar: no column " + std::string(name));
+    }
+
+    namespace {
+        std::vector<Column> empty_columns(const simple_mariadb::decoder::ColumnPlan &plan) {
+            std::vector<Column> columns;
+            columns.reserve(plan.columns().size());
+            for (const auto &column: plan.columns()) {
+                columns.emplace_back(column.name, column_type_for(column.decoder), column.type);
+            }
+            return columns;
+        }
+    }
+
+    ColumnarBuilder::ColumnarBuilder(sql::ResultSetMetaData &meta) : m_plan(meta), m_columns(empty_columns(m_plan)) {}
+
+    void ColumnarBuilder::append_row(sql::ResultSet &res) {
+        const auto &plan = m_plan.columns();
+        for (size_t i = 0; i < plan.size(); ++i) {
+            const int32_t index = plan[i].index;
+            Column &column = m_columns[i];
+            // wasNull() reports on the last value read, so it is checked after the read
+            switch (plan[i].decoder) {
+                case Decoder::INT: {
+                    const int64_t value = res.getInt(index);
+                    res.wasNull() ? column.append_null() : column.append_int64(value);
+                    break;
+                }
+                case Decoder::INT64: {
+                    const int64_t value = res.getInt64(index);
+                    res.wasNull() ? column.append_null() : column.append_int64(value);
+                    break;
+                }
+                case Decoder::BOOLEAN: {
+                    const bool value = res.getBoolean(index);
+                    res.wasNull() ? column.append_null() : column.append_bool(value);
+                    break;
+                }
+                case Decoder::DOUBLE: {
+                    const auto value = static_cast<double>(res.getDouble(index));
+                    res.wasNull() ? column.append_null() : column.append_double(value);
+                    break;
+                }
+                case Decoder::FLOAT: {
+                    const double value = res.getFloat(index);
+                    res.wasNull() ? column.append_null() : column.append_double(value);
+                    break;
+                }
+                case Decoder::STRING:
+                default: {
+                    const sql::SQLString value = res.getString(index);
+                    if (res.wasNull()) {
+                        column.append_null();
+                    } else {
+                        column.append_string(std::string_view(value.c_str(), value.length()));
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+    ColumnarResult ColumnarBuilder::finish() {
+        ColumnarResult result(std::move(m_columns));
+        m_columns = empty_columns(m_plan);
+        return result;
+    }
+
+}
@@ -3,6 +3,7 @@
 //
 
 #include "simple_mariadb/config.h"
+#include "simple_mariadb/queue.h"
 
 namespace simple_mariadb::config {
 
@@ -31,6 +32,67 @@ namespace simple_mariadb::config {
             logger->send<simple_logger::LogLevel::ERROR>("Checker time is not valid: " + std::to_string(checker_time));
             return false;
         }
+        if (writer_threads == 0) {
+            logger->send<simple_logger::LogLevel::ERROR>("Writer threads is not valid: " + std::to_string(writer_threads));
+            return false;
+        }
+        if (batch_max_rows == 0) {
+            logger->send<simple_logger::LogLevel::ERROR>("Batch max rows is not valid: " + std::to_string(batch_max_rows));
+            return false;
+        }
+        if (read_pool_size == 0) {
+            logger->send<simple_logger::LogLevel::ERROR>("Read pool size is not valid: " + std::to_string(read_pool_size));
+            return false;
+        }
+        if (read_pool_max != 0 && read_pool_max < read_pool_size) {
+            logger->send<simple_logger::LogLevel::ERROR>("Read pool max is not valid: " + std::to_string(read_pool_max));
+            return false;
+        }
+        if (engine != "threads" && engine != "nonblocking") {
+            logger->send<simple_logger::LogLevel::ERROR>("Engine is not valid: " + engine);
+            return false;
+        }
+        if (engine_connections == 0) {
+            logger->send<simple_logger::LogLevel::ERROR>(
+                    "Engine connections is not valid: " + std::to_string(engine_connections));
+            return false;
+        }
+        if (query_cache_size != 0 && query_cache_ttl_ms == 0) {
+            logger->send<simple_logger::LogLevel::ERROR>(
+                    "Query cache ttl is not valid: " + std::to_string(query_cache_ttl_ms));
+            return false;
+        }
+        simple_mariadb::queue::Backend backend;
+        if (!simple_mariadb::queue::parse_backend(queue_backend, backend)) {
+            logger->send<simple_logger::LogLevel::ERROR>("Queue backend is not valid: " + queue_backend);
+            return false;
+        }
+        simple_mariadb::queue::OverflowPolicy policy;
+        if (!simple_mariadb::queue::parse_overflow_policy(queue_overflow_policy, policy)) {
+            logger->send<simple_logger::LogLevel::ERROR>("Queue overflow policy is not valid: " + queue_overflow_policy);
+            return false;
+        }
+        if (!spill_dir.empty() && spill_segment_size < 4096) {
+            logger->send<simple_logger::LogLevel::ERROR>("Spill segment size is not valid: " + std::to_string(spill_segment_size));
+            return false;
+        }
+        if (fetch_size == 0) {
+            logger->send<simple_logger::LogLevel::ERROR>("Fetch size is not valid: " + std::to_string(fetch_size));
+            return false;
+        }
+        if (load_chunk_size == 0) {
+            logger->send<simple_logger::LogLevel::ERROR>("Load chunk size is not valid: " + std::to_string(load_chunk_size));
+            return false;
+        }
+        if (retry_max_attempts == 0) {
+            logger->send<simple_logger::LogLevel::ERROR>("Retry max attempts is not valid: " + std::to_string(retry_max_attempts));
+            return false;
+        }
+        if (retry_max_backoff_ms < retry_backoff_ms) {
+            logger->send<simple_logger::LogLevel::ERROR>(
+                    "Retry max backoff is not valid: " + std::to_string(retry_max_backoff_ms));
+            return false;
+        }
 
         return true;
     }
@@ -46,10 +108,39 @@ namespace simple_mariadb::config {
         j["tcpkeepalive"] = m_tcpkeepalive;
         j["connecttimeout"] = m_connecttimeout;
         j["sockettimeout"] = m_sockettimeout;
+        j["usebulkstmts"] = m_usebulkstmts;
         j["multi_insert"] = multi_insert;
+        j["multi_row_insert"] = multi_row_insert;
+        j["batch_max_rows"] = batch_max_rows;
+        j["batch_max_bytes"] = batch_max_bytes;
+        j["batch_linger_ms"] = batch_linger_ms;
         j["checker_time"] = checker_time;
         j["queue_size"] = queue_size;
         j["queue_timeout"] = queue_timeout;
+        j["queue_backend"] = queue_backend;
+        j["queue_overflow_policy"] = queue_overflow_policy;
+        j["writer_threads"] = writer_threads;
+        j["read_pool_size"] = read_pool_size;
+        j["read_pool_max"] = read_pool_max;
+        j["read_pool_timeout_ms"] = read_pool_timeout_ms;
+        j["statement_cache_size"] = statement_cache_size;
+        j["fetch_size"] = fetch_size;
+        j["load_chunk_size"] = load_chunk_size;
+        j["spill_dir"] = spill_dir;
+        j["spill_segment_size"] = spill_segment_size;
+        j["spill_max_bytes"] = spill_max_bytes;
+        j["spill_replay_rate"] = spill_replay_rate;
+        j["async_threads"] = async_threads;
+        j["engine"] = engine;
+        j["engine_connections"] = engine_connections;
+        j["query_cache_size"] = query_cache_size;
+        j["query_cache_ttl_ms"] = query_cache_ttl_ms;
+        j["log_queries_per_second"] = log_queries_per_second;
+        j["log_query_max_length"] = log_query_max_length;
+        j["retry_max_attempts"] = retry_max_attempts;
+        j["retry_backoff_ms"] = retry_backoff_ms;
+        j["retry_max_backoff_ms"] = retry_max_backoff_ms;
+        j["dead_letter_path"] = dead_letter_path;
 
         return j;
     }
@@ -65,11 +156,40 @@ namespace simple_mariadb::config {
             m_tcpkeepalive = j.at("tcpkeepalive").get<std::string>();
             m_connecttimeout = j.at("connecttimeout").get<std::string>();
             m_sockettimeout = j.at("sockettimeout").get<std::string>();
+            m_usebulkstmts = j.value("usebulkstmts", m_usebulkstmts);
             multi_insert = j.at("multi_insert").get<bool>();
             checker_time = j.at("checker_time").get<int>();
             uri = "jdbc:mariadb://" + m_hostname + ":" + std::to_string(m_port) + "/" + m_database;
             queue_size = j.at("queue_size").get<int>();
             queue_timeout = j.at("queue_timeout").get<int>();
+            writer_threads = j.value("writer_threads", writer_threads);
+            multi_row_insert = j.value("multi_row_insert", multi_row_insert);
+            batch_max_rows = j.value("batch_max_rows", batch_max_rows);
+            batch_max_bytes = j.value("batch_max_bytes", batch_max_bytes);
+            batch_linger_ms = j.value("batch_linger_ms", batch_linger_ms);
+            read_pool_size = j.value("read_pool_size", read_pool_size);
+            read_pool_max = j.value("read_pool_max", read_pool_max);
+            read_pool_timeout_ms = j.value("read_pool_timeout_ms", read_pool_timeout_ms);
+            statement_cache_size = j.value("statement_cache_size", statement_cache_size);
+            fetch_size = j.value("fetch_size", fetch_size);
+            load_chunk_size = j.value("load_chunk_size", load_chunk_size);
+            spill_dir = j.value("spill_dir", spill_dir);
+            spill_segment_size = j.value("spill_segment_size", spill_segment_size);
+            spill_max_bytes = j.value("spill_max_bytes", spill_max_bytes);
+            spill_replay_rate = j.value("spill_replay_rate", spill_replay_rate);
+            async_threads = j.value("async_threads", async_threads);
+            engine = j.value("engine", engine);
+            engine_connections = j.value("engine_connections", engine_connections);
+            query_cache_size = j.value("query_cache_size", query_cache_size);
+            query_cache_ttl_ms = j.value("query_cache_ttl_ms", query_cache_ttl_ms);
+            log_queries_per_second = j.value("log_queries_per_second", log_queries_per_second);
+            log_query_max_length = j.value("log_query_max_length", log_query_max_length);
+            retry_max_attempts = j.value("retry_max_attempts", retry_max_attempts);
+            retry_backoff_ms = j.value("retry_backoff_ms", retry_backoff_ms);
+            retry_max_backoff_ms = j.value("retry_max_backoff_ms", retry_max_backoff_ms);
+            dead_letter_path = j.value("dead_letter_path", dead_letter_path);
+            queue_backend = j.value("queue_backend", queue_backend);
+            queue_overflow_policy = j.value("queue_overflow_policy", queue_overflow_policy);
 
         } catch (std::exception &e) {
             logger->send<simple_logger::LogLevel::CRITICAL>("Error parsing MariaDBConfig: " + std::string(e.what()));
@@ -88,7 +208,8 @@ namespace simple_mariadb::config {
                 {"autoReconnect",  m_autoreconnect},
                 {"tcpKeepAlive",   m_tcpkeepalive},
                 {"connectTimeout", m_connecttimeout},
-                {"socketTimeout",  m_sockettimeout}
+                {"socketTimeout",  m_sockettimeout},
+                {"useBulkStmts",   m_usebulkstmts}
         };
     }
 
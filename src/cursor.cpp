@@ -0,0 +1,61 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+#include "simple_mariadb/cursor.h"
+
+namespace simple_mariadb::cursor {
+
+    Cursor::Cursor(simple_mariadb::pool::ConnectionPool::Lease lease, std::unique_ptr<sql::Statement> statement,
+                   std::unique_ptr<sql::ResultSet> result) :
+            m_lease(std::move(lease)),
+            m_statement(std::move(statement)),
+            m_result(std::move(result)) {}
+
+    Cursor &Cursor::operator=(Cursor &&other) noexcept {
+        if (this != &other) {
+            this->close(); // the result set must be gone before its connection goes back to the pool
+            m_lease = std::move(other.m_lease);
+            m_statement = std::move(other.m_statement);
+            m_result = std::move(other.m_result);
+            m_rows = other.m_rows;
+        }
+        return *this;
+    }
+
+    Cursor::~Cursor() {
+        this->close();
+    }
+
+    bool Cursor::next() {
+        if (!m_result) {
+            return false;
+        }
+        try {
+            if (m_result->next()) {
+                m_rows++;
+                return true;
+            }
+        } catch (sql::SQLException &) {
+            m_lease.invalidate(); // the stream is broken half way, the connection cannot be reused
+            this->close();
+            throw;
+        }
+        this->close();
+        return false;
+    }
+
+    void Cursor::close() {
+        if (m_result) {
+            try {
+                m_result->close(); // skips the rows left on the wire so the connection can be reused
+            } catch (sql::SQLException &) {
+                m_lease.invalidate();
+            }
+        }
+        m_result.reset();
+        m_statement.reset();
+        m_lease.release();
+    }
+
+}
@@ -0,0 +1,43 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+#include "simple_mariadb/decoder.h"
+
+namespace simple_mariadb::decoder {
+
+    Decoder decoder_for(sql::DataType type) {
+        switch (type) {
+            case sql::INTEGER:
+                return Decoder::INT;
+            case sql::BIGINT:
+                return Decoder::INT64;
+            case sql::BOOLEAN:
+                return Decoder::BOOLEAN;
+            case sql::DOUBLE:
+                return Decoder::DOUBLE;
+            case sql::FLOAT:
+            case sql::REAL: // REAL is often just a synonym for FLOAT
+                return Decoder::FLOAT;
+            default:
+                // Dates, times and every other type use the string representation
+                return Decoder::STRING;
+        }
+    }
+
+    ColumnPlan::ColumnPlan(sql::ResultSetMetaData &meta) {
+        const uint32_t count = meta.getColumnCount();
+        m_columns.reserve(count);
+        for (uint32_t i = 1; i <= count; ++i) {
+            Column column;
+            column.index = static_cast<int32_t>(i);
+            column.name = std::string(meta.getColumnName(i));
+            column.type = static_cast<sql::DataType>(meta.getColumnType(i));
+            column.decoder = decoder_for(column.type);
+            m_columns.push_back(std::move(column));
+        }
+    }
+
+    ColumnPlan::ColumnPlan(std::vector<Column> columns) : m_columns(std::move(columns)) {}
+
+}
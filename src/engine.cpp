@@ -0,0 +1,619 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+#include "simple_mariadb/engine.h"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <mysql.h>
+#include <errmsg.h>
+
+namespace simple_mariadb::engine {
+
+    namespace {
+        const std::chrono::seconds reconnect_delay(1);
+
+        bool is_true(const std::string &value) {
+            return value == "true" || value == "1";
+        }
+
+        /**
+         * Connector/C++ takes its timeouts in milliseconds, Connector/C in whole seconds.
+         */
+        unsigned int to_seconds(const std::string &milliseconds) {
+            try {
+                const unsigned long ms = std::stoul(milliseconds);
+                return static_cast<unsigned int>(ms == 0 ? 0 : (ms + 999) / 1000);
+            } catch (std::exception &) {
+                return 0;
+            }
+        }
+    }
+
+    void set_options(MYSQL *mysql, simple_mariadb::config::MariaDBConfig &config) {
+        for (const auto &[key, value]: config.get_options()) {
+            const std::string &name = key;
+            const std::string &text = value;
+            if (name == "connectTimeout" || name == "socketTimeout") {
+                const unsigned int seconds = to_seconds(text);
+                if (seconds == 0) {
+                    continue;
+                }
+                if (name == "connectTimeout") {
+                    mysql_options(mysql, MYSQL_OPT_CONNECT_TIMEOUT, &seconds);
+                } else {
+                    mysql_options(mysql, MYSQL_OPT_READ_TIMEOUT, &seconds);
+                    mysql_options(mysql, MYSQL_OPT_WRITE_TIMEOUT, &seconds);
+                }
+            } else if (name == "useTls" && is_true(text)) {
+                const my_bool enforce = 1;
+                mysql_options(mysql, MYSQL_OPT_SSL_ENFORCE, &enforce);
+            } else if (name == "tlsKey") {
+                mysql_options(mysql, MYSQL_OPT_SSL_KEY, text.c_str());
+            } else if (name == "tlsCert") {
+                mysql_options(mysql, MYSQL_OPT_SSL_CERT, text.c_str());
+            } else if (name == "tlsCA") {
+                mysql_options(mysql, MYSQL_OPT_SSL_CA, text.c_str());
+            }
+        }
+    }
+
+    void set_socket_options(MYSQL *mysql, simple_mariadb::config::MariaDBConfig &config) {
+        const auto options = config.get_options();
+        const auto keepalive = options.find("tcpKeepAlive");
+        if (keepalive != options.end() && is_true(keepalive->second)) {
+            const int on = 1;
+            setsockopt(mysql_get_socket(mysql), SOL_SOCKET, SO_KEEPALIVE, &on, sizeof(on));
+        }
+    }
+
+    nlohmann::json EngineStats::to_json() const {
+        nlohmann::json j;
+        j["connections"] = connections;
+        j["connected"] = connected;
+        j["busy"] = busy;
+        j["queued"] = queued;
+        j["submitted"] = submitted;
+        j["completed"] = completed;
+        j["failed"] = failed;
+        j["retried"] = retried;
+        j["reconnects"] = reconnects;
+        return j;
+    }
+
+    Engine::Engine(simple_mariadb::config::MariaDBConfig &config, size_t connections) : m_config(config) {
+        m_epoll = epoll_create1(EPOLL_CLOEXEC);
+        m_wakeup = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (m_epoll < 0 || m_wakeup < 0) {
+            const std::string error = std::strerror(errno);
+            this->stop();
+            throw std::runtime_error("simple_mariadb::engine: cannot create the event loop: " + error);
+        }
+        epoll_event wakeup{};
+        wakeup.events = EPOLLIN;
+        wakeup.data.ptr = nullptr;
+        epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wakeup, &wakeup);
+
+        for (size_t i = 0; i < std::max<size_t>(connections, 1); ++i) {
+            auto conn = std::make_unique<Connection>();
+            conn->id = i;
+            conn->mysql = this->m_open();
+            if (conn->mysql == nullptr) {
+                this->stop();
+                throw std::runtime_error("simple_mariadb::engine: out of memory");
+            }
+            if (!mysql_real_connect(conn->mysql, m_config.get_hostname().c_str(), m_config.get_user().c_str(),
+                                    m_config.get_password().c_str(), m_config.get_database().c_str(),
+                                    static_cast<unsigned int>(m_config.get_port()), nullptr, 0)) {
+                const std::string error = mysql_error(conn->mysql);
+                mysql_close(conn->mysql);
+                this->stop();
+                throw std::runtime_error("simple_mariadb::engine: cannot connect: " + error);
+            }
+            set_socket_options(conn->mysql, m_config);
+            conn->up = true;
+            m_connections.push_back(std::move(conn));
+        }
+        m_stats.connections = m_connections.size();
+        m_stats.connected = m_connections.size();
+        m_thread = std::thread(&Engine::m_loop, this);
+    }
+
+    Engine::~Engine() {
+        this->stop();
+    }
+
+    MYSQL *Engine::m_open() {
+        MYSQL *mysql = mysql_init(nullptr);
+        if (mysql != nullptr) {
+            // Enables the *_start / *_cont calls; the blocking calls keep working on the same handle
+            mysql_options(mysql, MYSQL_OPT_NONBLOCK, nullptr);
+            set_options(mysql, m_config);
+        }
+        return mysql;
+    }
+
+    void Engine::submit(std::string sql, Callback callback, std::optional<size_t> key) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_stopping) {
+                throw std::runtime_error("simple_mariadb::engine: the engine is stopped");
+            }
+            if (key) {
+                auto &conn = *m_connections[*key % m_connections.size()];
+                conn.tasks.push_back({std::move(sql), std::move(callback), false});
+            } else {
+                m_tasks.push_back({std::move(sql), std::move(callback), false});
+            }
+            m_pending++;
+            m_stats.submitted++;
+        }
+        const uint64_t one = 1;
+        [[maybe_unused]] auto written = write(m_wakeup, &one, sizeof(one));
+    }
+
+    std::future<Result> Engine::submit(std::string sql) {
+        auto promise = std::make_shared<std::promise<Result>>();
+        auto future = promise->get_future();
+        this->submit(std::move(sql), [promise](Result &&result) { promise->set_value(std::move(result)); });
+        return future;
+    }
+
+    void Engine::wait_below(size_t limit) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait(lock, [this, limit] { return m_pending < std::max<size_t>(limit, 1); });
+    }
+
+    void Engine::wait_idle() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait(lock, [this] { return m_pending == 0; });
+    }
+
+    void Engine::stop() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        if (m_wakeup >= 0) {
+            const uint64_t one = 1;
+            [[maybe_unused]] auto written = write(m_wakeup, &one, sizeof(one));
+        }
+        if (m_thread.joinable()) {
+            m_thread.join();
+        }
+        for (auto &conn: m_connections) {
+            if (conn->result != nullptr) {
+                mysql_free_result(conn->result);
+                conn->result = nullptr;
+            }
+            if (conn->mysql != nullptr) {
+                mysql_close(conn->mysql);
+                conn->mysql = nullptr;
+            }
+        }
+        if (m_epoll >= 0) {
+            close(m_epoll);
+            m_epoll = -1;
+        }
+        if (m_wakeup >= 0) {
+            close(m_wakeup);
+            m_wakeup = -1;
+        }
+    }
+
+    EngineStats Engine::get_stats() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        EngineStats stats = m_stats;
+        stats.queued = m_tasks.size();
+        for (auto &conn: m_connections) {
+            stats.queued += conn->tasks.size();
+        }
+        stats.busy = m_pending - stats.queued;
+        return stats;
+    }
+
+    void Engine::m_loop() {
+        std::vector<epoll_event> events(m_connections.size() + 1);
+        while (true) {
+            bool all_down = true;
+            for (auto &conn: m_connections) {
+                all_down = all_down && !conn->up && conn->state != State::CONNECTING;
+            }
+            std::deque<Task> abandoned;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_stopping && m_pending == 0) {
+                    break;
+                }
+                if (m_stopping && all_down) {
+                    abandoned.swap(m_tasks); // nothing could ever run them
+                }
+                for (auto &conn: m_connections) {
+                    if (m_stopping && !conn->up && conn->state != State::CONNECTING) {
+                        // Statements bound to a connection that is down cannot move to another one
+                        std::move(conn->tasks.begin(), conn->tasks.end(), std::back_inserter(abandoned));
+                        conn->tasks.clear();
+                    }
+                }
+            }
+            for (auto &task: abandoned) {
+                Result result;
+                result.ok = false;
+                result.error_code = CR_SERVER_GONE_ERROR;
+                result.error = "engine stopped while disconnected";
+                try {
+                    task.callback(std::move(result));
+                } catch (std::exception &e) {
+                    m_config.logger->send<simple_logger::LogLevel::ERROR>(
+                            "simple_mariadb::engine: callback failed: " + std::string(e.what()));
+                }
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_pending--;
+                m_stats.failed++;
+                m_cv.notify_all();
+            }
+
+            this->m_dispatch();
+
+            int timeout = -1;
+            auto now = std::chrono::steady_clock::now();
+            for (auto &conn: m_connections) {
+                if (conn->deadline) {
+                    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(*conn->deadline - now).count();
+                    ms = std::max<int64_t>(ms + 1, 0);
+                    timeout = timeout < 0 ? static_cast<int>(ms) : std::min(timeout, static_cast<int>(ms));
+                }
+            }
+            const int ready = epoll_wait(m_epoll, events.data(), static_cast<int>(events.size()), timeout);
+            if (ready < 0 && errno != EINTR) {
+                m_config.logger->send<simple_logger::LogLevel::ERROR>(
+                        "simple_mariadb::engine: epoll_wait failed: " + std::string(std::strerror(errno)));
+            }
+            for (int i = 0; i < ready; ++i) {
+                if (events[i].data.ptr == nullptr) {
+                    uint64_t value = 0;
+                    [[maybe_unused]] auto got = read(m_wakeup, &value, sizeof(value));
+                    continue;
+                }
+                auto &conn = *static_cast<Connection *>(events[i].data.ptr);
+                int status = 0;
+                // A hang up is reported as readable, the library then sees the end of the stream
+                if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                    status |= MYSQL_WAIT_READ;
+                }
+                if (events[i].events & EPOLLOUT) {
+                    status |= MYSQL_WAIT_WRITE;
+                }
+                if (events[i].events & EPOLLPRI) {
+                    status |= MYSQL_WAIT_EXCEPT;
+                }
+                if (conn.fd >= 0) { // not unregistered by an earlier event of this round
+                    this->m_resume(conn, status);
+                }
+            }
+            now = std::chrono::steady_clock::now();
+            for (auto &conn: m_connections) {
+                if (conn->deadline && *conn->deadline <= now) {
+                    conn->deadline.reset();
+                    this->m_resume(*conn, MYSQL_WAIT_TIMEOUT);
+                }
+            }
+        }
+        for (auto &conn: m_connections) {
+            this->m_unregister(*conn);
+        }
+    }
+
+    void Engine::m_dispatch() {
+        for (auto &conn: m_connections) {
+            if (!conn->up || conn->state != State::IDLE || conn->task) {
+                continue;
+            }
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                // Statements routed to this connection first, they keep their order among themselves
+                std::deque<Task> &tasks = conn->tasks.empty() ? m_tasks : conn->tasks;
+                if (tasks.empty()) {
+                    continue;
+                }
+                conn->task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            this->m_start(*conn);
+        }
+    }
+
+    void Engine::m_start(Connection &conn) {
+        conn.state = State::QUERY;
+        const std::string &sql = conn.task->sql;
+        const int status = mysql_real_query_start(&conn.query_result, conn.mysql, sql.data(), sql.size());
+        this->m_advance(conn, status);
+    }
+
+    void Engine::m_resume(Connection &conn, int events) {
+        int status = 0;
+        switch (conn.state) {
+            case State::CONNECTING:
+                status = mysql_real_connect_cont(&conn.connected, conn.mysql, events);
+                break;
+            case State::QUERY:
+                status = mysql_real_query_cont(&conn.query_result, conn.mysql, events);
+                break;
+            case State::STORE:
+            case State::DRAIN:
+                status = mysql_store_result_cont(&conn.result, conn.mysql, events);
+                break;
+            case State::NEXT:
+                status = mysql_next_result_cont(&conn.next_result, conn.mysql, events);
+                break;
+            case State::IDLE:
+                if (!conn.up && (events & MYSQL_WAIT_TIMEOUT)) {
+                    this->m_reconnect(conn); // retry delay of a failed reconnection is over
+                }
+                return;
+        }
+        this->m_advance(conn, status);
+    }
+
+    void Engine::m_advance(Connection &conn, int status) {
+        while (status == 0) {
+            switch (conn.state) {
+                case State::CONNECTING:
+                    this->m_unregister(conn);
+                    conn.state = State::IDLE;
+                    if (conn.connected == nullptr) {
+                        m_config.logger->send<simple_logger::LogLevel::WARNING>(
+                                "simple_mariadb::engine: connection " + std::to_string(conn.id) +
+                                " cannot reconnect: " + std::string(mysql_error(conn.mysql)));
+                        if (conn.task) {
+                            this->m_fail(conn);
+                        }
+                        conn.deadline = std::chrono::steady_clock::now() + reconnect_delay;
+                        return;
+                    }
+                    set_socket_options(conn.mysql, m_config);
+                    this->m_set_up(conn, true);
+                    if (!conn.task) {
+                        return;
+                    }
+                    conn.state = State::QUERY; // the statement the connection was lost on
+                    status = mysql_real_query_start(&conn.query_result, conn.mysql, conn.task->sql.data(),
+                                                    conn.task->sql.size());
+                    break;
+                case State::QUERY:
+                    if (conn.query_result != 0) {
+                        this->m_fail(conn);
+                        return;
+                    }
+                    conn.state = State::STORE;
+                    status = mysql_store_result_start(&conn.result, conn.mysql);
+                    break;
+                case State::STORE:
+                    if (!this->m_complete(conn)) {
+                        return;
+                    }
+                    if (!mysql_more_results(conn.mysql)) {
+                        this->m_finish(conn);
+                        return;
+                    }
+                    // A multi-result statement: the connection is out of sync until every result is read
+                    conn.state = State::NEXT;
+                    status = mysql_next_result_start(&conn.next_result, conn.mysql);
+                    break;
+                case State::NEXT:
+                    if (conn.next_result > 0) { // a later statement of the same query failed
+                        this->m_fail(conn);
+                        return;
+                    }
+                    if (conn.next_result < 0) {
+                        this->m_finish(conn);
+                        return;
+                    }
+                    conn.state = State::DRAIN;
+                    status = mysql_store_result_start(&conn.result, conn.mysql);
+                    break;
+                case State::DRAIN:
+                    if (conn.result != nullptr) {
+                        mysql_free_result(conn.result); // only the first result is reported
+                        conn.result = nullptr;
+                    } else if (mysql_field_count(conn.mysql) != 0) {
+                        this->m_fail(conn);
+                        return;
+                    }
+                    if (!mysql_more_results(conn.mysql)) {
+                        this->m_finish(conn);
+                        return;
+                    }
+                    conn.state = State::NEXT;
+                    status = mysql_next_result_start(&conn.next_result, conn.mysql);
+                    break;
+                case State::IDLE:
+                    return;
+            }
+        }
+        this->m_wait(conn, status);
+    }
+
+    void Engine::m_wait(Connection &conn, int status) {
+        epoll_event event{};
+        if (status & MYSQL_WAIT_READ) {
+            event.events |= EPOLLIN;
+        }
+        if (status & MYSQL_WAIT_WRITE) {
+            event.events |= EPOLLOUT;
+        }
+        if (status & MYSQL_WAIT_EXCEPT) {
+            event.events |= EPOLLPRI;
+        }
+        event.data.ptr = &conn;
+        const int fd = mysql_get_socket(conn.mysql);
+        if (conn.fd != fd) {
+            this->m_unregister(conn);
+            if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &event) == 0) {
+                conn.fd = fd;
+            }
+        } else {
+            epoll_ctl(m_epoll, EPOLL_CTL_MOD, fd, &event);
+        }
+        if (status & MYSQL_WAIT_TIMEOUT) {
+            conn.deadline = std::chrono::steady_clock::now() +
+                            std::chrono::milliseconds(mysql_get_timeout_value_ms(conn.mysql));
+        } else {
+            conn.deadline.reset();
+        }
+    }
+
+    void Engine::m_unregister(Connection &conn) {
+        if (conn.fd >= 0) {
+            epoll_ctl(m_epoll, EPOLL_CTL_DEL, conn.fd, nullptr);
+            conn.fd = -1;
+        }
+        conn.deadline.reset();
+    }
+
+    bool Engine::m_complete(Connection &conn) {
+        Result result;
+        MYSQL_RES *res = conn.result;
+        conn.result = nullptr;
+        if (res != nullptr) {
+            const unsigned int count = mysql_num_fields(res);
+            const MYSQL_FIELD *fields = mysql_fetch_fields(res);
+            std::vector<std::string> names;
+            names.reserve(count);
+            for (unsigned int i = 0; i < count; ++i) {
+                names.emplace_back(fields[i].name);
+            }
+            result.rows.reset(std::move(names));
+            // The result is stored on the client, fetching the rows does no I/O
+            while (MYSQL_ROW row = mysql_fetch_row(res)) {
+                const unsigned long *lengths = mysql_fetch_lengths(res);
+                for (unsigned int i = 0; i < count; ++i) {
+                    if (row[i] == nullptr) {
+                        result.rows.append_null();
+                    } else {
+                        result.rows.append(std::string_view(row[i], lengths[i]));
+                    }
+                }
+            }
+            mysql_free_result(res);
+            result.affected_rows = result.rows.rows();
+        } else if (mysql_field_count(conn.mysql) != 0) {
+            this->m_fail(conn); // the statement has rows but reading them failed
+            return false;
+        } else {
+            result.affected_rows = mysql_affected_rows(conn.mysql);
+            result.insert_id = mysql_insert_id(conn.mysql);
+        }
+        conn.first = std::move(result);
+        return true;
+    }
+
+    void Engine::m_finish(Connection &conn) {
+        this->m_unregister(conn);
+        Result result = std::move(*conn.first);
+        conn.first.reset();
+        this->m_done(conn, std::move(result));
+    }
+
+    void Engine::m_fail(Connection &conn) {
+        this->m_unregister(conn);
+        conn.first.reset();
+        const unsigned int code = mysql_errno(conn.mysql);
+        const bool gone = code == CR_SERVER_GONE_ERROR || code == CR_SERVER_LOST;
+        if (gone && conn.task && code == CR_SERVER_GONE_ERROR && !conn.task->retried) {
+            // The statement never reached the server, it is sent again once the connection is back
+            conn.task->retried = true;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stats.retried++;
+            }
+            this->m_reconnect(conn);
+            return;
+        }
+        Result result;
+        result.ok = false;
+        result.error_code = code;
+        result.error = mysql_error(conn.mysql);
+        if (result.error.empty()) {
+            result.error = "connection " + std::to_string(conn.id) + " is not connected";
+        }
+        conn.state = State::IDLE;
+        if (conn.task) {
+            this->m_done(conn, std::move(result));
+        }
+        if (gone && conn.up) {
+            this->m_reconnect(conn);
+        }
+    }
+
+    void Engine::m_reconnect(Connection &conn) {
+        this->m_unregister(conn);
+        this->m_set_up(conn, false);
+        conn.first.reset();
+        if (conn.result != nullptr) {
+            mysql_free_result(conn.result);
+            conn.result = nullptr;
+        }
+        if (conn.mysql != nullptr) {
+            mysql_close(conn.mysql);
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stats.reconnects++;
+        }
+        conn.state = State::IDLE;
+        conn.mysql = this->m_open();
+        if (conn.mysql == nullptr) {
+            conn.deadline = std::chrono::steady_clock::now() + reconnect_delay;
+            return;
+        }
+        conn.connected = nullptr;
+        conn.state = State::CONNECTING;
+        const int status = mysql_real_connect_start(&conn.connected, conn.mysql, m_config.get_hostname().c_str(),
+                                                    m_config.get_user().c_str(), m_config.get_password().c_str(),
+                                                    m_config.get_database().c_str(),
+                                                    static_cast<unsigned int>(m_config.get_port()), nullptr, 0);
+        this->m_advance(conn, status);
+    }
+
+    void Engine::m_set_up(Connection &conn, bool up) {
+        if (conn.up == up) {
+            return;
+        }
+        conn.up = up;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (up) {
+            m_stats.connected++;
+        } else {
+            m_stats.connected--;
+        }
+    }
+
+    void Engine::m_done(Connection &conn, Result &&result) {
+        Task task = std::move(*conn.task);
+        conn.task.reset();
+        conn.state = State::IDLE;
+        const bool ok = result.ok;
+        try {
+            task.callback(std::move(result));
+        } catch (std::exception &e) {
+            m_config.logger->send<simple_logger::LogLevel::ERROR>(
+                    "simple_mariadb::engine: callback failed: " + std::string(e.what()));
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending--;
+        if (ok) {
+            m_stats.completed++;
+        } else {
+            m_stats.failed++;
+        }
+        m_cv.notify_all();
+    }
+
+}
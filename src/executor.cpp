@@ -0,0 +1,90 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+#include "simple_mariadb/executor.h"
+#include <stdexcept>
+
+namespace simple_mariadb::executor {
+
+    nlohmann::json ExecutorStats::to_json() const {
+        nlohmann::json j;
+        j["threads"] = threads;
+        j["queued"] = queued;
+        j["running"] = running;
+        j["submitted"] = submitted;
+        j["completed"] = completed;
+        return j;
+    }
+
+    Executor::Executor(size_t threads) {
+        if (threads == 0) {
+            threads = 1;
+        }
+        m_threads.reserve(threads);
+        for (size_t i = 0; i < threads; ++i) {
+            m_threads.emplace_back(&Executor::m_run, this);
+        }
+    }
+
+    Executor::~Executor() {
+        this->stop();
+    }
+
+    void Executor::post(std::function<void()> job) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_stopped) {
+                throw std::runtime_error("simple_mariadb::executor: the executor is stopped");
+            }
+            m_jobs.push_back(std::move(job));
+            m_submitted++;
+        }
+        m_cv.notify_one();
+    }
+
+    void Executor::stop() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopped = true;
+        }
+        m_cv.notify_all();
+        for (auto &thread: m_threads) {
+            if (thread.joinable()) {
+                thread.join();
+            }
+        }
+    }
+
+    void Executor::m_run() {
+        while (true) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_cv.wait(lock, [this] { return m_stopped || !m_jobs.empty(); });
+                if (m_jobs.empty()) {
+                    return; // stopped and drained
+                }
+                job = std::move(m_jobs.front());
+                m_jobs.pop_front();
+                m_running++;
+            }
+            job();
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_running--;
+            m_completed++;
+        }
+    }
+
+    ExecutorStats Executor::get_stats() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ExecutorStats stats;
+        stats.threads = m_threads.size();
+        stats.queued = m_jobs.size();
+        stats.running = m_running;
+        stats.submitted = m_submitted;
+        stats.completed = m_completed;
+        return stats;
+    }
+
+}
@@ -0,0 +1,232 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+#include "simple_mariadb/loader.h"
+#include "simple_mariadb/engine.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <mysql.h>
+
+namespace simple_mariadb::loader {
+
+    double LoadStats::rows_per_second() const {
+        return elapsed_us == 0 ? 0.0 : static_cast<double>(rows) * 1e6 / static_cast<double>(elapsed_us);
+    }
+
+    double LoadStats::bytes_per_second() const {
+        return elapsed_us == 0 ? 0.0 : static_cast<double>(bytes) * 1e6 / static_cast<double>(elapsed_us);
+    }
+
+    nlohmann::json LoadStats::to_json() const {
+        nlohmann::json j;
+        j["rows"] = rows;
+        j["affected"] = affected;
+        j["bytes"] = bytes;
+        j["chunks"] = chunks;
+        j["elapsed_us"] = elapsed_us;
+        j["rows_per_second"] = rows_per_second();
+        j["bytes_per_second"] = bytes_per_second();
+        return j;
+    }
+
+    template<typename T>
+    static void append_number(std::string &out, T value) {
+        char buffer[32];
+        auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        out.append(buffer, end);
+    }
+
+    void append_field(std::string &out, const simple_mariadb::rows::Value &value) {
+        std::visit([&out](const auto &held) {
+            using U = std::decay_t<decltype(held)>;
+            if constexpr (std::is_same_v<U, std::nullptr_t>) {
+                out += "\\N";
+            } else if constexpr (std::is_same_v<U, bool>) {
+                out += held ? '1' : '0';
+            } else if constexpr (std::is_same_v<U, std::string>) {
+                for (char c: held) {
+                    switch (c) {
+                        case '\\':
+                            out += "\\\\";
+                            break;
+                        case '\t':
+                            out += "\\t";
+                            break;
+                        case '\n':
+                            out += "\\n";
+                            break;
+                        case '\r':
+                            out += "\\r";
+                            break;
+                        case '\0':
+                            out += "\\0";
+                            break;
+                        default:
+                            out += c;
+                    }
+                }
+            } else {
+                append_number(out, held);
+            }
+        }, value);
+    }
+
+    void append_row(std::string &out, const std::vector<simple_mariadb::rows::Value> &row) {
+        for (size_t i = 0; i < row.size(); ++i) {
+            if (i > 0) {
+                out += '\t';
+            }
+            append_field(out, row[i]);
+        }
+        out += '\n';
+    }
+
+    std::string load_statement(const std::string &table, const std::vector<std::string> &columns, InsertType type) {
+        std::string statement = "LOAD DATA LOCAL INFILE 'simple_mariadb_stream' ";
+        switch (type) {
+            case InsertType::REPLACE:
+                statement += "REPLACE ";
+                break;
+            case InsertType::IGNORE:
+                statement += "IGNORE ";
+                break;
+            default:
+                break;
+        }
+        statement += "INTO TABLE `" + table + "` CHARACTER SET utf8mb4 (";
+        for (const auto &column: columns) {
+            statement += "`" + column + "`,";
+        }   // Remove last comma
+        statement.pop_back();
+        statement += ")";
+        return statement;
+    }
+
+    namespace {
+
+        /**
+         * State shared with the local infile callbacks of one load.
+         */
+        struct Stream {
+            Stream(const RowSource &source, size_t columns, size_t chunk_size, LoadStats &stats) :
+                    source(source), columns(columns), chunk_size(chunk_size), stats(stats) {}
+
+            const RowSource &source;
+            const size_t columns;
+            const size_t chunk_size;
+            LoadStats &stats;
+            std::string chunk;
+            size_t offset = 0;
+            bool done = false;
+            std::string error;
+            std::vector<simple_mariadb::rows::Value> row;
+
+            /**
+             * Formats the next chunk of rows. False at the end of the source or on error.
+             */
+            bool fill() {
+                chunk.clear();
+                offset = 0;
+                while (!done && chunk.size() < chunk_size) {
+                    row.clear();
+                    try {
+                        if (!source(row)) {
+                            done = true;
+                            break;
+                        }
+                    } catch (std::exception &e) {
+                        error = "Row source failed: " + std::string(e.what());
+                        return false;
+                    }
+                    if (row.size() != columns) {
+                        error = "Row " + std::to_string(stats.rows + 1) + " has " + std::to_string(row.size()) +
+                                " values, expected " + std::to_string(columns);
+                        return false;
+                    }
+                    append_row(chunk, row);
+                    stats.rows++;
+                }
+                if (chunk.empty()) {
+                    return false;
+                }
+                stats.chunks++;
+                return true;
+            }
+        };
+
+        int stream_init(void **ptr, const char *, void *userdata) {
+            *ptr = userdata;
+            return 0;
+        }
+
+        int stream_read(void *ptr, char *buf, unsigned int buf_len) {
+            auto *stream = static_cast<Stream *>(ptr);
+            if (stream->offset == stream->chunk.size() && !stream->fill()) {
+                return stream->error.empty() ? 0 : -1;
+            }
+            size_t size = std::min<size_t>(buf_len, stream->chunk.size() - stream->offset);
+            std::memcpy(buf, stream->chunk.data() + stream->offset, size);
+            stream->offset += size;
+            stream->stats.bytes += size;
+            return static_cast<int>(size);
+        }
+
+        void stream_end(void *) {}
+
+        int stream_error(void *ptr, char *buf, unsigned int buf_len) {
+            auto *stream = static_cast<Stream *>(ptr);
+            if (buf_len > 0) {
+                size_t size = std::min<size_t>(buf_len - 1, stream->error.size());
+                std::memcpy(buf, stream->error.data(), size);
+                buf[size] = '\0';
+            }
+            return 2000; // CR_UNKNOWN_ERROR
+        }
+
+    }
+
+    LoadStats load_data(simple_mariadb::config::MariaDBConfig &config, const std::string &table,
+                        const std::vector<std::string> &columns, const RowSource &source,
+                        size_t chunk_size, InsertType type) {
+        if (columns.empty()) {
+            throw std::runtime_error("LOAD DATA into " + table + " needs at least one column");
+        }
+        std::unique_ptr<MYSQL, decltype(&mysql_close)> mysql(mysql_init(nullptr), &mysql_close);
+        if (!mysql) {
+            throw std::runtime_error("LOAD DATA into " + table + ": out of memory");
+        }
+        unsigned int local_infile = 1;
+        mysql_options(mysql.get(), MYSQL_OPT_LOCAL_INFILE, &local_infile);
+        // Same timeouts, TLS and keepalive as the Connector/C++ connections
+        simple_mariadb::engine::set_options(mysql.get(), config);
+        if (!mysql_real_connect(mysql.get(), config.get_hostname().c_str(), config.get_user().c_str(),
+                                config.get_password().c_str(), config.get_database().c_str(),
+                                static_cast<unsigned int>(config.get_port()), nullptr, CLIENT_LOCAL_FILES)) {
+            throw std::runtime_error("LOAD DATA into " + table + " cannot connect: " + mysql_error(mysql.get()));
+        }
+        simple_mariadb::engine::set_socket_options(mysql.get(), config);
+
+        LoadStats stats;
+        Stream stream(source, columns.size(), std::max<size_t>(chunk_size, 1), stats);
+        stream.chunk.reserve(stream.chunk_size + 1024);
+        mysql_set_local_infile_handler(mysql.get(), stream_init, stream_read, stream_end, stream_error, &stream);
+
+        std::string statement = load_statement(table, columns, type);
+        auto start = std::chrono::steady_clock::now();
+        int result = mysql_real_query(mysql.get(), statement.c_str(), statement.size());
+        stats.elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start).count();
+        if (result != 0) {
+            std::string error = stream.error.empty() ? std::string(mysql_error(mysql.get())) : stream.error;
+            throw std::runtime_error("LOAD DATA into " + table + " failed: " + error);
+        }
+        stats.affected = mysql_affected_rows(mysql.get());
+        return stats;
+    }
+
+}
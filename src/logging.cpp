@@ -0,0 +1,80 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+#include "simple_mariadb/logging.h"
+#include <algorithm>
+
+namespace simple_mariadb::logging {
+
+    bool parse_level(std::string_view name, LogLevel &level) {
+        std::string lower(name);
+        for (char &c: lower) {
+            c = (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+        }
+        if (lower == "emergency") {
+            level = LogLevel::EMERGENCY;
+        } else if (lower == "alert") {
+            level = LogLevel::ALERT;
+        } else if (lower == "critical") {
+            level = LogLevel::CRITICAL;
+        } else if (lower == "error") {
+            level = LogLevel::ERROR;
+        } else if (lower == "warning") {
+            level = LogLevel::WARNING;
+        } else if (lower == "notice") {
+            level = LogLevel::NOTICE;
+        } else if (lower == "info" || lower == "informational") {
+            level = LogLevel::INFORMATIONAL;
+        } else if (lower == "debug") {
+            level = LogLevel::DEBUG;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    Log::Log(std::shared_ptr<simple_logger::Logger> logger, std::string_view level_name) :
+            m_logger(std::move(logger)) {
+        parse_level(level_name, m_level);
+    }
+
+    RateLimiter::RateLimiter(size_t per_second) :
+            m_per_second(std::min<size_t>(per_second, COUNT_MASK)),
+            m_start(std::chrono::steady_clock::now()) {}
+
+    bool RateLimiter::allow(size_t &suppressed) {
+        suppressed = 0;
+        if (m_per_second != 0) {
+            const auto second = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::seconds>(
+                    std::chrono::steady_clock::now() - m_start).count());
+            const uint64_t tag = second << COUNT_BITS;
+            uint64_t current = m_window.load(std::memory_order_relaxed);
+            uint64_t next;
+            do {
+                const uint64_t count = (current & ~COUNT_MASK) == tag ? current & COUNT_MASK : 0;
+                if (count >= m_per_second) {
+                    m_pending.fetch_add(1, std::memory_order_relaxed);
+                    m_suppressed.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+                next = tag | (count + 1);
+            } while (!m_window.compare_exchange_weak(current, next, std::memory_order_relaxed));
+        }
+        suppressed = m_pending.exchange(0, std::memory_order_relaxed);
+        return true;
+    }
+
+    std::string abbreviate(std::string_view query, size_t max_length) {
+        if (max_length == 0 || query.size() <= max_length) {
+            return std::string(query);
+        }
+        std::string result(query.substr(0, max_length));
+        result += "... (" + std::to_string(query.size() - max_length) + " more bytes)";
+        return result;
+    }
+
+    QueryLog::QueryLog(const Log &log, size_t per_second, size_t max_length) :
+            m_log(log), m_limiter(per_second), m_max_length(max_length) {}
+
+}
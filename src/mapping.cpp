@@ -0,0 +1,35 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+#include "simple_mariadb/mapping.h"
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+
+namespace simple_mariadb::mapping {
+
+    namespace {
+        bool same_name(std::string_view a, std::string_view b) {
+            return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+                return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+            });
+        }
+    }
+
+    int32_t column_index(sql::ResultSetMetaData &meta, std::string_view column) {
+        const uint32_t count = meta.getColumnCount();
+        for (uint32_t i = 1; i <= count; ++i) {
+            if (same_name(std::string(meta.getColumnLabel(i)), column)) {
+                return static_cast<int32_t>(i);
+            }
+        }
+        for (uint32_t i = 1; i <= count; ++i) {
+            if (same_name(std::string(meta.getColumnName(i)), column)) {
+                return static_cast<int32_t>(i);
+            }
+        }
+        throw std::runtime_error("simple_mariadb::mapping: column " + std::string(column) + " is not in the result");
+    }
+
+}
@@ -0,0 +1,154 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+#include "simple_mariadb/metrics.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace simple_mariadb::metrics {
+
+    nlohmann::json HistogramSnapshot::to_json() const {
+        nlohmann::json j;
+        j["count"] = count;
+        j["min"] = min;
+        j["max"] = max;
+        j["mean"] = mean;
+        j["p50"] = p50;
+        j["p90"] = p90;
+        j["p99"] = p99;
+        j["p999"] = p999;
+        return j;
+    }
+
+    size_t Histogram::bucket_index(uint64_t value) {
+        if (value < SUB_BUCKETS) {
+            return static_cast<size_t>(value);
+        }
+        const auto msb = static_cast<unsigned>(std::bit_width(value) - 1);
+        if (msb >= MAX_VALUE_BITS) {
+            return BUCKETS - 1;
+        }
+        const unsigned shift = msb - SUB_BUCKET_BITS;
+        return static_cast<size_t>(SUB_BUCKETS * (shift + 1) + ((value >> shift) - SUB_BUCKETS));
+    }
+
+    uint64_t Histogram::bucket_upper(size_t index) {
+        if (index < SUB_BUCKETS) {
+            return index;
+        }
+        const auto shift = static_cast<unsigned>(index / SUB_BUCKETS - 1);
+        const uint64_t mantissa = index % SUB_BUCKETS + SUB_BUCKETS;
+        return ((mantissa + 1) << shift) - 1;
+    }
+
+    void Histogram::record(uint64_t value) {
+        // min and max first: a snapshot that sees the bucket count also sees them
+        uint64_t current = m_min.load(std::memory_order_relaxed);
+        while (value < current && !m_min.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+        current = m_max.load(std::memory_order_relaxed);
+        while (value > current && !m_max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+        m_sum.fetch_add(value, std::memory_order_relaxed);
+        m_buckets[bucket_index(value)].fetch_add(1, std::memory_order_release);
+    }
+
+    void Histogram::record_since(std::chrono::steady_clock::time_point start) {
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        this->record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+
+    HistogramSnapshot Histogram::snapshot() const {
+        std::array<uint64_t, BUCKETS> counts{};
+        HistogramSnapshot snapshot;
+        for (size_t i = 0; i < BUCKETS; ++i) {
+            counts[i] = m_buckets[i].load(std::memory_order_acquire);
+            snapshot.count += counts[i];
+        }
+        if (snapshot.count == 0) {
+            return snapshot;
+        }
+        snapshot.min = m_min.load(std::memory_order_relaxed);
+        snapshot.max = m_max.load(std::memory_order_relaxed);
+        snapshot.mean = static_cast<double>(m_sum.load(std::memory_order_relaxed)) /
+                        static_cast<double>(snapshot.count);
+
+        const std::array<double, 4> quantiles{0.5, 0.9, 0.99, 0.999};
+        const std::array<uint64_t *, 4> targets{&snapshot.p50, &snapshot.p90, &snapshot.p99, &snapshot.p999};
+        size_t next = 0;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKETS && next < quantiles.size(); ++i) {
+            seen += counts[i];
+            while (next < quantiles.size() &&
+                   seen >= std::max<uint64_t>(1, static_cast<uint64_t>(
+                           std::ceil(quantiles[next] * static_cast<double>(snapshot.count))))) {
+                const uint64_t upper = bucket_upper(i);
+                // A reset() racing with the snapshot can leave min above max
+                *targets[next++] = snapshot.min <= snapshot.max ? std::clamp(upper, snapshot.min, snapshot.max)
+                                                                : upper;
+            }
+        }
+        return snapshot;
+    }
+
+    void Histogram::reset() {
+        for (auto &bucket: m_buckets) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        m_sum.store(0, std::memory_order_relaxed);
+        m_min.store(UINT64_MAX, std::memory_order_relaxed);
+        m_max.store(0, std::memory_order_relaxed);
+    }
+
+    nlohmann::json RateSnapshot::to_json() const {
+        nlohmann::json j;
+        j["total"] = total;
+        j["per_second"] = per_second;
+        j["average"] = average;
+        return j;
+    }
+
+    RateMeter::RateMeter() : m_start(std::chrono::steady_clock::now()) {}
+
+    uint64_t RateMeter::m_second() const {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::steady_clock::now() - m_start).count());
+    }
+
+    void RateMeter::add(uint64_t events) {
+        m_total.fetch_add(events, std::memory_order_relaxed);
+        const uint64_t second = this->m_second();
+        const uint64_t tag = second << COUNT_BITS;
+        auto &slot = m_slots[second % SLOTS];
+        uint64_t current = slot.load(std::memory_order_relaxed);
+        uint64_t next;
+        do {
+            next = (current & ~COUNT_MASK) == tag ? current + events : tag | events;
+        } while (!slot.compare_exchange_weak(current, next, std::memory_order_relaxed));
+    }
+
+    RateSnapshot RateMeter::snapshot() const {
+        RateSnapshot snapshot;
+        snapshot.total = m_total.load(std::memory_order_relaxed);
+        const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+        if (elapsed > 0) {
+            snapshot.average = static_cast<double>(snapshot.total) / elapsed;
+        }
+        const uint64_t now = this->m_second();
+        const uint64_t window = std::min<uint64_t>(WINDOW_SECONDS, now);
+        if (window == 0) { // no complete second yet
+            snapshot.per_second = snapshot.average;
+            return snapshot;
+        }
+        uint64_t events = 0;
+        for (uint64_t second = now - window; second < now; ++second) {
+            const uint64_t value = m_slots[second % SLOTS].load(std::memory_order_relaxed);
+            if ((value & ~COUNT_MASK) == (second << COUNT_BITS)) {
+                events += value & COUNT_MASK;
+            }
+        }
+        snapshot.per_second = static_cast<double>(events) / static_cast<double>(window);
+        return snapshot;
+    }
+
+}
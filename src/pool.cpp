@@ -0,0 +1,265 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+#include "simple_mariadb/pool.h"
+#include <algorithm>
+
+namespace simple_mariadb::pool {
+
+    double PoolStats::utilization() const {
+        if (max_size == 0) {
+            return 0.0;
+        }
+        return static_cast<double>(in_use) / static_cast<double>(max_size);
+    }
+
+    double PoolStats::average_wait_us() const {
+        if (waited == 0) {
+            return 0.0;
+        }
+        return static_cast<double>(total_wait_us) / static_cast<double>(waited);
+    }
+
+    nlohmann::json PoolStats::to_json() const {
+        nlohmann::json j;
+        j["size"] = size;
+        j["idle"] = idle;
+        j["in_use"] = in_use;
+        j["peak_in_use"] = peak_in_use;
+        j["min_size"] = min_size;
+        j["max_size"] = max_size;
+        j["acquired"] = acquired;
+        j["waited"] = waited;
+        j["timeouts"] = timeouts;
+        j["created"] = created;
+        j["discarded"] = discarded;
+        j["total_wait_us"] = total_wait_us;
+        j["max_wait_us"] = max_wait_us;
+        j["acquire_ns"] = acquire_ns.to_json();
+        j["utilization"] = utilization();
+        return j;
+    }
+
+    ConnectionPool::Lease::Lease(ConnectionPool *pool, Connection conn, StatementCachePtr statements) :
+            m_pool(pool), m_conn(std::move(conn)), m_statements(std::move(statements)) {}
+
+    ConnectionPool::Lease::Lease(Lease &&other) noexcept:
+            m_pool(other.m_pool), m_conn(std::move(other.m_conn)), m_statements(std::move(other.m_statements)),
+            m_valid(other.m_valid) {
+        other.m_pool = nullptr;
+    }
+
+    ConnectionPool::Lease &ConnectionPool::Lease::operator=(Lease &&other) noexcept {
+        if (this != &other) {
+            this->release();
+            m_pool = other.m_pool;
+            m_conn = std::move(other.m_conn);
+            m_statements = std::move(other.m_statements);
+            m_valid = other.m_valid;
+            other.m_pool = nullptr;
+        }
+        return *this;
+    }
+
+    ConnectionPool::Lease::~Lease() {
+        this->release();
+    }
+
+    void ConnectionPool::Lease::release() {
+        if (m_pool != nullptr) {
+            m_pool->m_release({std::move(m_conn), std::move(m_statements)}, m_valid);
+            m_pool = nullptr;
+        }
+        m_conn.reset();
+        m_statements.reset();
+    }
+
+    ConnectionPool::ConnectionPool(size_t min_size, size_t max_size, std::chrono::milliseconds timeout,
+                                   Factory factory, Validator validator, size_t statement_cache_size) :
+            m_min_size(min_size),
+            m_max_size(std::max(min_size, max_size)),
+            m_timeout(timeout),
+            m_factory(std::move(factory)),
+            m_validator(std::move(validator)),
+            m_statement_cache_size(statement_cache_size) {
+        m_stats.min_size = m_min_size;
+        m_stats.max_size = m_max_size;
+        for (size_t i = 0; i < m_min_size; ++i) {
+            Slot slot = this->m_create();
+            if (slot.conn == nullptr) {
+                continue; // the checker or the next acquire() will retry
+            }
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_idle.push_back(std::move(slot));
+            m_size++;
+        }
+    }
+
+    ConnectionPool::Slot ConnectionPool::m_create() {
+        Connection conn = m_factory();
+        if (conn == nullptr) {
+            return {};
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stats.created++;
+        }
+        return {std::move(conn),
+                std::make_shared<simple_mariadb::statement::StatementCache>(m_statement_cache_size)};
+    }
+
+    ConnectionPool::Lease ConnectionPool::acquire() {
+        const auto start = std::chrono::steady_clock::now();
+        const auto deadline = start + m_timeout;
+        bool waited = false;
+        Slot slot;
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (slot.conn == nullptr) {
+            // Drop idle connections the driver already knows are closed, isClosed() does not hit the network
+            while (!m_idle.empty() && (m_idle.front().conn == nullptr || m_idle.front().conn->isClosed())) {
+                m_idle.pop_front();
+                m_size--;
+                m_stats.discarded++;
+            }
+            if (!m_idle.empty()) {
+                slot = std::move(m_idle.front());
+                m_idle.pop_front();
+                break;
+            }
+            if (m_size < m_max_size) {
+                // Reserve the slot before connecting so concurrent callers do not overshoot max_size
+                m_size++;
+                lock.unlock();
+                slot = this->m_create();
+                lock.lock();
+                if (slot.conn == nullptr) {
+                    m_size--;
+                    m_cv.notify_one();
+                    throw std::runtime_error("ConnectionPool failed to open a new connection");
+                }
+                break;
+            }
+            waited = true;
+            if (m_cv.wait_until(lock, deadline) == std::cv_status::timeout &&
+                m_idle.empty() && m_size >= m_max_size) {
+                m_stats.timeouts++;
+                throw std::runtime_error("ConnectionPool checkout timeout after " +
+                                         std::to_string(m_timeout.count()) + " ms");
+            }
+        }
+
+        m_in_use++;
+        m_stats.acquired++;
+        m_stats.peak_in_use = std::max(m_stats.peak_in_use, m_in_use);
+        if (waited) {
+            auto wait_us = static_cast<size_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - start).count());
+            m_stats.waited++;
+            m_stats.total_wait_us += wait_us;
+            m_stats.max_wait_us = std::max(m_stats.max_wait_us, wait_us);
+        }
+        lock.unlock();
+        m_acquire.record_since(start);
+        return {this, std::move(slot.conn), std::move(slot.statements)};
+    }
+
+    void ConnectionPool::m_release(Slot slot, bool valid) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_in_use--;
+            if (valid && slot.conn != nullptr) {
+                m_idle.push_back(std::move(slot));
+            } else {
+                m_size--;
+                m_stats.discarded++;
+            }
+        }
+        m_cv.notify_one();
+    }
+
+    void ConnectionPool::check_idle() {
+        size_t count;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            count = m_idle.size();
+        }
+        // One connection at a time: the others stay available to acquire() while it is pinged
+        for (size_t i = 0; i < count; ++i) {
+            Slot slot;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_idle.empty()) {
+                    break;
+                }
+                slot = std::move(m_idle.front());
+                m_idle.pop_front();
+                m_checking++;
+            }
+            const bool healthy = slot.conn != nullptr && m_validator(slot.conn);
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_checking--;
+                if (healthy) {
+                    m_idle.push_back(std::move(slot));
+                } else {
+                    // Dropped right away, acquire() may open its own connection instead of waiting for a reconnect
+                    m_size--;
+                    m_stats.discarded++;
+                }
+            }
+            m_cv.notify_one();
+        }
+        // Refill up to min_size, the dropped connections and earlier failed connects
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (m_size < m_min_size) {
+            m_size++;
+            lock.unlock();
+            Slot slot = this->m_create();
+            lock.lock();
+            if (slot.conn == nullptr) {
+                m_size--;
+                break;
+            }
+            m_idle.push_back(std::move(slot));
+            m_cv.notify_one();
+        }
+    }
+
+    bool ConnectionPool::is_connected() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_in_use > 0 || m_checking > 0) {
+            return true;
+        }
+        return std::any_of(m_idle.begin(), m_idle.end(),
+                           [](const Slot &slot) { return slot.conn != nullptr && !slot.conn->isClosed(); });
+    }
+
+    PoolStats ConnectionPool::get_stats() {
+        PoolStats stats;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            stats = m_stats;
+            stats.size = m_size;
+            stats.idle = m_idle.size();
+            stats.in_use = m_in_use;
+        }
+        stats.acquire_ns = m_acquire.snapshot();
+        return stats;
+    }
+
+    simple_mariadb::metrics::HistogramSnapshot ConnectionPool::get_acquire_latency() const {
+        return m_acquire.snapshot();
+    }
+
+    simple_mariadb::statement::StatementCacheStats ConnectionPool::get_statement_stats() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        simple_mariadb::statement::StatementCacheStats stats;
+        for (const auto &slot: m_idle) {
+            stats += slot.statements->get_stats();
+        }
+        return stats;
+    }
+
+}
@@ -0,0 +1,174 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+#include "simple_mariadb/queue.h"
+#include "simple_mariadb/config.h"
+
+namespace simple_mariadb::queue {
+
+    bool parse_backend(const std::string &name, Backend &backend) {
+        if (name == "mutex") {
+            backend = Backend::MUTEX;
+        } else if (name == "ring") {
+            backend = Backend::RING;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    bool parse_overflow_policy(const std::string &name, OverflowPolicy &policy) {
+        if (name == "block") {
+            policy = OverflowPolicy::BLOCK;
+        } else if (name == "drop_newest") {
+            policy = OverflowPolicy::DROP_NEWEST;
+        } else if (name == "drop_oldest") {
+            policy = OverflowPolicy::DROP_OLDEST;
+        } else if (name == "reject") {
+            policy = OverflowPolicy::REJECT;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    std::string to_string(Backend backend) {
+        switch (backend) {
+            case Backend::RING:
+                return "ring";
+            case Backend::MUTEX:
+            default:
+                return "mutex";
+        }
+    }
+
+    std::string to_string(OverflowPolicy policy) {
+        switch (policy) {
+            case OverflowPolicy::DROP_NEWEST:
+                return "drop_newest";
+            case OverflowPolicy::DROP_OLDEST:
+                return "drop_oldest";
+            case OverflowPolicy::REJECT:
+                return "reject";
+            case OverflowPolicy::BLOCK:
+            default:
+                return "block";
+        }
+    }
+
+    nlohmann::json QueueStats::to_json() const {
+        nlohmann::json j;
+        j["backend"] = backend;
+        j["policy"] = policy;
+        j["capacity"] = capacity;
+        j["size"] = size;
+        j["enqueued"] = enqueued;
+        j["dequeued"] = dequeued;
+        j["blocked"] = blocked;
+        j["block_timeouts"] = block_timeouts;
+        j["dropped_newest"] = dropped_newest;
+        j["dropped_oldest"] = dropped_oldest;
+        j["rejected"] = rejected;
+        return j;
+    }
+
+    QueryQueue::QueryQueue(const simple_mariadb::config::MariaDBConfig &config) {
+        OverflowPolicy policy = OverflowPolicy::BLOCK;
+        parse_backend(config.queue_backend, m_backend);
+        parse_overflow_policy(config.queue_overflow_policy, policy);
+        if (m_backend == Backend::RING) {
+            m_ring_queue = std::make_unique<RingQueue<std::string>>(
+                    config.queue_size, policy, std::chrono::seconds(config.queue_timeout));
+        } else {
+            m_mutex_queue = std::make_unique<::common::ThreadQueueWithMaxSize<std::string>>(
+                    config.queue_size, config.queue_timeout);
+        }
+    }
+
+    bool QueryQueue::enqueue(const std::string &query) {
+        return this->enqueue(std::string(query));
+    }
+
+    bool QueryQueue::enqueue(std::string &&query) {
+        if (m_ring_queue) {
+            return m_ring_queue->enqueue(std::move(query));
+        }
+        if (!m_mutex_queue->enqueue(std::move(query))) {
+            m_rejected++;
+            return false;
+        }
+        return true;
+    }
+
+    size_t QueryQueue::enqueue_bulk(std::vector<std::string> &queries) {
+        if (m_ring_queue) {
+            return m_ring_queue->enqueue_bulk(queries.data(), queries.size());
+        }
+        for (size_t i = 0; i < queries.size(); ++i) {
+            if (!m_mutex_queue->enqueue(std::move(queries[i]))) {
+                m_rejected++;
+                return i;
+            }
+        }
+        return queries.size();
+    }
+
+    bool QueryQueue::dequeue_blocking(std::string &query) {
+        if (m_ring_queue) {
+            return m_ring_queue->dequeue_blocking(query);
+        }
+        return m_mutex_queue->dequeue_blocking(query);
+    }
+
+    bool QueryQueue::dequeue_for(std::string &query, std::chrono::milliseconds timeout) {
+        if (m_ring_queue) {
+            return m_ring_queue->dequeue_for(query, timeout);
+        }
+        if (m_mutex_queue->dequeue(query)) {
+            return true;
+        }
+        Backoff backoff(timeout);
+        while (backoff.wait()) {
+            if (m_mutex_queue->dequeue(query)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    size_t QueryQueue::size() {
+        if (m_ring_queue) {
+            return m_ring_queue->size();
+        }
+        return m_mutex_queue->size();
+    }
+
+    void QueryQueue::wipeout() {
+        if (m_ring_queue) {
+            m_ring_queue->wipeout();
+        } else {
+            m_mutex_queue->wipeout();
+        }
+    }
+
+    ::common::Stats QueryQueue::get_stats() {
+        if (m_ring_queue) {
+            return {};
+        }
+        return m_mutex_queue->get_stats();
+    }
+
+    QueueStats QueryQueue::get_queue_stats() {
+        if (m_ring_queue) {
+            return m_ring_queue->get_stats();
+        }
+        QueueStats stats;
+        stats.backend = to_string(Backend::MUTEX);
+        stats.policy = to_string(OverflowPolicy::BLOCK);
+        stats.size = m_mutex_queue->size();
+        stats.rejected = m_rejected;
+        return stats;
+    }
+
+}
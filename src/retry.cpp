@@ -0,0 +1,243 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+#include "simple_mariadb/retry.h"
+#include <stdexcept>
+
+namespace simple_mariadb::retry {
+
+    ErrorClass classify(int error_code, std::string_view sql_state) {
+        if (sql_state.substr(0, 2) == "08" || sql_state == "40001") {
+            return ErrorClass::TRANSIENT;
+        }
+        switch (error_code) {
+            case 0:    // connector error without a server answer
+            case 1021: // ER_DISK_FULL
+            case 1040: // ER_CON_COUNT_ERROR
+            case 1053: // ER_SERVER_SHUTDOWN
+            case 1077: // ER_NORMAL_SHUTDOWN
+            case 1114: // ER_RECORD_FILE_FULL
+            case 1152: // ER_ABORTING_CONNECTION
+            case 1154: // ER_NET_READ_ERROR_FROM_PIPE
+            case 1155: // ER_NET_FCNTL_ERROR
+            case 1156: // ER_NET_PACKETS_OUT_OF_ORDER
+            case 1157: // ER_NET_UNCOMPRESS_ERROR
+            case 1158: // ER_NET_READ_ERROR
+            case 1159: // ER_NET_READ_INTERRUPTED
+            case 1160: // ER_NET_ERROR_ON_WRITE
+            case 1161: // ER_NET_WRITE_INTERRUPTED
+            case 1205: // ER_LOCK_WAIT_TIMEOUT
+            case 1213: // ER_LOCK_DEADLOCK
+            case 1290: // ER_OPTION_PREVENTS_STATEMENT, read only during a failover
+            case 1317: // ER_QUERY_INTERRUPTED
+            case 1836: // ER_READ_ONLY_MODE
+            case 1927: // ER_CONNECTION_KILLED
+            case 1969: // ER_STATEMENT_TIMEOUT
+            case 2002: // CR_CONNECTION_ERROR
+            case 2003: // CR_CONN_HOST_ERROR
+            case 2006: // CR_SERVER_GONE_ERROR
+            case 2013: // CR_SERVER_LOST
+            case 2055: // CR_SERVER_LOST_EXTENDED
+            case 3024: // ER_QUERY_TIMEOUT
+                return ErrorClass::TRANSIENT;
+            default:
+                return ErrorClass::PERMANENT;
+        }
+    }
+
+    std::string to_string(ErrorClass error_class) {
+        return error_class == ErrorClass::TRANSIENT ? "transient" : "permanent";
+    }
+
+    std::chrono::milliseconds Policy::backoff(size_t attempt) const {
+        std::chrono::milliseconds delay = initial_backoff;
+        for (size_t i = 2; i < attempt && delay < max_backoff; ++i) {
+            delay *= 2;
+        }
+        return std::min(delay, max_backoff);
+    }
+
+    nlohmann::json DeadLetter::to_json() const {
+        nlohmann::json j;
+        j["statement"] = statement;
+        j["attempts"] = attempts;
+        j["error_code"] = failure.error_code;
+        j["sql_state"] = failure.sql_state;
+        j["error"] = failure.message;
+        j["reason"] = reason;
+        j["time_ms"] = std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
+        return j;
+    }
+
+    nlohmann::json RetryStats::to_json() const {
+        nlohmann::json j;
+        j["transient"] = transient;
+        j["permanent"] = permanent;
+        j["scheduled"] = scheduled;
+        j["retried"] = retried;
+        j["recovered"] = recovered;
+        j["pending"] = pending;
+        j["postponed"] = postponed;
+        j["fallen_back"] = fallen_back;
+        j["dead_lettered"] = dead_lettered;
+        j["sink_errors"] = sink_errors;
+        return j;
+    }
+
+    Retrier::Retrier(Policy policy, const std::string &dead_letter_path) : m_policy(policy) {
+        if (!dead_letter_path.empty()) {
+            m_file.open(dead_letter_path, std::ios::out | std::ios::app);
+            if (!m_file) {
+                throw std::runtime_error("simple_mariadb::retry: cannot open dead letter file " + dead_letter_path);
+            }
+        }
+    }
+
+    void Retrier::set_callback(DeadLetterCallback callback) {
+        std::lock_guard<std::mutex> lock(m_sink_mutex);
+        m_callback = std::move(callback);
+    }
+
+    void Retrier::set_fallback(Fallback fallback) {
+        std::lock_guard<std::mutex> lock(m_sink_mutex);
+        m_fallback = std::move(fallback);
+    }
+
+    bool Retrier::fail(std::string statement, size_t attempts, Failure failure, bool may_retry) {
+        const ErrorClass error_class = classify(failure.error_code, failure.sql_state);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (error_class == ErrorClass::TRANSIENT) {
+            m_stats.transient++;
+        } else {
+            m_stats.permanent++;
+        }
+        if (error_class == ErrorClass::PERMANENT) {
+            this->m_dead_letter(std::move(statement), attempts, std::move(failure), "permanent");
+        } else if (!may_retry || m_stopped) {
+            this->m_dead_letter(std::move(statement), attempts, std::move(failure), "stopped");
+        } else if (attempts >= m_policy.max_attempts) {
+            this->m_dead_letter(std::move(statement), attempts, std::move(failure), "exhausted");
+        } else {
+            const auto when = std::chrono::steady_clock::now() + m_policy.backoff(attempts + 1);
+            m_wheel.schedule({std::move(statement), attempts, std::move(failure)}, when);
+            m_stats.scheduled++;
+            return true;
+        }
+        m_cv.notify_one(); // the consumer writes the letter
+        return false;
+    }
+
+    void Retrier::postpone(std::vector<Pending> &pending, std::chrono::milliseconds delay) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const auto when = std::chrono::steady_clock::now() + delay;
+        for (auto &retry: pending) {
+            m_wheel.schedule(std::move(retry), when);
+        }
+        m_stats.postponed += pending.size();
+        pending.clear();
+    }
+
+    void Retrier::give_up(std::vector<Pending> &pending) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto &retry: pending) {
+            this->m_dead_letter(std::move(retry.statement), retry.attempts, std::move(retry.failure), "stopped");
+        }
+        pending.clear();
+        m_cv.notify_one();
+    }
+
+    void Retrier::recovered() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.recovered++;
+    }
+
+    void Retrier::m_dead_letter(std::string &&statement, size_t attempts, Failure &&failure, const char *reason) {
+        m_letters.push_back({std::move(statement), attempts, std::move(failure), reason,
+                             std::chrono::system_clock::now()});
+    }
+
+    void Retrier::wait(std::chrono::milliseconds timeout, std::vector<Pending> &due) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            const auto deadline = std::min(std::chrono::steady_clock::now() + timeout, m_wheel.next_deadline());
+            m_cv.wait_until(lock, deadline, [this, deadline] {
+                return m_stopped || !m_letters.empty() || std::chrono::steady_clock::now() >= deadline;
+            });
+            const size_t before = due.size();
+            m_wheel.advance(std::chrono::steady_clock::now(), due);
+            m_stats.retried += due.size() - before;
+        }
+        this->flush();
+    }
+
+    void Retrier::take_all(std::vector<Pending> &out) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const size_t before = out.size();
+        m_wheel.drain(out);
+        m_stats.retried += out.size() - before;
+    }
+
+    void Retrier::flush() {
+        std::vector<DeadLetter> letters;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            letters.swap(m_letters);
+        }
+        if (letters.empty()) {
+            return;
+        }
+        size_t errors = 0;
+        size_t fallen_back = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_sink_mutex);
+            for (const auto &letter: letters) {
+                // Transient failures may still succeed later, the fallback gets a chance to keep them
+                if (m_fallback && letter.reason != "permanent" && m_fallback(letter.statement)) {
+                    fallen_back++;
+                    continue;
+                }
+                if (m_file.is_open()) {
+                    m_file << letter.to_json().dump() << '\n';
+                }
+                if (m_callback) {
+                    try {
+                        m_callback(letter);
+                    } catch (std::exception &) {
+                        errors++;
+                    }
+                }
+            }
+            if (m_file.is_open()) {
+                m_file.flush();
+                if (!m_file) {
+                    errors += letters.size() - fallen_back;
+                    m_file.clear();
+                }
+            }
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.fallen_back += fallen_back;
+        m_stats.dead_lettered += letters.size() - fallen_back;
+        m_stats.sink_errors += errors;
+    }
+
+    void Retrier::stop() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopped = true;
+        m_cv.notify_all();
+    }
+
+    size_t Retrier::pending() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_wheel.size();
+    }
+
+    RetryStats Retrier::get_stats() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        RetryStats stats = m_stats;
+        stats.pending = m_wheel.size();
+        return stats;
+    }
+
+}
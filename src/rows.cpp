@@ -0,0 +1,242 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+#include "simple_mariadb/rows.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <iterator>
+
+namespace simple_mariadb::rows {
+
+    void bind_value(sql::PreparedStatement &stmt, int32_t index, const Value &value) {
+        std::visit([&stmt, index](const auto &held) {
+            using U = std::decay_t<decltype(held)>;
+            if constexpr (std::is_same_v<U, std::nullptr_t>) {
+                stmt.setNull(index, sql::VARCHAR);
+            } else if constexpr (std::is_same_v<U, bool>) {
+                stmt.setBoolean(index, held);
+            } else if constexpr (std::is_same_v<U, int64_t>) {
+                stmt.setInt64(index, held);
+            } else if constexpr (std::is_same_v<U, uint64_t>) {
+                stmt.setUInt64(index, held);
+            } else if constexpr (std::is_same_v<U, double>) {
+                stmt.setDouble(index, held);
+            } else {
+                stmt.setString(index, sql::SQLString(held));
+            }
+        }, value);
+    }
+
+    std::string to_literal(const Value &value) {
+        return std::visit([](const auto &held) -> std::string {
+            using U = std::decay_t<decltype(held)>;
+            if constexpr (std::is_same_v<U, std::nullptr_t>) {
+                return "NULL";
+            } else if constexpr (std::is_same_v<U, bool>) {
+                return held ? "1" : "0";
+            } else if constexpr (std::is_same_v<U, int64_t> || std::is_same_v<U, uint64_t>) {
+                return std::to_string(held);
+            } else if constexpr (std::is_same_v<U, double>) {
+                if (!std::isfinite(held)) {
+                    return "NULL"; // the server has no literal for them
+                }
+                char buffer[32];
+                auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), held); // shortest round trip
+                return std::string(buffer, ec == std::errc() ? end : buffer);
+            } else {
+                std::string literal;
+                literal.reserve(held.size() + 2);
+                literal += '\'';
+                for (const char c: held) {
+                    switch (c) {
+                        case '\0':
+                            literal += "\\0";
+                            break;
+                        case '\n':
+                            literal += "\\n";
+                            break;
+                        case '\r':
+                            literal += "\\r";
+                            break;
+                        case '\x1a':
+                            literal += "\\Z";
+                            break;
+                        case '\'':
+                        case '"':
+                        case '\\':
+                            literal += '\\';
+                            literal += c;
+                            break;
+                        default:
+                            literal += c;
+                    }
+                }
+                literal += '\'';
+                return literal;
+            }
+        }, value);
+    }
+
+    std::string row_statement(const RowBatch &batch, size_t row) {
+        // Placeholders only follow VALUES, the quoted names before it may hold a '?'
+        const size_t values = batch.sql.rfind("VALUES");
+        std::string statement = batch.sql.substr(0, values);
+        size_t column = 0;
+        for (size_t i = values; i < batch.sql.size(); ++i) {
+            if (batch.sql[i] == '?' && column < batch.columns) {
+                statement += to_literal(batch.values[row * batch.columns + column++]);
+            } else {
+                statement += batch.sql[i];
+            }
+        }
+        return statement;
+    }
+
+    std::string insert_statement(const std::string &table, const std::vector<std::string> &columns) {
+        std::string statement = "INSERT INTO `" + table + "` (";
+        for (const auto &column: columns) {
+            statement += "`" + column + "`,";
+        }   // Remove last comma
+        statement.pop_back();
+        statement += ") VALUES (";
+        for (size_t i = 0; i < columns.size(); ++i) {
+            statement += "?,";
+        }
+        statement.pop_back();
+        statement += ")";
+        return statement;
+    }
+
+    RowBuffer::RowBuffer(size_t max_rows, size_t max_pending) :
+            m_max_rows(std::max<size_t>(max_rows, 1)),
+            m_max_pending(max_pending) {}
+
+    bool RowBuffer::add(const std::string &table, const std::vector<std::string> &columns, std::vector<Value> &&row) {
+        if (columns.empty() || row.size() != columns.size()) {
+            return false;
+        }
+        bool wake = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_max_pending > 0 && m_buffered + m_in_flight >= m_max_pending) {
+                return false;
+            }
+            auto it = m_tables.find(KeyRef{table, columns});
+            if (it == m_tables.end()) {
+                it = m_tables.emplace(Key{table, columns},
+                                      Table{insert_statement(table, columns), columns.size(), {}, {}}).first;
+            }
+            Table &buffered = it->second;
+            if (buffered.values.empty()) {
+                buffered.oldest = std::chrono::steady_clock::now();
+            }
+            for (auto &value: row) {
+                buffered.values.push_back(std::move(value));
+            }
+            m_buffered++;
+            if (buffered.values.size() >= m_max_rows * buffered.columns) {
+                m_full = true;
+                wake = true;
+            }
+            wake = wake || m_buffered == 1;
+        }
+        if (wake) {
+            m_cv.notify_all();
+        }
+        return true;
+    }
+
+    std::vector<RowBatch> RowBuffer::wait_batches(std::chrono::milliseconds linger, const std::atomic<bool> &running) {
+        std::vector<RowBatch> batches;
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait(lock, [this, &running]() { return m_buffered > 0 || !running; });
+        if (m_buffered == 0) {
+            return batches;
+        }
+        if (running && !m_full && linger.count() > 0) {
+            auto oldest = std::chrono::steady_clock::time_point::max();
+            for (const auto &[key, buffered]: m_tables) {
+                if (!buffered.values.empty()) {
+                    oldest = std::min(oldest, buffered.oldest);
+                }
+            }
+            m_cv.wait_until(lock, oldest + linger, [this, &running]() { return m_full || !running; });
+        }
+        this->m_take(batches);
+        return batches;
+    }
+
+    std::vector<RowBatch> RowBuffer::take_all() {
+        std::vector<RowBatch> batches;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        this->m_take(batches);
+        return batches;
+    }
+
+    void RowBuffer::m_take(std::vector<RowBatch> &batches) {
+        for (auto &[key, buffered]: m_tables) {
+            if (buffered.values.empty()) {
+                continue;
+            }
+            const size_t chunk = m_max_rows * buffered.columns;
+            if (buffered.values.size() <= chunk) {
+                batches.push_back({buffered.sql, buffered.columns, std::move(buffered.values)});
+            } else {
+                for (size_t start = 0; start < buffered.values.size(); start += chunk) {
+                    const size_t end = std::min(start + chunk, buffered.values.size());
+                    batches.push_back({buffered.sql, buffered.columns,
+                                       std::vector<Value>(std::make_move_iterator(buffered.values.begin() + start),
+                                                          std::make_move_iterator(buffered.values.begin() + end))});
+                }
+            }
+            buffered.values.clear();
+        }
+        m_in_flight += m_buffered;
+        m_buffered = 0;
+        m_full = false;
+    }
+
+    void RowBuffer::done(size_t rows) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_in_flight -= std::min(rows, m_in_flight);
+        }
+        m_cv.notify_all();
+    }
+
+    size_t RowBuffer::pending_rows() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_buffered + m_in_flight;
+    }
+
+    void RowBuffer::wipeout() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (auto &[key, buffered]: m_tables) {
+                buffered.values.clear();
+            }
+            m_buffered = 0;
+            m_full = false;
+        }
+        m_cv.notify_all();
+    }
+
+    void RowBuffer::flush() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_full = m_buffered > 0;
+        }
+        m_cv.notify_all();
+    }
+
+    void RowBuffer::notify() {
+        {
+            // Waiters check the running flag under the mutex, taking it here avoids a lost wakeup
+            std::lock_guard<std::mutex> lock(m_mutex);
+        }
+        m_cv.notify_all();
+    }
+
+}
@@ -0,0 +1,333 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+#include "simple_mariadb/spill.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace simple_mariadb::spill {
+
+    namespace {
+
+        constexpr char magic[8] = {'S', 'M', 'D', 'B', 'S', 'P', 'L', '1'};
+        constexpr size_t header_size = 16;           ///< magic + sequence
+        constexpr size_t record_header_size = 8;     ///< length + crc
+        constexpr uint32_t committed_flag = 0x80000000u;
+
+        constexpr std::array<uint32_t, 256> crc_table = [] {
+            std::array<uint32_t, 256> table{};
+            for (uint32_t i = 0; i < 256; ++i) {
+                uint32_t c = i;
+                for (int k = 0; k < 8; ++k) {
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                }
+                table[i] = c;
+            }
+            return table;
+        }();
+
+        size_t padded(size_t length) {
+            return (record_header_size + length + 7) & ~static_cast<size_t>(7);
+        }
+
+        std::atomic_ref<uint32_t> length_at(char *data, size_t offset) {
+            return std::atomic_ref<uint32_t>(*reinterpret_cast<uint32_t *>(data + offset));
+        }
+
+        uint32_t crc_at(const char *data, size_t offset) {
+            uint32_t crc;
+            std::memcpy(&crc, data + offset + 4, sizeof(crc));
+            return crc;
+        }
+
+    }
+
+    nlohmann::json SpillStats::to_json() const {
+        nlohmann::json j;
+        j["segments"] = segments;
+        j["bytes"] = bytes;
+        j["pending"] = pending;
+        j["appended"] = appended;
+        j["committed"] = committed;
+        j["recovered"] = recovered;
+        j["rejected"] = rejected;
+        return j;
+    }
+
+    uint32_t crc32(std::string_view data) {
+        uint32_t crc = 0xFFFFFFFFu;
+        for (unsigned char c: data) {
+            crc = crc_table[(crc ^ c) & 0xFF] ^ (crc >> 8);
+        }
+        return crc ^ 0xFFFFFFFFu;
+    }
+
+    SegmentLog::SegmentLog(std::string directory, size_t segment_size, size_t max_bytes) :
+            m_directory(std::move(directory)),
+            m_segment_size(std::max<size_t>(segment_size, header_size + record_header_size + 8)),
+            m_max_bytes(max_bytes) {
+        std::error_code error;
+        std::filesystem::create_directories(m_directory, error);
+        if (error) {
+            throw std::runtime_error("Spill directory " + m_directory + " cannot be created: " + error.message());
+        }
+        this->m_recover();
+    }
+
+    SegmentLog::~SegmentLog() {
+        this->sync();
+        for (auto &segment: m_segments) {
+            this->m_close(segment, false);
+        }
+    }
+
+    std::string SegmentLog::m_path(uint64_t sequence) const {
+        std::string name = std::to_string(sequence);
+        name.insert(0, 20 - std::min<size_t>(name.size(), 20), '0'); // zero padded so names sort by sequence
+        return (std::filesystem::path(m_directory) / ("segment-" + name + ".log")).string();
+    }
+
+    void SegmentLog::m_recover() {
+        std::vector<std::pair<uint64_t, std::string>> files;
+        for (const auto &entry: std::filesystem::directory_iterator(m_directory)) {
+            const std::string name = entry.path().filename().string();
+            if (name.size() <= 12 || name.rfind("segment-", 0) != 0 || name.substr(name.size() - 4) != ".log") {
+                continue;
+            }
+            try {
+                files.emplace_back(std::stoull(name.substr(8, name.size() - 12)), entry.path().string());
+            } catch (std::exception &) {
+                continue;
+            }
+        }
+        std::sort(files.begin(), files.end());
+
+        for (auto &[sequence, path]: files) {
+            m_next_sequence = std::max(m_next_sequence, sequence + 1);
+            Segment segment;
+            segment.sequence = sequence;
+            segment.path = path;
+            if (!this->m_open(segment, false)) {
+                continue; // not ours or unreadable, left on disk untouched
+            }
+            size_t offset = header_size;
+            while (offset + record_header_size <= segment.size) {
+                uint32_t raw = length_at(segment.data, offset).load(std::memory_order_acquire);
+                size_t length = raw & ~committed_flag;
+                if (raw == 0 || offset + record_header_size + length > segment.size ||
+                    crc32({segment.data + offset + record_header_size, length}) != crc_at(segment.data, offset)) {
+                    break; // end of the segment, or a record cut short by a crash
+                }
+                if ((raw & committed_flag) == 0) {
+                    m_stats.pending++;
+                }
+                offset += padded(length);
+            }
+            segment.end = offset;
+            if (offset + sizeof(uint32_t) <= segment.size) {
+                length_at(segment.data, offset).store(0, std::memory_order_release);
+            }
+            m_stats.bytes += segment.size;
+            m_segments.push_back(std::move(segment));
+        }
+        m_stats.recovered = m_stats.pending;
+        m_read_offset = header_size;
+        this->m_drop_committed();
+    }
+
+    bool SegmentLog::m_open(Segment &segment, bool create) {
+        segment.fd = ::open(segment.path.c_str(), create ? O_RDWR | O_CREAT | O_EXCL : O_RDWR, 0644);
+        if (segment.fd < 0) {
+            return false;
+        }
+        if (create) {
+            if (::ftruncate(segment.fd, static_cast<off_t>(m_segment_size)) != 0) {
+                this->m_close(segment, true);
+                return false;
+            }
+            segment.size = m_segment_size;
+        } else {
+            struct stat st{};
+            if (::fstat(segment.fd, &st) != 0 || static_cast<size_t>(st.st_size) < header_size) {
+                this->m_close(segment, false);
+                return false;
+            }
+            segment.size = static_cast<size_t>(st.st_size);
+        }
+        void *data = ::mmap(nullptr, segment.size, PROT_READ | PROT_WRITE, MAP_SHARED, segment.fd, 0);
+        if (data == MAP_FAILED) {
+            this->m_close(segment, create);
+            return false;
+        }
+        segment.data = static_cast<char *>(data);
+        if (create) {
+            std::memcpy(segment.data, magic, sizeof(magic));
+            std::memcpy(segment.data + sizeof(magic), &segment.sequence, sizeof(segment.sequence));
+            segment.end = header_size;
+        } else if (std::memcmp(segment.data, magic, sizeof(magic)) != 0) {
+            this->m_close(segment, false);
+            return false;
+        }
+        return true;
+    }
+
+    void SegmentLog::m_close(Segment &segment, bool remove) {
+        if (segment.data != nullptr) {
+            ::munmap(segment.data, segment.size);
+            segment.data = nullptr;
+        }
+        if (segment.fd >= 0) {
+            ::close(segment.fd);
+            segment.fd = -1;
+        }
+        if (remove) {
+            ::unlink(segment.path.c_str());
+        }
+    }
+
+    bool SegmentLog::m_roll() {
+        if (m_max_bytes > 0 && m_stats.bytes + m_segment_size > m_max_bytes) {
+            return false;
+        }
+        if (!m_segments.empty()) {
+            ::msync(m_segments.back().data, m_segments.back().size, MS_ASYNC);
+        }
+        Segment segment;
+        segment.sequence = m_next_sequence++;
+        segment.path = this->m_path(segment.sequence);
+        if (!this->m_open(segment, true)) {
+            return false;
+        }
+        m_stats.bytes += segment.size;
+        if (m_segments.empty()) {
+            m_read_offset = header_size;
+        }
+        m_segments.push_back(std::move(segment));
+        return true;
+    }
+
+    void SegmentLog::m_drop_committed() {
+        while (!m_segments.empty()) {
+            Segment &front = m_segments.front();
+            while (m_read_offset < front.end) {
+                uint32_t raw = length_at(front.data, m_read_offset).load(std::memory_order_acquire);
+                if ((raw & committed_flag) == 0) {
+                    return;
+                }
+                m_read_offset += padded(raw & ~committed_flag);
+            }
+            if (m_segments.size() == 1) {
+                return; // the segment taking appends stays
+            }
+            m_stats.bytes -= front.size;
+            this->m_close(front, true);
+            m_segments.pop_front();
+            m_read_offset = header_size;
+        }
+    }
+
+    bool SegmentLog::append(std::string_view record) {
+        const size_t size = padded(record.size());
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (record.size() >= committed_flag || header_size + size > m_segment_size) {
+            m_stats.rejected++;
+            return false;
+        }
+        if (m_segments.empty() || m_segments.back().end + size > m_segments.back().size) {
+            if (!this->m_roll()) {
+                m_stats.rejected++;
+                return false;
+            }
+            this->m_drop_committed(); // the previous segment may be fully replayed already
+        }
+        Segment &segment = m_segments.back();
+        char *data = segment.data + segment.end;
+        uint32_t crc = crc32(record);
+        std::memcpy(data + record_header_size, record.data(), record.size());
+        std::memcpy(data + 4, &crc, sizeof(crc));
+        // The length goes last, until then the record reads as the end of the segment
+        length_at(segment.data, segment.end).store(static_cast<uint32_t>(record.size()), std::memory_order_release);
+        segment.end += size;
+        m_stats.appended++;
+        m_stats.pending++;
+        return true;
+    }
+
+    size_t SegmentLog::peek(size_t max, std::vector<std::string> &records) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        size_t count = 0;
+        size_t offset = m_read_offset;
+        for (auto &segment: m_segments) {
+            while (count < max && offset < segment.end) {
+                uint32_t raw = length_at(segment.data, offset).load(std::memory_order_acquire);
+                size_t length = raw & ~committed_flag;
+                if ((raw & committed_flag) == 0) {
+                    records.emplace_back(segment.data + offset + record_header_size, length);
+                    count++;
+                }
+                offset += padded(length);
+            }
+            if (count == max) {
+                break;
+            }
+            offset = header_size;
+        }
+        return count;
+    }
+
+    void SegmentLog::commit(size_t count) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        while (count > 0 && !m_segments.empty()) {
+            Segment &front = m_segments.front();
+            if (m_read_offset >= front.end) {
+                if (m_segments.size() == 1) {
+                    break;
+                }
+                m_stats.bytes -= front.size;
+                this->m_close(front, true);
+                m_segments.pop_front();
+                m_read_offset = header_size;
+                continue;
+            }
+            auto length = length_at(front.data, m_read_offset);
+            uint32_t raw = length.load(std::memory_order_acquire);
+            if ((raw & committed_flag) == 0) {
+                length.store(raw | committed_flag, std::memory_order_release);
+                m_stats.committed++;
+                m_stats.pending--;
+                count--;
+            }
+            m_read_offset += padded(raw & ~committed_flag);
+        }
+        this->m_drop_committed();
+    }
+
+    size_t SegmentLog::pending() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_stats.pending;
+    }
+
+    void SegmentLog::sync() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto &segment: m_segments) {
+            ::msync(segment.data, segment.size, MS_SYNC);
+        }
+    }
+
+    SpillStats SegmentLog::get_stats() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        SpillStats stats = m_stats;
+        stats.segments = m_segments.size();
+        return stats;
+    }
+
+}
@@ -0,0 +1,103 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+#include "simple_mariadb/statement.h"
+#include <algorithm>
+
+namespace simple_mariadb::statement {
+
+    StatementCacheStats &StatementCacheStats::operator+=(const StatementCacheStats &other) {
+        size += other.size;
+        capacity += other.capacity;
+        hits += other.hits;
+        misses += other.misses;
+        evictions += other.evictions;
+        resets += other.resets;
+        return *this;
+    }
+
+    nlohmann::json StatementCacheStats::to_json() const {
+        nlohmann::json j;
+        j["size"] = size;
+        j["capacity"] = capacity;
+        j["hits"] = hits;
+        j["misses"] = misses;
+        j["evictions"] = evictions;
+        j["resets"] = resets;
+        return j;
+    }
+
+    StatementCache::StatementCache(size_t capacity) : m_capacity(capacity) {}
+
+    sql::PreparedStatement &StatementCache::get(const std::shared_ptr<sql::Connection> &conn, const std::string &sql) {
+        if (conn != m_conn) {
+            if (!m_lru.empty()) {
+                m_resets++;
+            }
+            this->clear();
+            m_conn = conn;
+        }
+
+        auto found = m_index.find(sql);
+        if (found != m_index.end()) {
+            m_hits++;
+            m_lru.splice(m_lru.begin(), m_lru, found->second);
+            return *found->second->second;
+        }
+
+        m_misses++;
+        std::unique_ptr<sql::PreparedStatement> stmt(conn->prepareStatement(sql));
+        // A capacity of 0 still keeps the statement being used alive
+        while (!m_lru.empty() && m_lru.size() >= std::max<size_t>(m_capacity, 1)) {
+            m_index.erase(m_lru.back().first);
+            m_lru.pop_back();
+            m_evictions++;
+        }
+        m_lru.emplace_front(sql, std::move(stmt));
+        m_index[sql] = m_lru.begin();
+        m_size = m_lru.size();
+        return *m_lru.front().second;
+    }
+
+    void StatementCache::evict(const std::string &sql) {
+        auto found = m_index.find(sql);
+        if (found == m_index.end()) {
+            return;
+        }
+        m_lru.erase(found->second);
+        m_index.erase(found);
+        m_size = m_lru.size();
+    }
+
+    void StatementCache::clear() {
+        m_index.clear();
+        m_lru.clear(); // before the connection they were prepared on is released
+        m_size = 0;
+        m_conn.reset();
+    }
+
+    StatementCacheStats StatementCache::get_stats() const {
+        StatementCacheStats stats;
+        stats.size = m_size;
+        stats.capacity = m_capacity;
+        stats.hits = m_hits;
+        stats.misses = m_misses;
+        stats.evictions = m_evictions;
+        stats.resets = m_resets;
+        return stats;
+    }
+
+    bool needs_reprepare(const sql::SQLException &e) {
+        switch (e.getErrorCode()) {
+            case 1243: // ER_UNKNOWN_STMT_HANDLER
+            case 1615: // ER_NEED_REPREPARE
+            case 2006: // CR_SERVER_GONE_ERROR
+            case 2013: // CR_SERVER_LOST
+                return true;
+            default:
+                return false;
+        }
+    }
+
+}
@@ -0,0 +1,43 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+#include "simple_mariadb/table.h"
+#include <stdexcept>
+
+namespace simple_mariadb::table {
+
+    ResultTable::ResultTable() : m_columns(std::make_shared<const std::vector<std::string>>()) {}
+
+    ResultTable::ResultTable(std::vector<std::string> columns) :
+            m_columns(std::make_shared<const std::vector<std::string>>(std::move(columns))) {}
+
+    void ResultTable::reset(std::vector<std::string> columns) {
+        m_columns = std::make_shared<const std::vector<std::string>>(std::move(columns));
+        m_arena.clear();
+        m_offsets.resize(1);
+        m_nulls.clear();
+    }
+
+    size_t ResultTable::column_index(std::string_view name) const {
+        const auto &columns = *m_columns;
+        for (size_t i = 0; i < columns.size(); ++i) {
+            if (columns[i] == name) {
+                return i;
+            }
+        }
+        throw std::out_of_range("simple_mariadb::table: no column " + std::string(name));
+    }
+
+    void ResultTable::append(std::string_view value) {
+        m_arena.append(value);
+        m_offsets.push_back(m_arena.size());
+        m_nulls.push_back(false);
+    }
+
+    void ResultTable::append_null() {
+        m_offsets.push_back(m_arena.size());
+        m_nulls.push_back(true);
+    }
+
+}
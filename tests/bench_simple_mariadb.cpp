@@ -0,0 +1,264 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+#include <simple_mariadb/batch.h>
+#include <simple_mariadb/config.h>
+#include <simple_mariadb/decoder.h>
+#include <simple_mariadb/logging.h>
+#include <simple_mariadb/queue.h>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <common/sql_utils.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ---------------------------------------------------------------------------------------------------
+// Client-side costs of the hot paths, no server needed. Run with a machine-readable reporter to track
+// regressions, e.g. `bench_simple_mariadb --reporter xml::out=bench.xml`, or build run_bench_simple_mariadb.
+
+namespace {
+
+    std::string insert_query(size_t i) {
+        return "INSERT INTO `quotes` (`ticker`, `price`, `volume`, `note`) VALUES ('AAPL', " +
+               std::to_string(181.5 + static_cast<double>(i)) + ", " + std::to_string(i) + ", 'regular');";
+    }
+
+    std::vector<std::string> insert_queries(size_t count) {
+        std::vector<std::string> queries;
+        queries.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            queries.push_back(insert_query(i));
+        }
+        return queries;
+    }
+
+    simple_mariadb::config::MariaDBConfig queue_config(const std::string &backend, size_t size) {
+        simple_mariadb::config::MariaDBConfig config;
+        config.queue_backend = backend;
+        config.queue_size = size;
+        config.queue_overflow_policy = "block";
+        return config;
+    }
+
+    /**
+     * Rows served through the getters of sql::ResultSet that decoder::ColumnPlan reads, every tenth note NULL.
+     */
+    class SyntheticResult {
+    public:
+        explicit SyntheticResult(size_t rows) : m_rows(rows) {}
+
+        bool next() { return ++m_row < m_rows; }
+
+        int32_t getInt(int32_t) { return m_read(static_cast<int32_t>(m_row)); }
+
+        int64_t getInt64(int32_t) { return m_read(static_cast<int64_t>(m_row) * 1000003); }
+
+        bool getBoolean(int32_t) { return m_read(m_row % 2 == 0); }
+
+        double getDouble(int32_t) { return m_read(181.5 + static_cast<double>(m_row)); }
+
+        float getFloat(int32_t) { return m_read(1.5f); }
+
+        const std::string &getString(int32_t index) {
+            m_null = index == 6 && m_row % 10 == 0;
+            return index == 2 ? m_ticker : m_note;
+        }
+
+        bool wasNull() const { return m_null; }
+
+    private:
+        template<typename T>
+        T m_read(T value) {
+            m_null = false;
+            return value;
+        }
+
+        size_t m_rows;
+        size_t m_row = SIZE_MAX; ///< Before the first row, next() moves to row 0.
+        bool m_null = false;
+        std::string m_ticker = "AAPL";
+        std::string m_note = "regular session";
+    };
+
+    simple_mariadb::decoder::ColumnPlan synthetic_plan() {
+        using simple_mariadb::decoder::Decoder;
+        return simple_mariadb::decoder::ColumnPlan({
+                {1, "id", sql::BIGINT, Decoder::INT64},
+                {2, "ticker", sql::VARCHAR, Decoder::STRING},
+                {3, "price", sql::DOUBLE, Decoder::DOUBLE},
+                {4, "volume", sql::INTEGER, Decoder::INT},
+                {5, "active", sql::BOOLEAN, Decoder::BOOLEAN},
+                {6, "note", sql::VARCHAR, Decoder::STRING},
+        });
+    }
+
+}
+
+TEST_CASE("Benchmark enqueue", "[benchmark]") {
+    const std::string query = insert_query(42);
+    REQUIRE(simple_mariadb::batch::is_insert_or_replace(query));
+    for (const std::string backend: {"mutex", "ring"}) {
+        auto config = queue_config(backend, 1024);
+        simple_mariadb::queue::QueryQueue queue(config);
+        std::string out;
+
+        // enqueue() pushes after the optional check, the dequeue keeps the queue from filling up
+        BENCHMARK("enqueue checked, " + backend) {
+            if (simple_mariadb::batch::is_insert_or_replace(query)) {
+                queue.enqueue(query);
+            }
+            queue.dequeue_blocking(out);
+            return out.size();
+        };
+
+        BENCHMARK("enqueue unchecked, " + backend) {
+            queue.enqueue(query);
+            queue.dequeue_blocking(out);
+            return out.size();
+        };
+    }
+
+    // The scanner enqueue() uses against the regular expressions it replaced
+    BENCHMARK("is_insert_or_replace") {
+        return simple_mariadb::batch::is_insert_or_replace(query);
+    };
+
+    BENCHMARK("is_insert_or_replace_query_correct") {
+        return ::common::sql_utils::is_insert_or_replace_query_correct(query);
+    };
+}
+
+TEST_CASE("Benchmark queue throughput", "[benchmark]") {
+    const std::string query = insert_query(42);
+    const size_t per_producer = 10000;
+    for (const std::string backend: {"mutex", "ring"}) {
+        for (size_t producers: {1, 4, 8}) {
+            auto config = queue_config(backend, 30000);
+            simple_mariadb::queue::QueryQueue queue(config);
+            BENCHMARK(backend + " queue, " + std::to_string(producers) + " producers x " +
+                      std::to_string(per_producer)) {
+                std::vector<std::thread> threads;
+                for (size_t p = 0; p < producers; ++p) {
+                    threads.emplace_back([&queue, &query, per_producer]() {
+                        for (size_t i = 0; i < per_producer; ++i) {
+                            queue.enqueue(query);
+                        }
+                    });
+                }
+                size_t consumed = 0;
+                std::string out;
+                while (consumed < producers * per_producer) {
+                    if (queue.dequeue_blocking(out)) {
+                        consumed++;
+                    }
+                }
+                for (auto &thread: threads) {
+                    thread.join();
+                }
+                return consumed;
+            };
+        }
+    }
+}
+
+TEST_CASE("Benchmark batched hand-off", "[benchmark]") {
+    // Producers staging 64 statements and publishing them with one bulk push, against one push per statement
+    const std::string query = insert_query(42);
+    const size_t per_producer = 10000;
+    const size_t batch = 64;
+    for (size_t producers: {1, 4, 8}) {
+        auto config = queue_config("ring", 30000);
+        simple_mariadb::queue::QueryQueue queue(config);
+        BENCHMARK("ring queue bulk, " + std::to_string(producers) + " producers x " + std::to_string(per_producer)) {
+            std::vector<std::thread> threads;
+            for (size_t p = 0; p < producers; ++p) {
+                threads.emplace_back([&queue, &query, per_producer, batch]() {
+                    std::vector<std::string> staged;
+                    staged.reserve(batch);
+                    for (size_t i = 0; i < per_producer; ++i) {
+                        staged.push_back(query);
+                        if (staged.size() == batch || i + 1 == per_producer) {
+                            queue.enqueue_bulk(staged);
+                            staged.clear();
+                        }
+                    }
+                });
+            }
+            size_t consumed = 0;
+            std::string out;
+            while (consumed < producers * per_producer) {
+                if (queue.dequeue_blocking(out)) {
+                    consumed++;
+                }
+            }
+            for (auto &thread: threads) {
+                thread.join();
+            }
+            return consumed;
+        };
+    }
+}
+
+TEST_CASE("Benchmark multi-insert assembly", "[benchmark]") {
+    for (size_t rows: {100, 1000}) {
+        const auto queries = insert_queries(rows);
+        BENCHMARK("wrap_transaction " + std::to_string(rows) + " statements") {
+            return simple_mariadb::batch::wrap_transaction(queries).size();
+        };
+        BENCHMARK("rewrite_multi_row " + std::to_string(rows) + " statements") {
+            return simple_mariadb::batch::wrap_transaction(simple_mariadb::batch::rewrite_multi_row(queries)).size();
+        };
+        // The writers assemble batches in buffers recycled between batches
+        std::string sql;
+        std::vector<std::string> rewritten;
+        BENCHMARK("wrap_transaction " + std::to_string(rows) + " statements, reused buffer") {
+            simple_mariadb::batch::wrap_transaction(queries, sql);
+            return sql.size();
+        };
+        BENCHMARK("rewrite_multi_row " + std::to_string(rows) + " statements, reused buffers") {
+            simple_mariadb::batch::rewrite_multi_row(queries, rewritten);
+            simple_mariadb::batch::wrap_transaction(rewritten, sql);
+            return sql.size();
+        };
+    }
+}
+
+TEST_CASE("Benchmark disabled log sites", "[benchmark]") {
+    // The DEBUG line of every single INSERT, with the logger at info
+    using simple_mariadb::logging::LogLevel;
+    const std::string query = insert_query(42);
+    auto logger = std::make_shared<simple_logger::Logger>("info");
+    simple_mariadb::logging::Log log(logger, "info");
+    BENCHMARK("eager message, level filtered by the logger") {
+        logger->send<LogLevel::DEBUG>("Single INSERT success: " + query);
+    };
+    BENCHMARK("lazy message, level disabled") {
+        log.send<LogLevel::DEBUG>([&query]() { return "Single INSERT success: " + query; });
+    };
+}
+
+TEST_CASE("Benchmark to_sql_literal", "[benchmark]") {
+    using simple_mariadb::config::to_sql_literal;
+    const std::string ticker = "AAPL";
+    BENCHMARK("to_sql_literal int") { return to_sql_literal(123456); };
+    BENCHMARK("to_sql_literal double") { return to_sql_literal(181.25); };
+    BENCHMARK("to_sql_literal bool") { return to_sql_literal(true); };
+    BENCHMARK("to_sql_literal string") { return to_sql_literal(ticker); };
+}
+
+TEST_CASE("Benchmark resultset_to_json", "[benchmark]") {
+    // resultset_to_json() is the ColumnPlan of the result and decode_row() per row, over a synthetic result here
+    const auto plan = synthetic_plan();
+    for (size_t rows: {100, 10000}) {
+        BENCHMARK("resultset_to_json " + std::to_string(rows) + " rows x 6 columns") {
+            SyntheticResult res(rows);
+            nlohmann::json result;
+            while (res.next()) {
+                result.push_back(plan.decode_row(res));
+            }
+            return result.size();
+        };
+    }
+}
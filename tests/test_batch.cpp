@@ -0,0 +1,315 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+#include <simple_mariadb/batch.h>
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <cctype>
+#include <random>
+#include <string>
+#include <vector>
+
+// ---------------------------------------------------------------------------------------------------
+using simple_mariadb::batch::ParsedInsert;
+using simple_mariadb::batch::parse_insert;
+using simple_mariadb::batch::group_key;
+using simple_mariadb::batch::rewrite_multi_row;
+using ::common::sql_utils::InsertType;
+
+TEST_CASE("Parse insert statements", "[batch]") {
+
+    SECTION("Insert types") {
+        ParsedInsert parsed;
+        REQUIRE(parse_insert("INSERT INTO t (a, b) VALUES (1, 2);", parsed));
+        REQUIRE(parsed.type == InsertType::INSERT);
+        REQUIRE(parse_insert("insert  ignore into t (a, b) values (1, 2)", parsed));
+        REQUIRE(parsed.type == InsertType::IGNORE);
+        REQUIRE(parse_insert(" REPLACE INTO `t` (`a`, `b`) VALUES (1, 2);", parsed));
+        REQUIRE(parsed.type == InsertType::REPLACE);
+        REQUIRE(parsed.table == "`t`");
+        REQUIRE(parsed.columns == "(`a`, `b`)");
+        REQUIRE(parsed.values == "(1, 2)");
+        REQUIRE(parsed.suffix.empty());
+    }
+
+    SECTION("Quoted values") {
+        ParsedInsert parsed;
+        REQUIRE(parse_insert(R"(INSERT INTO db.t (a, b) VALUES ('it''s (not) a ; problem', 'back\'slash)');)", parsed));
+        REQUIRE(parsed.table == "db.t");
+        REQUIRE(parsed.values == R"(('it''s (not) a ; problem', 'back\'slash)'))");
+        REQUIRE(parse_insert("INSERT INTO t (a) VALUES (UNIX_TIMESTAMP()), (NOW())", parsed));
+        REQUIRE(parsed.values == "(UNIX_TIMESTAMP()), (NOW())");
+    }
+
+    SECTION("On duplicate key update") {
+        ParsedInsert parsed;
+        REQUIRE(parse_insert("INSERT INTO t (a, f) VALUES (1, 2.2) ON DUPLICATE KEY UPDATE f = 3.3;", parsed));
+        REQUIRE(parsed.suffix == "ON DUPLICATE KEY UPDATE f = 3.3");
+    }
+
+    SECTION("Unsupported shapes") {
+        ParsedInsert parsed;
+        REQUIRE_FALSE(parse_insert("INSERT INTO t SELECT * FROM s;", parsed));
+        REQUIRE_FALSE(parse_insert("INSERT INTO t SET a = 1;", parsed));
+        REQUIRE_FALSE(parse_insert("INSERT INTO t (a) VALUES (1); DELETE FROM t;", parsed));
+        REQUIRE_FALSE(parse_insert("INSERT INTO t (a) VALUES ('unterminated);", parsed));
+        REQUIRE_FALSE(parse_insert("UPDATE t SET a = 1;", parsed));
+        REQUIRE_FALSE(parse_insert("INSERTINTO t (a) VALUES (1);", parsed));
+    }
+
+    SECTION("Group key ignores formatting") {
+        ParsedInsert first;
+        ParsedInsert second;
+        REQUIRE(parse_insert("INSERT INTO `t` (`a`, `b`) VALUES (1, 2);", first));
+        REQUIRE(parse_insert("insert into t (a,b) values (3, 4)", second));
+        REQUIRE(group_key(first) == group_key(second));
+        REQUIRE(parse_insert("REPLACE INTO t (a, b) VALUES (3, 4)", second));
+        REQUIRE(group_key(first) != group_key(second));
+    }
+}
+
+TEST_CASE("Rewrite into multi-row statements", "[batch]") {
+
+    SECTION("Consecutive rows of the same table are merged") {
+        std::vector<std::string> queries = {
+                "INSERT INTO t (a, b) VALUES (1, 'x');",
+                "insert into `t` (a,b) values (2, 'y')",
+                "INSERT INTO u (a) VALUES (10);",
+                "INSERT INTO t (a, b) VALUES (3, 'z');",
+                "DELETE FROM t WHERE a = 0;",
+                "INSERT INTO t (a, b) VALUES (4, 'w');",
+                "INSERT INTO t (a, b) VALUES (5, 'v')",
+        };
+        auto result = rewrite_multi_row(queries);
+        REQUIRE(result.size() == 5);
+        REQUIRE(result[0] == "INSERT INTO t (a, b) VALUES (1, 'x'),(2, 'y');");
+        REQUIRE(result[1] == "INSERT INTO u (a) VALUES (10);");
+        REQUIRE(result[2] == "INSERT INTO t (a, b) VALUES (3, 'z');");
+        REQUIRE(result[3] == "DELETE FROM t WHERE a = 0;"); // never crossed by a later row
+        REQUIRE(result[4] == "INSERT INTO t (a, b) VALUES (4, 'w'),(5, 'v');");
+    }
+
+    SECTION("Insert types and suffixes are kept apart") {
+        std::vector<std::string> queries = {
+                "INSERT IGNORE INTO t (a) VALUES (1);",
+                "REPLACE INTO t (a) VALUES (2);",
+                "INSERT IGNORE INTO t (a) VALUES (3);",
+                "INSERT INTO t (a) VALUES (4) ON DUPLICATE KEY UPDATE a = VALUES(a);",
+                "INSERT INTO t (a) VALUES (5) ON DUPLICATE KEY UPDATE a = VALUES(a);",
+        };
+        auto result = rewrite_multi_row(queries);
+        REQUIRE(result.size() == 4);
+        REQUIRE(result[0] == "INSERT IGNORE INTO t (a) VALUES (1);");
+        REQUIRE(result[1] == "REPLACE INTO t (a) VALUES (2);");
+        REQUIRE(result[2] == "INSERT IGNORE INTO t (a) VALUES (3);");
+        REQUIRE(result[3] == "INSERT INTO t (a) VALUES (4),(5) ON DUPLICATE KEY UPDATE a = VALUES(a);");
+    }
+
+    SECTION("Empty queries are skipped") {
+        std::vector<std::string> queries = {"", "INSERT INTO t (a) VALUES (1);", ""};
+        auto result = rewrite_multi_row(queries);
+        REQUIRE(result.size() == 1);
+        REQUIRE(result[0] == "INSERT INTO t (a) VALUES (1);");
+    }
+}
+
+TEST_CASE("Wrap statements in a transaction", "[batch]") {
+    using simple_mariadb::batch::wrap_transaction;
+    REQUIRE(wrap_transaction({}) == "START TRANSACTION;COMMIT;");
+    REQUIRE(wrap_transaction({"INSERT INTO t (a) VALUES (1);", "", "INSERT INTO t (a) VALUES (2)"}) ==
+            "START TRANSACTION;INSERT INTO t (a) VALUES (1);INSERT INTO t (a) VALUES (2);COMMIT;");
+
+    SECTION("Into a reused buffer") {
+        std::string sql = "previous content of the buffer";
+        wrap_transaction({"INSERT INTO t (a) VALUES (1)"}, sql);
+        REQUIRE(sql == "START TRANSACTION;INSERT INTO t (a) VALUES (1);COMMIT;");
+        const size_t capacity = sql.capacity();
+        wrap_transaction({"INSERT INTO t (a) VALUES (2)"}, sql);
+        REQUIRE(sql == "START TRANSACTION;INSERT INTO t (a) VALUES (2);COMMIT;");
+        REQUIRE(sql.capacity() == capacity);
+    }
+}
+
+TEST_CASE("Rewrite into a reused buffer", "[batch]") {
+    std::vector<std::string> result = {"a", "b", "c", "d"};
+    rewrite_multi_row({"INSERT INTO t (a) VALUES (1);", "DELETE FROM t;", "INSERT INTO t (a) VALUES (2);"}, result);
+    REQUIRE(result.size() == 3);
+    REQUIRE(result[0] == "INSERT INTO t (a) VALUES (1);");
+    REQUIRE(result[1] == "DELETE FROM t;");
+    REQUIRE(result[2] == "INSERT INTO t (a) VALUES (2);");
+    REQUIRE(result == rewrite_multi_row({"INSERT INTO t (a) VALUES (1);", "DELETE FROM t;",
+                                         "INSERT INTO t (a) VALUES (2);"}));
+
+    rewrite_multi_row({"INSERT INTO t (a) VALUES (3);", "INSERT INTO t (a) VALUES (4);"}, result);
+    REQUIRE(result.size() == 1);
+    REQUIRE(result[0] == "INSERT INTO t (a) VALUES (3),(4);");
+
+    std::vector<size_t> merged = {9};
+    rewrite_multi_row({"INSERT INTO t (a) VALUES (7);", "INSERT INTO t (a) VALUES (8),(9);", "", "DELETE FROM t;",
+                       "INSERT INTO t (a) VALUES (10);"}, result, &merged);
+    REQUIRE(result.size() == 3);
+    REQUIRE(result[0] == "INSERT INTO t (a) VALUES (7),(8),(9);");
+    REQUIRE(merged == std::vector<size_t>{2, 1, 1}); // queued statements, not VALUES tuples
+
+    rewrite_multi_row({"INSERT INTO t (a) VALUES (3);", "INSERT INTO t (a) VALUES (4);"}, result);
+    REQUIRE(result[0] == "INSERT INTO t (a) VALUES (3),(4);");
+    const void *first = result[0].data();
+    rewrite_multi_row({"INSERT INTO t (a) VALUES (5);", "INSERT INTO t (a) VALUES (6);"}, result);
+    REQUIRE(result[0] == "INSERT INTO t (a) VALUES (5),(6);");
+    REQUIRE(static_cast<const void *>(result[0].data()) == first);
+}
+
+TEST_CASE("Validate insert statements", "[batch]") {
+    using simple_mariadb::batch::is_insert_or_replace;
+    using ::common::sql_utils::is_insert_or_replace_query_correct;
+
+    const std::vector<std::string> right = {
+            R"(REPLACE INTO `OHLC` (`ticker`, `open`, `high`, `low`, `close`, `transactions`, `otc`, `timestamp`, `volume`, `volume_weighted_price`) VALUES ('ACAQ', 9.4, 9.95, 8, 9.75, 996, 0, 1697486400000, 32962, 9.1733);)",
+            R"(INSERT IGNORE INTO `Tickers` (`active`, `cik`, `composite_figi`, `currency_name`, `last_updated_utc`, `locale`, `market`, `name`, `primary_exchange`, `share_class_figi`, `ticker`, `type`) VALUES ('true', '0001914023', 'BBG0190WQ3Q5', 'usd', '2023-12-22T00:00:00Z', 'us', 'stocks', 'Acri Capital Acquisition Corporation Warrant', 'XNAS', NULL, 'ACACW', 'WARRANT');)",
+            R"(insert into Tickers (active, `cik`, `ticker`) VALUES ('true', '0001914023', 'ACACW');)",
+            "INSERT INTO db.t (a, b) VALUES (1, 'x'), (2, 'y')",
+            "  INSERT INTO `db`.`t` (a, b, c, d) VALUES (-1.5e3, .5, 0x1F, DEFAULT) ; ",
+            "INSERT INTO t (a, b, c) VALUES (NOW(), CONCAT('a', 'b'), _utf8mb4'text')",
+            "INSERT INTO t (a, b) VALUES ('it''s; a \\' (test)', \"x,y\")",
+            "INSERT INTO t (name, number) VALUES ('abc', 1);",
+    };
+    const std::vector<std::string> wrong = {
+            "",
+            "SELECT * FROM t",
+            "UPDATE t SET a = 1",
+            "INSERT t (a) VALUES (1)",
+            "INSERT INTO (a) VALUES (1)",
+            "INSERT INTO t VALUES (1)",
+            "INSERT INTO t a, b) VALUES (1, 2)",
+            "INSERT INTO t () VALUES ()",
+            "INSERT INTO t (``) VALUES (1)",
+            "INSERT INTO t (a, b) VALUES (1)",
+            "INSERT INTO t (a) VALUES (1, 2)",
+            "INSERT INTO t (a) VALUES (1), (1, 2)",
+            "INSERT INTO t (a) VALUES (1),",
+            "INSERT INTO t (a) VALUES ('open)",
+            "INSERT INTO t (a) VALUES (1abc)",
+            "INSERT INTO t (a) VALUES (f(g(h(i(j(k(l(m(n(1))))))))))",
+            "INSERT INTO t (a) VALUES (1); DROP TABLE t;",
+            "INSERT INTO t (a) VALUES (1) ON DUPLICATE KEY UPDATE a = 2",
+            "INSERT INTO t (a) SELECT a FROM s",
+            "INSERTINTO t (a) VALUES (1)",
+    };
+
+    SECTION("Accepted statements") {
+        for (const auto &query: right) {
+            INFO(query);
+            REQUIRE(is_insert_or_replace(query));
+            REQUIRE(is_insert_or_replace_query_correct(query));
+        }
+    }
+
+    SECTION("Rejected statements") {
+        for (const auto &query: wrong) {
+            INFO(query);
+            REQUIRE_FALSE(is_insert_or_replace(query));
+        }
+    }
+
+    SECTION("Never accepts what the regular expressions reject") {
+        for (const auto *corpus: {&right, &wrong}) {
+            for (const auto &query: *corpus) {
+                INFO(query);
+                if (!is_insert_or_replace_query_correct(query)) {
+                    REQUIRE_FALSE(is_insert_or_replace(query));
+                }
+            }
+        }
+    }
+
+    SECTION("Mutated statements") {
+        // Fixed seed: a failure names its statement and reproduces on every run
+        std::mt19937 random(20261017);
+        auto pick = [&random](size_t size) { return std::uniform_int_distribution<size_t>(0, size - 1)(random); };
+        // Line breaks are left out: the scanner takes them as blanks, the regular expressions do not
+        const std::vector<std::string> prefixes = {"/* comment */ ", "-- comment ", "# comment ", "SELECT ",
+                                                   "DELETE ", "(", ";", "\t", "x"};
+        const std::vector<std::string> spaces = {"  ", "\t", " \t "};
+        const std::string noise = "();,'\"`\\-#/*xX0 \t";
+
+        // Changing the case of the keywords or the width of the blanks keeps a statement valid
+        const std::vector<std::string> keywords = {"insert", "replace", "ignore", "into", "values", "default", "null"};
+        for (const auto &query: right) {
+            for (int i = 0; i < 50; ++i) {
+                std::string mutated;
+                size_t start = 0;
+                while (start < query.size()) {
+                    size_t end = start;
+                    while (end < query.size() && std::isalpha(static_cast<unsigned char>(query[end]))) {
+                        end++;
+                    }
+                    if (end == start) {
+                        const auto &space = spaces[pick(spaces.size())];
+                        mutated += query[start] == ' ' && pick(2) == 0 ? space : std::string(1, query[start]);
+                        start++;
+                        continue;
+                    }
+                    std::string word = query.substr(start, end - start);
+                    std::string lower = word;
+                    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+                    if (std::find(keywords.begin(), keywords.end(), lower) != keywords.end()) {
+                        for (auto &c: word) {
+                            c = static_cast<char>(pick(2) == 0 ? std::toupper(c) : std::tolower(c));
+                        }
+                    }
+                    mutated += word;
+                    start = end;
+                }
+                INFO(mutated);
+                REQUIRE(is_insert_or_replace(mutated));
+                REQUIRE(is_insert_or_replace_query_correct(mutated));
+            }
+        }
+
+        // Any other change may break a statement, the fast check must then reject it like the regular expressions
+        size_t accepted = 0;
+        size_t rejected = 0;
+        for (int i = 0; i < 4000; ++i) {
+            const auto &base = pick(2) == 0 ? right[pick(right.size())] : wrong[pick(wrong.size())];
+            std::string mutated = base;
+            for (size_t edits = 1 + pick(3); edits > 0; --edits) {
+                switch (pick(6)) {
+                    case 0:
+                        mutated = prefixes[pick(prefixes.size())] + mutated;
+                        break;
+                    case 1:
+                        mutated.resize(mutated.empty() ? 0 : pick(mutated.size()));
+                        break;
+                    case 2:
+                        mutated.insert(mutated.empty() ? 0 : pick(mutated.size()), 1, noise[pick(noise.size())]);
+                        break;
+                    case 3:
+                        if (!mutated.empty()) {
+                            mutated.erase(pick(mutated.size()), 1);
+                        }
+                        break;
+                    case 4: {
+                        const auto blank = mutated.find(' ', mutated.empty() ? 0 : pick(mutated.size()));
+                        if (blank != std::string::npos) {
+                            mutated.replace(blank, 1, spaces[pick(spaces.size())]);
+                        }
+                        break;
+                    }
+                    default:
+                        mutated += pick(2) == 0 ? " /* trailing */" : " -- trailing";
+                        break;
+                }
+            }
+            INFO(mutated);
+            const bool fast = is_insert_or_replace(mutated);
+            if (!is_insert_or_replace_query_correct(mutated)) {
+                REQUIRE_FALSE(fast);
+            }
+            fast ? accepted++ : rejected++;
+        }
+        // The corpus exercises both outcomes
+        REQUIRE(accepted > 0);
+        REQUIRE(rejected > 0);
+    }
+}
@@ -0,0 +1,111 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+#include <simple_mariadb/cache.h>
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ---------------------------------------------------------------------------------------------------
+using simple_mariadb::cache::ResultCache;
+using simple_mariadb::cache::Written;
+
+TEST_CASE("Tables read by a query", "[cache]") {
+    using simple_mariadb::cache::read_tables;
+    REQUIRE(simple_mariadb::cache::table_key("`Trading`.`Quotes`") == "quotes");
+    REQUIRE(simple_mariadb::cache::table_key("QUOTES") == "quotes");
+    REQUIRE(read_tables("SELECT * FROM quotes WHERE ticker = 'FROM other'") == std::vector<std::string>{"quotes"});
+    REQUIRE(read_tables("SELECT q.price FROM db.quotes AS q, fills f LEFT JOIN `trades` t ON q.id = t.id") ==
+            std::vector<std::string>{"fills", "quotes", "trades"});
+    REQUIRE(read_tables("SELECT * FROM (SELECT id FROM orders) o") == std::vector<std::string>{"orders"});
+    REQUIRE(read_tables("SELECT 1 FROM DUAL").empty());
+}
+
+TEST_CASE("Queries worth caching", "[cache]") {
+    using simple_mariadb::cache::is_cacheable;
+    REQUIRE(is_cacheable("SELECT * FROM quotes WHERE ticker = 'mysql.user'"));
+    REQUIRE(is_cacheable("  select q.price FROM db.quotes q JOIN trades t ON q.id = t.id"));
+    REQUIRE_FALSE(is_cacheable("select 1;"));
+    REQUIRE_FALSE(is_cacheable("SELECT NOW() FROM DUAL"));
+    REQUIRE_FALSE(is_cacheable("SHOW TABLES"));
+    REQUIRE_FALSE(is_cacheable("SELECT column_name FROM information_schema.columns WHERE table_name = 'quotes'"));
+    REQUIRE_FALSE(is_cacheable("SELECT * FROM `INFORMATION_SCHEMA`.`TABLES`"));
+    REQUIRE_FALSE(is_cacheable("SELECT * FROM quotes WHERE id IN (SELECT id FROM performance_schema.threads)"));
+    REQUIRE_FALSE(is_cacheable("SELECT user FROM mysql.user"));
+    REQUIRE_FALSE(is_cacheable("UPDATE quotes SET a = 1"));
+}
+
+TEST_CASE("Tables written by a statement", "[cache]") {
+    using simple_mariadb::cache::written_tables;
+    auto tables = [](std::string_view sql) { return written_tables(sql).tables; };
+
+    REQUIRE(written_tables("SELECT * FROM quotes").scope == Written::NONE);
+    REQUIRE(written_tables("COMMIT").scope == Written::NONE);
+    REQUIRE(tables("INSERT IGNORE INTO `quotes` (a) VALUES (1);") == std::vector<std::string>{"quotes"});
+    REQUIRE(tables("REPLACE INTO db.quotes VALUES (1)") == std::vector<std::string>{"quotes"});
+    REQUIRE(tables("UPDATE quotes q JOIN trades t ON q.id = t.id SET q.a = 1") ==
+            std::vector<std::string>{"quotes", "trades"});
+    REQUIRE(tables("DELETE FROM quotes WHERE id = 1") == std::vector<std::string>{"quotes"});
+    REQUIRE(tables("DELETE q FROM quotes q JOIN trades t ON q.id = t.id") ==
+            std::vector<std::string>{"q", "quotes", "trades"});
+    REQUIRE(tables("TRUNCATE TABLE quotes") == std::vector<std::string>{"quotes"});
+    REQUIRE(tables("DROP TABLE IF EXISTS quotes, trades") == std::vector<std::string>{"quotes", "trades"});
+    REQUIRE(tables("ALTER TABLE quotes ADD COLUMN a INT") == std::vector<std::string>{"quotes"});
+    REQUIRE(tables("CREATE TABLE IF NOT EXISTS quotes (id INT)") == std::vector<std::string>{"quotes"});
+    REQUIRE(tables("CREATE UNIQUE INDEX idx ON quotes (id)") == std::vector<std::string>{"quotes"});
+    REQUIRE(tables("RENAME TABLE quotes TO old_quotes") == std::vector<std::string>{"old_quotes", "quotes"});
+    REQUIRE(tables("LOAD DATA LOCAL INFILE 'q.csv' INTO TABLE quotes") == std::vector<std::string>{"quotes"});
+    REQUIRE(written_tables("CALL refresh()").scope == Written::ALL);
+    REQUIRE(written_tables("INSERT INTO a VALUES (1); DELETE FROM b").scope == Written::ALL);
+    REQUIRE(written_tables("DROP DATABASE trading").scope == Written::ALL);
+}
+
+TEST_CASE("Cache results until a write or their time to live", "[cache]") {
+    ResultCache cache(2, std::chrono::milliseconds(50));
+    auto started = cache.now();
+    cache.put("a", {"quotes"}, nlohmann::json::array({1}), started);
+    cache.put("b", {"trades"}, nlohmann::json::array({2}), started);
+
+    auto hit = cache.get("a");
+    REQUIRE(hit != nullptr);
+    REQUIRE(std::get<nlohmann::json>(*hit) == nlohmann::json::array({1}));
+    REQUIRE(cache.get("missing") == nullptr);
+
+    SECTION("least recently used entries are evicted") {
+        cache.put("c", {"fills"}, nlohmann::json::array({3}), cache.now());
+        REQUIRE(cache.get("b") == nullptr);
+        REQUIRE(cache.get("a") != nullptr);
+        REQUIRE(cache.get_stats().evictions == 1);
+    }
+
+    SECTION("writes invalidate the tables they change") {
+        cache.invalidate("INSERT INTO quotes VALUES (1)");
+        REQUIRE(cache.get("a") == nullptr);
+        REQUIRE(cache.get("b") != nullptr);
+        cache.invalidate("SELECT * FROM trades");
+        REQUIRE(cache.get("b") != nullptr);
+        cache.invalidate("CALL refresh()");
+        REQUIRE(cache.get("b") == nullptr);
+        REQUIRE(cache.get_stats().invalidations == 2);
+    }
+
+    SECTION("a result read before a write is not stored") {
+        started = cache.now();
+        cache.invalidate_table("`db`.`Quotes`");
+        cache.put("c", {"quotes"}, nlohmann::json::array({3}), started);
+        REQUIRE(cache.get("c") == nullptr);
+        cache.put("c", {"quotes"}, nlohmann::json::array({3}), cache.now());
+        REQUIRE(cache.get("c") != nullptr);
+    }
+
+    SECTION("entries expire") {
+        std::this_thread::sleep_for(std::chrono::milliseconds(60));
+        REQUIRE(cache.get("a") == nullptr);
+        auto stats = cache.get_stats();
+        REQUIRE(stats.expirations == 1);
+        REQUIRE(stats.size == 1);
+        REQUIRE(stats.to_json()["capacity"] == 2);
+    }
+}
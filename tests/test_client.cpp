@@ -10,8 +10,11 @@
 #include <catch2/benchmark/catch_benchmark.hpp>
 #include <string>
 #include <map>
+#include <filesystem>
 #include <random>
 #include <utility>
+#include <coroutine>
+#include <future>
 #include <catch2/matchers/catch_matchers_floating_point.hpp>
 
 // ---------------------------------------------------------------------------------------------------
@@ -194,7 +197,7 @@ TEST_CASE("Testing MariaDBManager installation", "[queue]") {
         simple_mariadb::config::MariaDBConfig config = get_default_config();
         REQUIRE(config.validate());
         config.logger->send<simple_logger::LogLevel::DEBUG>(config.to_string());
-        REQUIRE(config.to_string() == R"({"MariaDBConfig":{"autoreconnect":"true","checker_time":30,"connecttimeout":"30","dbname":"database","hostname":"localhost","multi_insert":true,"password":"password","port":3306,"queue_size":30000,"queue_timeout":2,"sockettimeout":"10000","tcpkeepalive":"true","user":"user"}})");
+        REQUIRE(config.to_string() == R"({"MariaDBConfig":{"async_threads":0,"autoreconnect":"true","batch_linger_ms":0,"batch_max_bytes":0,"batch_max_rows":1000,"checker_time":30,"connecttimeout":"30","dbname":"database","dead_letter_path":"","engine":"threads","engine_connections":16,"fetch_size":1000,"hostname":"localhost","load_chunk_size":1048576,"log_queries_per_second":10,"log_query_max_length":1024,"multi_insert":true,"multi_row_insert":false,"password":"password","port":3306,"query_cache_size":0,"query_cache_ttl_ms":5000,"queue_backend":"mutex","queue_overflow_policy":"block","queue_size":30000,"queue_timeout":2,"read_pool_max":0,"read_pool_size":1,"read_pool_timeout_ms":5000,"retry_backoff_ms":100,"retry_max_attempts":5,"retry_max_backoff_ms":30000,"sockettimeout":"10000","spill_dir":"","spill_max_bytes":1073741824,"spill_replay_rate":5000,"spill_segment_size":67108864,"statement_cache_size":64,"tcpkeepalive":"true","usebulkstmts":"true","user":"user","writer_threads":1}})");
     }
 }
 
@@ -615,4 +618,1056 @@ TEST_CASE("Testing ThreadQueue select types functionality", "[queue]") {
         }
     }
 
-}
\ No newline at end of file
+}
+TEST_CASE("Testing parallel writers", "[queue]") {
+    size_t size = 100;
+    simple_mariadb::config::MariaDBConfig config = get_env_config();
+    config.multi_insert = false;
+    config.writer_threads = 4;
+    MariaDBManager dbManager(config);
+    REQUIRE(dbManager.is_connected());
+    REQUIRE(dbManager.is_thread_running());
+
+    CreateAndDestroy createAndDestroy;
+    REQUIRE(createAndDestroy.table_created_successfully);
+    std::map<std::string, std::string> columns;
+    columns["name"] = "VARCHAR(255) NOT NULL";
+    columns["number"] = "INT NOT NULL";
+    REQUIRE(dbManager.add_columns_to_table(createAndDestroy.table, columns));
+
+    auto id = common::key_generator();
+    for (int j = 0; j < size; ++j) {
+        std::string query = "INSERT INTO " + createAndDestroy.table + " (name, number) VALUES ('" + id + "', " +
+                            std::to_string(j) + ");";
+        REQUIRE(dbManager.enqueue(query) == true);
+    }
+    dbManager.stop();
+    REQUIRE_FALSE(dbManager.is_thread_running());
+
+    auto stats = dbManager.get_stats();
+    REQUIRE(stats.writers.size() == 4);
+    size_t executed = 0;
+    for (auto &writer: stats.writers) {
+        executed += writer.executed;
+        REQUIRE(writer.connected); // published by the writer thread, read without its lock
+    }
+    REQUIRE(executed == size);
+
+    auto result = dbManager.query_to_json("SELECT * FROM " + createAndDestroy.table + " where `name` = '" + id + "';");
+    REQUIRE(result.size() == size);
+}
+
+TEST_CASE("Testing ring queue", "[queue]") {
+    size_t producers = 4;
+    size_t size = 250;
+    simple_mariadb::config::MariaDBConfig config = get_env_config();
+    config.queue_backend = "ring";
+    config.queue_overflow_policy = "block";
+    config.multi_insert = true;
+    config.writer_threads = 2;
+    MariaDBManager dbManager(config);
+    REQUIRE(dbManager.is_connected());
+
+    CreateAndDestroy createAndDestroy;
+    REQUIRE(createAndDestroy.table_created_successfully);
+    std::map<std::string, std::string> columns;
+    columns["name"] = "VARCHAR(255) NOT NULL";
+    columns["number"] = "INT NOT NULL";
+    REQUIRE(dbManager.add_columns_to_table(createAndDestroy.table, columns));
+
+    auto id = common::key_generator();
+    std::atomic<size_t> failed = 0;
+    std::vector<std::thread> threads;
+    for (size_t p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p] {
+            for (size_t j = 0; j < size; ++j) {
+                std::string query = "INSERT INTO " + createAndDestroy.table + " (name, number) VALUES ('" + id +
+                                    "', " + std::to_string(p * size + j) + ");";
+                if (!dbManager.enqueue(query)) {
+                    failed++;
+                }
+            }
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    REQUIRE(failed == 0);
+    dbManager.stop();
+
+    auto stats = dbManager.get_stats();
+    REQUIRE(stats.queue.backend == "ring");
+    REQUIRE(stats.queue.enqueued == producers * size);
+    REQUIRE(stats.queue.dequeued == producers * size);
+
+    auto result = dbManager.query_to_json("SELECT * FROM " + createAndDestroy.table + " where `name` = '" + id + "';");
+    REQUIRE(result.size() == producers * size);
+}
+
+TEST_CASE("Testing nonblocking engine", "[engine]") {
+    size_t size = 2000;
+    simple_mariadb::config::MariaDBConfig config = get_env_config();
+    config.engine = "nonblocking";
+    config.engine_connections = 8;
+    MariaDBManager dbManager(config);
+    REQUIRE(dbManager.is_connected());
+
+    CreateAndDestroy createAndDestroy;
+    REQUIRE(createAndDestroy.table_created_successfully);
+    std::map<std::string, std::string> columns;
+    columns["name"] = "VARCHAR(255) NULL";
+    columns["number"] = "INT NOT NULL";
+    REQUIRE(dbManager.add_columns_to_table(createAndDestroy.table, columns));
+
+    auto id = common::key_generator();
+    for (size_t j = 0; j < size; ++j) {
+        REQUIRE(dbManager.enqueue("INSERT INTO " + createAndDestroy.table + " (name, number) VALUES ('" + id + "', " +
+                                  std::to_string(j) + ");"));
+    }
+    REQUIRE(dbManager.enqueue("INSERT INTO " + createAndDestroy.table + " (number) VALUES (NULL);"));
+    dbManager.stop();
+
+    auto stats = dbManager.get_stats();
+    REQUIRE(stats.engine.connections == 8);
+    REQUIRE(stats.engine.completed == size);
+    REQUIRE(stats.engine.failed == 1);
+    REQUIRE(stats.writers.size() == 1);
+    REQUIRE(stats.writers.front().executed == size);
+
+    const std::string query = "SELECT name, number FROM " + createAndDestroy.table + " WHERE name = '" + id +
+                              "' ORDER BY number;";
+    std::vector<std::future<simple_mariadb::engine::Result>> reads;
+    for (int i = 0; i < 32; ++i) {
+        reads.push_back(dbManager.execute_async(query));
+    }
+    for (auto &read: reads) {
+        auto result = read.get();
+        REQUIRE(result.ok);
+        REQUIRE(result.rows.rows() == size);
+        REQUIRE(result.rows[size - 1]["number"] == std::to_string(size - 1));
+    }
+    auto rows = dbManager.select_async(query).get();
+    REQUIRE(rows.size() == size);
+    REQUIRE(rows.front()["name"] == id);
+
+    auto update = dbManager.execute_async("UPDATE " + createAndDestroy.table + " SET name = NULL WHERE name = '" +
+                                          id + "' AND number < 10;").get();
+    REQUIRE(update.ok);
+    REQUIRE(update.affected_rows == 10);
+
+    auto failed = dbManager.execute_async("SELECT * FROM missing_table_" + id).get();
+    REQUIRE_FALSE(failed.ok);
+    REQUIRE(failed.error_code != 0);
+    REQUIRE_THROWS_AS(dbManager.select_async("SELECT * FROM missing_table_" + id).get(), sql::SQLException);
+}
+
+TEST_CASE("Testing nonblocking engine keeps the order of a table", "[engine]") {
+    size_t size = 500;
+    simple_mariadb::config::MariaDBConfig config = get_env_config();
+    config.engine = "nonblocking";
+    config.engine_connections = 8;
+    MariaDBManager dbManager(config);
+    REQUIRE(dbManager.is_connected());
+
+    CreateAndDestroy createAndDestroy;
+    REQUIRE(createAndDestroy.table_created_successfully);
+    std::map<std::string, std::string> columns;
+    columns["name"] = "VARCHAR(255) NULL";
+    columns["number"] = "INT NOT NULL";
+    REQUIRE(dbManager.add_columns_to_table(createAndDestroy.table, columns));
+
+    // Each DELETE removes the row inserted just before it, run out of order it would find nothing
+    auto id = common::key_generator();
+    for (size_t j = 0; j < size; ++j) {
+        REQUIRE(dbManager.enqueue("INSERT INTO " + createAndDestroy.table + " (name, number) VALUES ('" + id + "', " +
+                                  std::to_string(j) + ");"));
+        if (j % 2 == 0) {
+            REQUIRE(dbManager.enqueue("DELETE FROM " + createAndDestroy.table + " WHERE number = " +
+                                      std::to_string(j) + ";"));
+        }
+    }
+    dbManager.stop();
+
+    auto result = dbManager.query_to_json("SELECT * FROM " + createAndDestroy.table + " where `name` = '" + id + "';");
+    REQUIRE(result.size() == size / 2);
+}
+
+TEST_CASE("Testing engine needs nonblocking", "[engine]") {
+    simple_mariadb::config::MariaDBConfig config = get_env_config();
+    MariaDBManager dbManager(config);
+    REQUIRE_THROWS_AS(dbManager.execute_async("SELECT 1"), std::runtime_error);
+}
+
+TEST_CASE("Testing read pool", "[pool]") {
+    simple_mariadb::config::MariaDBConfig config = get_env_config();
+    config.read_pool_size = 2;
+    config.read_pool_max = 4;
+    MariaDBManager dbManager(config);
+    REQUIRE(dbManager.is_connected());
+
+    std::vector<std::thread> readers;
+    std::atomic<size_t> successes = 0;
+    for (int i = 0; i < 8; ++i) {
+        readers.emplace_back([&dbManager, &successes]() {
+            for (int j = 0; j < 10; ++j) {
+                auto rows = dbManager.query_to_json("SELECT 1 AS one;");
+                if (rows.size() == 1 && rows[0]["one"] == 1) {
+                    successes++;
+                }
+            }
+        });
+    }
+    for (auto &reader: readers) {
+        reader.join();
+    }
+    REQUIRE(successes == 80);
+
+    auto stats = dbManager.get_read_pool_stats();
+    REQUIRE(stats.acquired >= 80);
+    REQUIRE(stats.size <= 4);
+    REQUIRE(stats.in_use == 0);
+    REQUIRE(stats.timeouts == 0);
+}
+
+TEST_CASE("Testing prepared statements", "[prepared]") {
+    simple_mariadb::config::MariaDBConfig config = get_env_config();
+    MariaDBManager dbManager(config);
+    REQUIRE(dbManager.is_connected());
+
+    CreateAndDestroy createAndDestroy;
+    REQUIRE(createAndDestroy.table_created_successfully);
+    std::map<std::string, std::string> columns;
+    columns["name"] = "VARCHAR(255) NOT NULL";
+    columns["number"] = "INT NOT NULL";
+    columns["f"] = "DOUBLE NULL";
+    REQUIRE(dbManager.add_columns_to_table(createAndDestroy.table, columns));
+
+    const std::string insert = "INSERT INTO " + createAndDestroy.table + " (name, number, f) VALUES (?, ?, ?);";
+    auto id = common::key_generator();
+    for (int j = 0; j < 10; ++j) {
+        std::optional<double> f;
+        if (j % 2 == 0) {
+            f = 2.5;
+        }
+        REQUIRE(dbManager.execute_prepared(insert, "it's " + id, j, f));
+    }
+
+    auto result = dbManager.query_prepared(
+            "SELECT * FROM " + createAndDestroy.table + " WHERE name = ? ORDER BY number;", "it's " + id);
+    REQUIRE(result.size() == 10);
+    for (int i = 0; i < 10; ++i) {
+        REQUIRE(result[i]["number"] == i);
+        REQUIRE(result[i]["f"].is_null() == (i % 2 != 0));
+    }
+
+    auto stats = dbManager.get_stats();
+    REQUIRE(stats.statements.hits >= 9);
+}
+
+TEST_CASE("Testing statement cache across reconnects", "[prepared]") {
+    simple_mariadb::config::MariaDBConfig config = get_env_config();
+    sql::Driver *driver = sql::mariadb::get_driver_instance();
+    auto connect = [&]() {
+        sql::Properties properties(config.get_options());
+        return std::shared_ptr<sql::Connection>(driver->connect(sql::SQLString(config.uri), properties));
+    };
+
+    simple_mariadb::statement::StatementCache cache(4);
+    const std::string sql = "SELECT ?;";
+    auto conn = connect();
+    REQUIRE(conn != nullptr);
+    cache.get(conn, sql);
+    cache.get(conn, "SELECT ? + 1;");
+
+    // A reconnect replaces the connection of the caller, the cached statements must not outlive the old one
+    conn = connect();
+    REQUIRE(conn != nullptr);
+    cache.evict(sql);
+    sql::PreparedStatement &stmt = cache.get(conn, sql);
+    stmt.setInt(1, 7);
+    std::unique_ptr<sql::ResultSet> result(stmt.executeQuery());
+    REQUIRE(result->next());
+    REQUIRE(result->getInt(1) == 7);
+    auto stats = cache.get_stats();
+    REQUIRE(stats.resets == 1);
+    REQUIRE(stats.size == 1);
+    REQUIRE(stats.misses == 3);
+
+    conn = connect();
+    cache.clear();
+    REQUIRE(cache.get_stats().size == 0);
+}
+
+TEST_CASE("Testing typed rows", "[rows]") {
+    size_t size = 250;
+    simple_mariadb::config::MariaDBConfig config = get_env_config();
+    config.batch_max_rows = 100;
+    MariaDBManager dbManager(config);
+    REQUIRE(dbManager.is_connected());
+
+    CreateAndDestroy createAndDestroy;
+    REQUIRE(createAndDestroy.table_created_successfully);
+    std::map<std::string, std::string> columns;
+    columns["name"] = "VARCHAR(255) NOT NULL";
+    columns["number"] = "INT NOT NULL";
+    columns["f"] = "DOUBLE NULL";
+    REQUIRE(dbManager.add_columns_to_table(createAndDestroy.table, columns));
+
+    auto id = common::key_generator();
+    for (int j = 0; j < size; ++j) {
+        REQUIRE(dbManager.enqueue_row(createAndDestroy.table, {"name", "number", "f"}, "it's " + id, j, 2.5));
+    }
+    REQUIRE_FALSE(dbManager.enqueue_row(createAndDestroy.table, {"name", "number", "f"}, id, 1));
+    dbManager.flush_rows();
+    REQUIRE(dbManager.pending_rows() == 0);
+
+    auto stats = dbManager.get_stats();
+    REQUIRE(stats.row_writer.executed == size);
+    REQUIRE(stats.row_writer.failed == 0);
+
+    auto result = dbManager.query_prepared("SELECT * FROM " + createAndDestroy.table + " WHERE name = ?;", "it's " + id);
+    REQUIRE(result.size() == size);
+}
+
+TEST_CASE("Testing typed rows rejected by a constraint", "[rows][retry]") {
+    simple_mariadb::config::MariaDBConfig config = get_env_config();
+    MariaDBManager dbManager(config);
+    REQUIRE(dbManager.is_connected());
+
+    CreateAndDestroy createAndDestroy;
+    REQUIRE(createAndDestroy.table_created_successfully);
+    std::map<std::string, std::string> columns;
+    columns["name"] = "VARCHAR(255) NOT NULL";
+    columns["number"] = "INT NOT NULL UNIQUE";
+    REQUIRE(dbManager.add_columns_to_table(createAndDestroy.table, columns));
+
+    std::mutex mutex;
+    std::vector<simple_mariadb::retry::DeadLetter> letters;
+    dbManager.set_dead_letter_callback([&](const simple_mariadb::retry::DeadLetter &letter) {
+        std::lock_guard<std::mutex> lock(mutex);
+        letters.push_back(letter);
+    });
+
+    auto id = common::key_generator();
+    REQUIRE(dbManager.enqueue_row(createAndDestroy.table, {"name", "number"}, id, 1));
+    dbManager.flush_rows();
+    REQUIRE(dbManager.enqueue_row(createAndDestroy.table, {"name", "number"}, id, 1)); // duplicate key
+    dbManager.flush_rows();
+    dbManager.stop();
+
+    auto stats = dbManager.get_stats();
+    REQUIRE(stats.row_writer.executed == 1);
+    REQUIRE(stats.row_writer.failed == 1);
+    REQUIRE(stats.retry.permanent == 1);
+    REQUIRE(stats.retry.dead_lettered == 1);
+    std::lock_guard<std::mutex> lock(mutex);
+    REQUIRE(letters.size() == 1);
+    REQUIRE(letters.front().statement == "INSERT INTO `" + createAndDestroy.table + "` (`name`,`number`) VALUES ('" +
+                                         id + "',1)");
+    REQUIRE(letters.front().reason == "permanent");
+    REQUIRE(letters.front().failure.error_code == 1062);
+}
+
+TEST_CASE("Testing bulk load", "[load_data]") {
+    size_t size = 5000;
+    simple_mariadb::config::MariaDBConfig config = get_env_config();
+    config.load_chunk_size = 4096;
+    MariaDBManager dbManager(config);
+    REQUIRE(dbManager.is_connected());
+
+    CreateAndDestroy createAndDestroy;
+    REQUIRE(createAndDestroy.table_created_successfully);
+    std::map<std::string, std::string> columns;
+    columns["name"] = "VARCHAR(255) NOT NULL";
+    columns["number"] = "INT NOT NULL";
+    columns["f"] = "DOUBLE NULL";
+    REQUIRE(dbManager.add_columns_to_table(createAndDestroy.table, columns));
+
+    auto id = common::key_generator();
+    size_t next = 0;
+    auto stats = dbManager.load_data(createAndDestroy.table, {"name", "number", "f"},
+                                     [&](std::vector<simple_mariadb::rows::Value> &row) {
+                                         if (next == size) {
+                                             return false;
+                                         }
+                                         row.emplace_back("it's\t" + id);
+                                         row.emplace_back(static_cast<int64_t>(next));
+                                         row.emplace_back(next % 2 ? simple_mariadb::rows::Value(nullptr) : 0.5);
+                                         next++;
+                                         return true;
+                                     });
+    REQUIRE(stats.rows == size);
+    REQUIRE(stats.affected == size);
+    REQUIRE(stats.chunks > 1);
+    REQUIRE(stats.bytes > 0);
+
+    std::vector<std::vector<simple_mariadb::rows::Value>> rows = {
+            {std::string("buffered " + id), int64_t(1), nullptr},
+            {std::string("buffered " + id), int64_t(2), 1.0}
+    };
+    REQUIRE(dbManager.load_data(createAndDestroy.table, {"name", "number", "f"}, rows).rows == 2);
+
+    auto result = dbManager.query_prepared("SELECT * FROM " + createAndDestroy.table + " WHERE name = ?;", "it's\t" + id);
+    REQUIRE(result.size() == size);
+    result = dbManager.query_prepared("SELECT * FROM " + createAndDestroy.table + " WHERE f IS NULL;");
+    REQUIRE(result.size() == size / 2 + 1);
+
+    std::vector<std::vector<simple_mariadb::rows::Value>> invalid = {{std::string("short")}};
+    REQUIRE_THROWS(dbManager.load_data(createAndDestroy.table, {"name", "number", "f"}, invalid));
+    REQUIRE(dbManager.get_error_counter() == 1);
+}
+
+TEST_CASE("Testing spill log", "[spill]") {
+    size_t size = 300;
+    auto spill_dir = std::filesystem::temp_directory_path() / ("simple_mariadb_spill_" + common::key_generator());
+    simple_mariadb::config::MariaDBConfig config = get_env_config();
+    config.queue_size = 10;
+    config.spill_dir = spill_dir.string();
+    config.spill_segment_size = 64 * 1024;
+    config.spill_replay_rate = 1000;
+
+    CreateAndDestroy createAndDestroy;
+    REQUIRE(createAndDestroy.table_created_successfully);
+    auto id = common::key_generator();
+    {
+        MariaDBManager dbManager(config);
+        REQUIRE(dbManager.is_connected());
+        std::map<std::string, std::string> columns;
+        columns["name"] = "VARCHAR(255) NOT NULL";
+        columns["number"] = "INT NOT NULL";
+        REQUIRE(dbManager.add_columns_to_table(createAndDestroy.table, columns));
+
+        for (int j = 0; j < size; ++j) {
+            std::string query = "INSERT INTO " + createAndDestroy.table + " (name, number) VALUES ('" + id + "', " +
+                                std::to_string(j) + ");";
+            REQUIRE(dbManager.enqueue(query));
+        }
+        auto stats = dbManager.get_stats();
+        REQUIRE(stats.spill.appended > 0);
+        dbManager.stop(true); // what was not replayed yet stays in the spill log
+    }
+    {
+        MariaDBManager dbManager(config);
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (dbManager.get_stats().spill.pending > 0 && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        REQUIRE(dbManager.get_stats().spill.pending == 0);
+        dbManager.stop();
+        auto result = dbManager.query_to_json(
+                "SELECT DISTINCT number FROM " + createAndDestroy.table + " where `name` = '" + id + "';");
+        REQUIRE(result.size() == size);
+    }
+    std::filesystem::remove_all(spill_dir);
+}
+
+TEST_CASE("Testing streaming cursor", "[cursor]") {
+    size_t size = 500;
+    simple_mariadb::config::MariaDBConfig config = get_env_config();
+    config.fetch_size = 50;
+    MariaDBManager dbManager(config);
+    REQUIRE(dbManager.is_connected());
+
+    CreateAndDestroy createAndDestroy;
+    REQUIRE(createAndDestroy.table_created_successfully);
+    std::map<std::string, std::string> columns;
+    columns["name"] = "VARCHAR(255) NULL";
+    columns["number"] = "INT NOT NULL";
+    REQUIRE(dbManager.add_columns_to_table(createAndDestroy.table, columns));
+
+    auto id = common::key_generator();
+    for (int j = 0; j < size; ++j) {
+        REQUIRE(dbManager.execute_prepared("INSERT INTO " + createAndDestroy.table + " (name, number) VALUES (?, ?);",
+                                           id, j));
+    }
+    const std::string query = "SELECT name, number FROM " + createAndDestroy.table + " WHERE name = '" + id +
+                              "' ORDER BY number;";
+
+    SECTION("for_each_row") {
+        int64_t sum = 0;
+        size_t visited = dbManager.for_each_row(query, [&sum](sql::ResultSet &row) {
+            sum += row.getInt(2);
+            return true;
+        });
+        REQUIRE(visited == size);
+        REQUIRE(sum == static_cast<int64_t>(size * (size - 1) / 2));
+
+        visited = dbManager.for_each_row(query, [](sql::ResultSet &row) { return row.getInt(2) < 9; }, 5);
+        REQUIRE(visited == 10);
+        // Stopping early hands the connection back in a usable state
+        REQUIRE(dbManager.query_to_json(query).size() == size);
+    }
+
+    SECTION("Cursor") {
+        auto cursor = dbManager.open_cursor(query);
+        REQUIRE(cursor.is_open());
+        REQUIRE(cursor.meta()->getColumnCount() == 2);
+        int expected = 0;
+        while (cursor.next()) {
+            REQUIRE(cursor.row().getInt(2) == expected++);
+        }
+        REQUIRE(cursor.rows() == size);
+        REQUIRE_FALSE(cursor.is_open());
+        REQUIRE_FALSE(cursor.next());
+        REQUIRE(dbManager.get_read_pool_stats().in_use == 0);
+    }
+
+    SECTION("select") {
+        auto rows = dbManager.select(query);
+        REQUIRE(rows.size() == size);
+        REQUIRE(rows.front()["name"] == id);
+        REQUIRE(rows.back()["number"] == std::to_string(size - 1));
+    }
+
+    SECTION("select into a ResultTable") {
+        simple_mariadb::table::ResultTable table;
+        REQUIRE(dbManager.select(query, table) == size);
+        REQUIRE(table.header() == std::vector<std::string>{"name", "number"});
+        REQUIRE(table[0]["name"] == id);
+        REQUIRE(table.at(size - 1, 1) == std::to_string(size - 1));
+        // A second select reuses the table
+        REQUIRE(dbManager.select(query, table) == size);
+        REQUIRE(table.rows() == size);
+    }
+}
+
+namespace {
+    struct AsyncTask {
+        struct promise_type {
+            AsyncTask get_return_object() { return {}; }
+
+            std::suspend_never initial_suspend() noexcept { return {}; }
+
+            std::suspend_never final_suspend() noexcept { return {}; }
+
+            void return_void() {}
+
+            void unhandled_exception() { std::terminate(); }
+        };
+    };
+
+    AsyncTask count_rows(MariaDBManager &dbManager, std::string query, std::promise<size_t> &done) {
+        try {
+            auto rows = co_await dbManager.co_select(query);
+            done.set_value(rows.size());
+        } catch (...) {
+            done.set_exception(std::current_exception());
+        }
+    }
+}
+
+TEST_CASE("Testing async reads", "[async]") {
+    size_t size = 50;
+    simple_mariadb::config::MariaDBConfig config = get_env_config();
+    config.read_pool_size = 2;
+    config.read_pool_max = 4;
+    MariaDBManager dbManager(config);
+    REQUIRE(dbManager.is_connected());
+
+    CreateAndDestroy createAndDestroy;
+    REQUIRE(createAndDestroy.table_created_successfully);
+    std::map<std::string, std::string> columns;
+    columns["name"] = "VARCHAR(255) NULL";
+    columns["number"] = "INT NOT NULL";
+    REQUIRE(dbManager.add_columns_to_table(createAndDestroy.table, columns));
+
+    auto id = common::key_generator();
+    for (int j = 0; j < size; ++j) {
+        REQUIRE(dbManager.execute_prepared("INSERT INTO " + createAndDestroy.table + " (name, number) VALUES (?, ?);",
+                                           id, j));
+    }
+    const std::string query = "SELECT name, number FROM " + createAndDestroy.table + " WHERE name = '" + id + "';";
+
+    SECTION("Futures") {
+        std::vector<std::future<std::vector<std::map<std::string, std::string>>>> selects;
+        for (int i = 0; i < 20; ++i) {
+            selects.push_back(dbManager.select_async(query));
+        }
+        auto result = dbManager.query_async(query);
+        for (auto &select: selects) {
+            REQUIRE(select.get().size() == size);
+        }
+        REQUIRE(MariaDBManager::resultset_to_json(*result.get()).size() == size);
+        REQUIRE_THROWS_AS(dbManager.select_async("SELECT * FROM missing_table_" + id).get(), sql::SQLException);
+
+        auto stats = dbManager.get_stats();
+        REQUIRE(stats.async.threads == 4);
+        REQUIRE(stats.async.submitted == 22);
+        REQUIRE(stats.read_pool.in_use == 0);
+    }
+
+    SECTION("Coroutines") {
+        std::vector<std::promise<size_t>> done(10);
+        for (auto &promise: done) {
+            count_rows(dbManager, query, promise);
+        }
+        for (auto &promise: done) {
+            REQUIRE(promise.get_future().get() == size);
+        }
+    }
+}
+
+namespace {
+    struct MappedRow {
+        std::string name;
+        int32_t number = 0;
+        int64_t big = 0;
+        double price = 0.0;
+        bool flag = false;
+        std::optional<std::string> note;
+        std::optional<int64_t> maybe;
+    };
+}
+
+template<>
+struct simple_mariadb::mapping::Descriptor<MappedRow> {
+    static constexpr auto fields = std::make_tuple(field("name", &MappedRow::name),
+                                                   field("number", &MappedRow::number),
+                                                   field("big", &MappedRow::big),
+                                                   field("price", &MappedRow::price),
+                                                   field("flag", &MappedRow::flag),
+                                                   field("note", &MappedRow::note),
+                                                   field("maybe", &MappedRow::maybe));
+};
+
+namespace {
+    struct MissingColumnRow {
+        std::string name;
+        int32_t absent = 0;
+    };
+}
+
+template<>
+struct simple_mariadb::mapping::Descriptor<MissingColumnRow> {
+    static constexpr auto fields = std::make_tuple(field("name", &MissingColumnRow::name),
+                                                   field("absent", &MissingColumnRow::absent));
+};
+
+TEST_CASE("Testing typed row mapping", "[mapping]") {
+    size_t size = 100;
+    simple_mariadb::config::MariaDBConfig config = get_env_config();
+    MariaDBManager dbManager(config);
+    REQUIRE(dbManager.is_connected());
+
+    CreateAndDestroy createAndDestroy;
+    REQUIRE(createAndDestroy.table_created_successfully);
+    std::map<std::string, std::string> columns;
+    columns["name"] = "VARCHAR(255) NULL";
+    columns["number"] = "INT NOT NULL";
+    columns["big"] = "BIGINT NOT NULL";
+    columns["price"] = "DOUBLE NOT NULL";
+    columns["flag"] = "BOOLEAN NOT NULL";
+    columns["note"] = "VARCHAR(255) NULL";
+    columns["maybe"] = "BIGINT NULL";
+    REQUIRE(dbManager.add_columns_to_table(createAndDestroy.table, columns));
+
+    auto id = common::key_generator();
+    for (int j = 0; j < size; ++j) {
+        std::optional<std::string> note;
+        std::optional<int64_t> maybe;
+        if (j % 2 == 0) {
+            note = "note " + std::to_string(j);
+            maybe = -static_cast<int64_t>(j);
+        }
+        REQUIRE(dbManager.execute_prepared("INSERT INTO " + createAndDestroy.table +
+                                           " (name, number, big, price, flag, note, maybe) VALUES (?, ?, ?, ?, ?, ?, ?);",
+                                           id, j, int64_t(j) << 40, j * 0.5, j % 3 == 0, note, maybe));
+    }
+    // Columns in another order than the descriptor, with an alias, are matched by name
+    const std::string query = "SELECT maybe, note, flag, price, big, number, name AS NAME FROM " +
+                              createAndDestroy.table + " WHERE name = '" + id + "' ORDER BY number;";
+
+    SECTION("select_as") {
+        auto rows = dbManager.select_as<MappedRow>(query);
+        REQUIRE(rows.size() == size);
+        for (int j = 0; j < size; ++j) {
+            const auto &row = rows[j];
+            REQUIRE(row.name == id);
+            REQUIRE(row.number == j);
+            REQUIRE(row.big == int64_t(j) << 40);
+            REQUIRE_THAT(row.price, Catch::Matchers::WithinRel(j * 0.5));
+            REQUIRE(row.flag == (j % 3 == 0));
+            if (j % 2 == 0) {
+                REQUIRE(row.note == "note " + std::to_string(j));
+                REQUIRE(row.maybe == -static_cast<int64_t>(j));
+            } else {
+                REQUIRE_FALSE(row.note.has_value());
+                REQUIRE_FALSE(row.maybe.has_value());
+            }
+        }
+    }
+
+    SECTION("for_each_as") {
+        int64_t sum = 0;
+        size_t visited = dbManager.for_each_as<MappedRow>(query, [&sum](MappedRow &row) {
+            sum += row.number;
+            return true;
+        }, 10);
+        REQUIRE(visited == size);
+        REQUIRE(sum == static_cast<int64_t>(size * (size - 1) / 2));
+
+        visited = dbManager.for_each_as<MappedRow>(query, [](MappedRow &row) { return row.number < 4; });
+        REQUIRE(visited == 5);
+        REQUIRE(dbManager.get_read_pool_stats().in_use == 0);
+    }
+
+    SECTION("Missing column") {
+        REQUIRE_THROWS_AS(dbManager.select_as<MissingColumnRow>(query), std::runtime_error);
+        REQUIRE(dbManager.get_read_pool_stats().in_use == 0);
+    }
+}
+
+TEST_CASE("Testing columnar select", "[columnar]") {
+    size_t size = 300;
+    simple_mariadb::config::MariaDBConfig config = get_env_config();
+    config.fetch_size = 64;
+    MariaDBManager dbManager(config);
+    REQUIRE(dbManager.is_connected());
+
+    CreateAndDestroy createAndDestroy;
+    REQUIRE(createAndDestroy.table_created_successfully);
+    std::map<std::string, std::string> columns;
+    columns["name"] = "VARCHAR(255) NULL";
+    columns["number"] = "INT NOT NULL";
+    columns["price"] = "DOUBLE NULL";
+    columns["flag"] = "BOOLEAN NOT NULL";
+    REQUIRE(dbManager.add_columns_to_table(createAndDestroy.table, columns));
+
+    auto id = common::key_generator();
+    for (int j = 0; j < size; ++j) {
+        std::optional<double> price;
+        if (j % 4 != 0) {
+            price = j * 0.25;
+        }
+        REQUIRE(dbManager.execute_prepared("INSERT INTO " + createAndDestroy.table +
+                                           " (name, number, price, flag) VALUES (?, ?, ?, ?);",
+                                           id, j, price, j % 2 == 0));
+    }
+
+    auto result = dbManager.select_columnar("SELECT name, number, price, flag FROM " + createAndDestroy.table +
+                                            " WHERE name = '" + id + "' ORDER BY number;");
+    REQUIRE(result.rows() == size);
+    REQUIRE(result.columns().size() == 4);
+    REQUIRE(dbManager.get_read_pool_stats().in_use == 0);
+
+    const auto &number = result.column("number");
+    REQUIRE(number.type() == simple_mariadb::columnar::ColumnType::INT64);
+    REQUIRE(number.null_count() == 0);
+    int64_t sum = 0;
+    for (int64_t value: number.int64s()) {
+        sum += value;
+    }
+    REQUIRE(sum == static_cast<int64_t>(size * (size - 1) / 2));
+
+    const auto &price = result.column("price");
+    REQUIRE(price.type() == simple_mariadb::columnar::ColumnType::DOUBLE);
+    REQUIRE(price.null_count() == size / 4);
+    REQUIRE(price.is_null(0));
+    REQUIRE_THAT(price.doubles()[3], Catch::Matchers::WithinRel(0.75));
+
+    REQUIRE(result.column("name").string(size - 1) == id);
+    REQUIRE(result.column("flag").size() == size);
+}
+
+namespace {
+    // resultset_to_json before the column plan: metadata calls and a lookup by name for every cell
+    json legacy_resultset_to_json(sql::ResultSet &res) {
+        json result;
+        auto meta = res.getMetaData();
+        const size_t numColumns = meta->getColumnCount();
+        while (res.next()) {
+            json row;
+            for (size_t i = 1; i <= numColumns; ++i) {
+                const std::string columnName = std::string(meta->getColumnName(i));
+                const auto columnType = static_cast<sql::DataType>(meta->getColumnType(i));
+                if (res.wasNull()) {
+                    row[columnName] = nullptr;
+                    continue;
+                }
+                switch (columnType) {
+                    case sql::INTEGER:
+                        row[columnName] = res.getInt(columnName);
+                        break;
+                    case sql::BIGINT:
+                        row[columnName] = res.getInt64(columnName);
+                        break;
+                    case sql::DOUBLE:
+                        row[columnName] = res.getDouble(columnName);
+                        break;
+                    default:
+                        row[columnName] = res.getString(columnName);
+                        break;
+                }
+            }
+            result.push_back(row);
+        }
+        return result;
+    }
+
+    // A table with `width` columns of mixed types filled with `rows` rows
+    void fill_wide_table(MariaDBManager &dbManager, const std::string &table, size_t width, size_t rows) {
+        std::map<std::string, std::string> columns;
+        for (size_t c = 0; c < width; ++c) {
+            const std::string type = c % 3 == 0 ? "INT NULL" : c % 3 == 1 ? "BIGINT NULL" : "VARCHAR(64) NULL";
+            columns["c" + std::to_string(c)] = type;
+        }
+        REQUIRE(dbManager.add_columns_to_table(table, columns));
+        std::string query = "INSERT INTO " + table + " (";
+        for (size_t c = 0; c < width; ++c) {
+            query += (c ? ",c" : "c") + std::to_string(c);
+        }
+        query += ") VALUES ";
+        for (size_t r = 0; r < rows; ++r) {
+            query += r ? ",(" : "(";
+            for (size_t c = 0; c < width; ++c) {
+                query += (c ? "," : "") + (c % 3 == 2 ? "'value " + std::to_string(r) + "'" : std::to_string(r * c));
+            }
+            query += ")";
+        }
+        REQUIRE(dbManager.execute_prepared(query + ";"));
+    }
+}
+
+TEST_CASE("Testing resultset_to_json NULL detection", "[decoder]") {
+    simple_mariadb::config::MariaDBConfig config = get_env_config();
+    MariaDBManager dbManager(config);
+    REQUIRE(dbManager.is_connected());
+
+    CreateAndDestroy createAndDestroy;
+    REQUIRE(createAndDestroy.table_created_successfully);
+    std::map<std::string, std::string> columns;
+    columns["a"] = "INT NULL";
+    columns["b"] = "VARCHAR(16) NULL";
+    columns["c"] = "DOUBLE NULL";
+    REQUIRE(dbManager.add_columns_to_table(createAndDestroy.table, columns));
+    REQUIRE(dbManager.execute_prepared("INSERT INTO " + createAndDestroy.table + " (a, b, c) VALUES (?, ?, ?);",
+                                       nullptr, "x", nullptr));
+    REQUIRE(dbManager.execute_prepared("INSERT INTO " + createAndDestroy.table + " (a, b, c) VALUES (?, ?, ?);",
+                                       0, nullptr, 1.5));
+
+    auto result = dbManager.query_to_json("SELECT a, b, c FROM " + createAndDestroy.table + " ORDER BY b DESC;");
+    REQUIRE(result.size() == 2);
+    // A NULL after a value and a value after a NULL, the cases a check before the read gets wrong
+    REQUIRE(result[0]["a"].is_null());
+    REQUIRE(result[0]["b"] == "x");
+    REQUIRE(result[0]["c"].is_null());
+    REQUIRE(result[1]["a"] == 0);
+    REQUIRE(result[1]["b"].is_null());
+    REQUIRE(result[1]["c"] == 1.5);
+}
+
+TEST_CASE("Benchmark resultset_to_json on wide results", "[.][benchmark][decoder]") {
+    const size_t width = 40;
+    const size_t rows = 1000;
+    simple_mariadb::config::MariaDBConfig config = get_env_config();
+    MariaDBManager dbManager(config);
+    REQUIRE(dbManager.is_connected());
+
+    CreateAndDestroy createAndDestroy;
+    REQUIRE(createAndDestroy.table_created_successfully);
+    fill_wide_table(dbManager, createAndDestroy.table, width, rows);
+    const std::string query = "SELECT * FROM " + createAndDestroy.table + ";";
+
+    // Result sets are fetched up front so only the decoding is measured, divide by the rows for the per-row cost
+    BENCHMARK_ADVANCED("legacy decoder, 1000 rows x 41 columns")(Catch::Benchmark::Chronometer meter) {
+        std::vector<std::unique_ptr<sql::ResultSet>> results(meter.runs());
+        for (auto &res: results) {
+            res = dbManager.query(query);
+        }
+        meter.measure([&results](int i) { return legacy_resultset_to_json(*results[i]); });
+    };
+
+    BENCHMARK_ADVANCED("column plan, 1000 rows x 41 columns")(Catch::Benchmark::Chronometer meter) {
+        std::vector<std::unique_ptr<sql::ResultSet>> results(meter.runs());
+        for (auto &res: results) {
+            res = dbManager.query(query);
+        }
+        meter.measure([&results](int i) { return MariaDBManager::resultset_to_json(*results[i]); });
+    };
+}
+
+TEST_CASE("Testing query cache", "[cache]") {
+    simple_mariadb::config::MariaDBConfig config = get_env_config();
+    config.query_cache_size = 16;
+    config.query_cache_ttl_ms = 60000;
+    MariaDBManager dbManager(config);
+    REQUIRE(dbManager.is_connected());
+
+    CreateAndDestroy createAndDestroy;
+    REQUIRE(createAndDestroy.table_created_successfully);
+    std::map<std::string, std::string> columns;
+    columns["name"] = "VARCHAR(255) NULL";
+    REQUIRE(dbManager.add_columns_to_table(createAndDestroy.table, columns));
+
+    auto id = common::key_generator();
+    const std::string query = "SELECT name FROM " + createAndDestroy.table + " WHERE name = '" + id + "';";
+    REQUIRE(dbManager.execute_prepared("INSERT INTO " + createAndDestroy.table + " (name) VALUES (?)", id));
+    REQUIRE(dbManager.select(query).size() == 1);
+    REQUIRE(dbManager.select(query).size() == 1);
+    REQUIRE(dbManager.query_to_json(query).size() == 1);
+    auto stats = dbManager.get_stats();
+    REQUIRE(stats.cache.hits == 1);
+    REQUIRE(stats.cache.misses == 2);
+    REQUIRE(stats.cache.size == 2);
+
+    // A write to the table drops its cached results
+    REQUIRE(dbManager.execute_prepared("INSERT INTO " + createAndDestroy.table + " (name) VALUES (?)", id));
+    REQUIRE(dbManager.select(query).size() == 2);
+    REQUIRE(dbManager.get_stats().cache.invalidations == 2);
+
+    // ping(), queries without a table and the system schemas always go to the server
+    REQUIRE(dbManager.ping());
+    REQUIRE(dbManager.query_to_json("SELECT 1;").size() == 1);
+    REQUIRE(dbManager.query_to_json("SELECT table_name FROM information_schema.tables WHERE table_name = '" +
+                                    createAndDestroy.table + "';").size() == 1);
+    REQUIRE(dbManager.get_stats().cache.size == 1);
+
+    REQUIRE(dbManager.enqueue("INSERT INTO " + createAndDestroy.table + " (name) VALUES ('" + id + "');"));
+    dbManager.stop();
+    REQUIRE(dbManager.select(query).size() == 3);
+}
+
+TEST_CASE("Testing operation stats", "[stats]") {
+    size_t size = 500;
+    simple_mariadb::config::MariaDBConfig config = get_env_config();
+    MariaDBManager dbManager(config);
+    REQUIRE(dbManager.is_connected());
+
+    CreateAndDestroy createAndDestroy;
+    REQUIRE(createAndDestroy.table_created_successfully);
+    std::map<std::string, std::string> columns;
+    columns["name"] = "VARCHAR(255) NULL";
+    REQUIRE(dbManager.add_columns_to_table(createAndDestroy.table, columns));
+
+    auto id = common::key_generator();
+    for (size_t j = 0; j < size; ++j) {
+        REQUIRE(dbManager.enqueue("INSERT INTO " + createAndDestroy.table + " (name) VALUES ('" + id + "');"));
+    }
+    dbManager.stop();
+    REQUIRE(dbManager.query_to_json("SELECT * FROM " + createAndDestroy.table).size() == size);
+
+    auto operations = dbManager.get_operation_stats();
+    REQUIRE(operations.rows.total == size);
+    REQUIRE(operations.insert_multi.count > 0);
+    REQUIRE(operations.batch_rows.max <= config.batch_max_rows);
+    REQUIRE(operations.query.count == 1);
+    REQUIRE(operations.query.p50 > 0);
+    REQUIRE(operations.query.p999 <= operations.query.max);
+    REQUIRE(operations.acquire.count >= 1);
+    REQUIRE(operations.connect.count >= 2);
+    REQUIRE(dbManager.get_stats().operations.to_json()["rows"]["total"] == size);
+}
+
+TEST_CASE("Testing enqueue overloads", "[queue]") {
+    simple_mariadb::config::MariaDBConfig config = get_env_config();
+    MariaDBManager dbManager(config);
+    REQUIRE(dbManager.is_connected());
+
+    CreateAndDestroy createAndDestroy;
+    REQUIRE(createAndDestroy.table_created_successfully);
+    std::map<std::string, std::string> columns;
+    columns["name"] = "VARCHAR(255) NULL";
+    REQUIRE(dbManager.add_columns_to_table(createAndDestroy.table, columns));
+
+    auto id = common::key_generator();
+    const std::string query = "INSERT INTO " + createAndDestroy.table + " (name) VALUES ('" + id + "');";
+    REQUIRE(dbManager.enqueue(query));
+    REQUIRE(dbManager.enqueue(std::string(query)));
+    REQUIRE(dbManager.enqueue(std::string_view(query)));
+    REQUIRE(dbManager.enqueue(query.c_str()));
+    REQUIRE_FALSE(dbManager.enqueue(std::string_view("DELETE FROM " + createAndDestroy.table)));
+    REQUIRE_FALSE(dbManager.enqueue("SELECT 1"));
+    REQUIRE(dbManager.enqueue(""));
+    dbManager.stop();
+    REQUIRE(dbManager.query_to_json("SELECT * FROM " + createAndDestroy.table).size() == 4);
+}
+
+TEST_CASE("Testing producer handles", "[queue]") {
+    const size_t producers = 4;
+    const size_t size = 1000;
+    simple_mariadb::config::MariaDBConfig config = get_env_config();
+    MariaDBManager dbManager(config);
+    REQUIRE(dbManager.is_connected());
+
+    CreateAndDestroy createAndDestroy;
+    REQUIRE(createAndDestroy.table_created_successfully);
+    std::map<std::string, std::string> columns;
+    columns["name"] = "VARCHAR(255) NOT NULL";
+    columns["number"] = "INT NOT NULL";
+    REQUIRE(dbManager.add_columns_to_table(createAndDestroy.table, columns));
+
+    auto id = common::key_generator();
+    std::atomic<size_t> failed = 0;
+    std::vector<std::thread> threads;
+    for (size_t p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p] {
+            auto producer = dbManager.make_producer(64, std::chrono::milliseconds(50));
+            for (size_t j = 0; j < size; ++j) {
+                if (!producer.enqueue("INSERT INTO " + createAndDestroy.table + " (name, number) VALUES ('" + id +
+                                      "', " + std::to_string(p * size + j) + ");")) {
+                    failed++;
+                }
+            }
+            REQUIRE_FALSE(producer.enqueue("DELETE FROM " + createAndDestroy.table));
+            REQUIRE(producer.flush());
+            REQUIRE(producer.staged() == 0);
+
+            // The linger time is not enforced while the handle is idle, only flush() hands the statement over
+            REQUIRE(producer.enqueue("INSERT INTO " + createAndDestroy.table + " (name, number) VALUES ('" + id +
+                                     "', -1);"));
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            REQUIRE(producer.staged() == 1);
+            auto moved = std::move(producer);
+            REQUIRE_FALSE(producer.enqueue("INSERT INTO " + createAndDestroy.table + " (name) VALUES ('x');"));
+            REQUIRE(moved.flush());
+            REQUIRE(moved.staged() == 0);
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    REQUIRE(failed == 0);
+    dbManager.stop();
+    const auto rows = dbManager.query_to_json("SELECT * FROM " + createAndDestroy.table);
+    REQUIRE(rows.size() == producers * (size + 1));
+}
+
+TEST_CASE("Testing retries and dead letters", "[retry]") {
+    const size_t size = 100;
+    simple_mariadb::config::MariaDBConfig config = get_env_config();
+    MariaDBManager dbManager(config);
+    REQUIRE(dbManager.is_connected());
+
+    CreateAndDestroy createAndDestroy;
+    REQUIRE(createAndDestroy.table_created_successfully);
+    std::map<std::string, std::string> columns;
+    columns["name"] = "VARCHAR(255) NULL";
+    REQUIRE(dbManager.add_columns_to_table(createAndDestroy.table, columns));
+
+    std::mutex mutex;
+    std::vector<simple_mariadb::retry::DeadLetter> letters;
+    dbManager.set_dead_letter_callback([&](const simple_mariadb::retry::DeadLetter &letter) {
+        std::lock_guard<std::mutex> lock(mutex);
+        letters.push_back(letter);
+    });
+
+    auto id = common::key_generator();
+    const std::string missing = "INSERT INTO " + createAndDestroy.table + " (missing_column) VALUES ('" + id + "');";
+    for (size_t j = 0; j < size; ++j) {
+        REQUIRE(dbManager.enqueue("INSERT INTO " + createAndDestroy.table + " (name) VALUES ('" + id + "');"));
+    }
+    REQUIRE(dbManager.enqueue(missing));
+    dbManager.stop();
+
+    REQUIRE(dbManager.query_to_json("SELECT * FROM " + createAndDestroy.table).size() == size);
+    auto stats = dbManager.get_stats();
+    REQUIRE(stats.retry.permanent == 1);
+    REQUIRE(stats.retry.scheduled == 0);
+    REQUIRE(stats.retry.dead_lettered == 1);
+    REQUIRE(stats.retry.pending == 0);
+    std::lock_guard<std::mutex> lock(mutex);
+    REQUIRE(letters.size() == 1);
+    REQUIRE(letters.front().statement == missing);
+    REQUIRE(letters.front().reason == "permanent");
+    REQUIRE(letters.front().failure.error_code == 1054);
+}
@@ -0,0 +1,116 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+#include <simple_mariadb/columnar.h>
+#include <catch2/catch_test_macros.hpp>
+#include <numeric>
+#include <string>
+#include <vector>
+
+// ---------------------------------------------------------------------------------------------------
+using simple_mariadb::columnar::Column;
+using simple_mariadb::columnar::ColumnType;
+using simple_mariadb::columnar::ColumnarResult;
+using simple_mariadb::columnar::column_type_for;
+using simple_mariadb::decoder::Decoder;
+
+TEST_CASE("Column types follow the decoders", "[columnar]") {
+    REQUIRE(column_type_for(Decoder::INT) == ColumnType::INT64);
+    REQUIRE(column_type_for(Decoder::INT64) == ColumnType::INT64);
+    REQUIRE(column_type_for(Decoder::DOUBLE) == ColumnType::DOUBLE);
+    REQUIRE(column_type_for(Decoder::FLOAT) == ColumnType::DOUBLE);
+    REQUIRE(column_type_for(Decoder::BOOLEAN) == ColumnType::BOOLEAN);
+    REQUIRE(column_type_for(Decoder::STRING) == ColumnType::STRING);
+}
+
+TEST_CASE("Unreadable cells decode to null", "[columnar]") {
+    struct BrokenRow {
+        int32_t getInt(int32_t) { throw sql::SQLException("cannot read"); }
+
+        int64_t getInt64(int32_t) { throw sql::SQLException("cannot read"); }
+
+        bool getBoolean(int32_t) { throw sql::SQLException("cannot read"); }
+
+        double getDouble(int32_t) { throw sql::SQLException("cannot read"); }
+
+        float getFloat(int32_t) { throw sql::SQLException("cannot read"); }
+
+        sql::SQLString getString(int32_t) { throw sql::SQLException("cannot read"); }
+
+        bool wasNull() { return false; }
+    } row;
+    const simple_mariadb::decoder::ColumnPlan plan({{1, "number", sql::INTEGER, Decoder::INT}});
+    std::string error;
+    REQUIRE(plan.decode(row, plan.columns().front(), &error).is_null());
+    REQUIRE(error == "column number type " + std::to_string(sql::INTEGER) + ": cannot read");
+    REQUIRE(plan.decode(row, plan.columns().front()).is_null());
+}
+
+TEST_CASE("Append to columns", "[columnar]") {
+    SECTION("int64 with nulls") {
+        Column column("number", ColumnType::INT64, sql::BIGINT);
+        column.reserve(20);
+        for (int64_t i = 0; i < 20; ++i) {
+            if (i % 3 == 0) {
+                column.append_null();
+            } else {
+                column.append_int64(i);
+            }
+        }
+        REQUIRE(column.size() == 20);
+        REQUIRE(column.null_count() == 7);
+        REQUIRE(column.int64s().size() == 20);
+        REQUIRE(column.validity().size() == 3);
+        for (size_t i = 0; i < 20; ++i) {
+            REQUIRE(column.is_null(i) == (i % 3 == 0));
+        }
+        // NULL slots hold zero, so a plain sum over the buffer skips them
+        REQUIRE(std::accumulate(column.int64s().begin(), column.int64s().end(), int64_t(0)) == 190 - 63);
+    }
+
+    SECTION("double and bool") {
+        Column prices("price", ColumnType::DOUBLE);
+        Column flags("flag", ColumnType::BOOLEAN);
+        prices.append_double(1.5);
+        prices.append_null();
+        flags.append_bool(true);
+        flags.append_bool(false);
+        REQUIRE(prices.doubles() == std::vector<double>{1.5, 0.0});
+        REQUIRE(prices.is_null(1));
+        REQUIRE(flags.bools() == std::vector<uint8_t>{1, 0});
+        REQUIRE(flags.null_count() == 0);
+        REQUIRE(flags.validity() == std::vector<uint8_t>{0b11});
+    }
+
+    SECTION("strings share one buffer") {
+        Column column("name", ColumnType::STRING);
+        column.append_string("alpha");
+        column.append_null();
+        column.append_string("");
+        column.append_string("gamma");
+        REQUIRE(column.size() == 4);
+        REQUIRE(column.string(0) == "alpha");
+        REQUIRE(column.string(1).empty());
+        REQUIRE(column.is_null(1));
+        REQUIRE(column.string(2).empty());
+        REQUIRE_FALSE(column.is_null(2));
+        REQUIRE(column.string(3) == "gamma");
+        REQUIRE(column.data() == "alphagamma");
+        REQUIRE(column.offsets() == std::vector<uint64_t>{0, 5, 5, 5, 10});
+    }
+}
+
+TEST_CASE("Look up columns of a result", "[columnar]") {
+    std::vector<Column> columns;
+    columns.emplace_back("id", ColumnType::INT64);
+    columns.emplace_back("name", ColumnType::STRING);
+    columns[0].append_int64(1);
+    columns[1].append_string("one");
+    ColumnarResult result(std::move(columns));
+    REQUIRE(result.rows() == 1);
+    REQUIRE(result.column("name").string(0) == "one");
+    REQUIRE(result.column(0).int64s().front() == 1);
+    REQUIRE_THROWS_AS(result.column("missing"), std::out_of_range);
+    REQUIRE(ColumnarResult().rows() == 0);
+}
@@ -58,11 +58,113 @@ TEST_CASE("Use to_string", "[MariaDBConfig]") {
     simple_mariadb::config::MariaDBConfig config;
     REQUIRE(config.uri == "jdbc:mariadb://localhost:3306/database");
     REQUIRE(config.validate());
-    std::string expected_str = R"({"MariaDBConfig":{"autoreconnect":"true","checker_time":30,"connecttimeout":"30","dbname":"database","hostname":"localhost","multi_insert":false,"password":"password","port":3306,"sockettimeout":"10000","tcpkeepalive":"true","user":"user"}})";
+    std::string expected_str = R"({"MariaDBConfig":{"async_threads":0,"autoreconnect":"true","batch_linger_ms":0,"batch_max_bytes":0,"batch_max_rows":1000,"checker_time":30,"connecttimeout":"30","dbname":"database","dead_letter_path":"","engine":"threads","engine_connections":16,"fetch_size":1000,"hostname":"localhost","load_chunk_size":1048576,"log_queries_per_second":10,"log_query_max_length":1024,"multi_insert":false,"multi_row_insert":false,"password":"password","port":3306,"query_cache_size":0,"query_cache_ttl_ms":5000,"queue_backend":"mutex","queue_overflow_policy":"block","queue_size":30000,"queue_timeout":2,"read_pool_max":0,"read_pool_size":1,"read_pool_timeout_ms":5000,"retry_backoff_ms":100,"retry_max_attempts":5,"retry_max_backoff_ms":30000,"sockettimeout":"10000","spill_dir":"","spill_max_bytes":1073741824,"spill_replay_rate":5000,"spill_segment_size":67108864,"statement_cache_size":64,"tcpkeepalive":"true","usebulkstmts":"true","user":"user","writer_threads":1}})";
     REQUIRE(config.to_string() == expected_str);
 
 }
 
+TEST_CASE("Writer threads", "[MariaDBConfig]") {
+    setenv("MARIADB_HOSTNAME", "localhost", 1);
+    setenv("MARIADB_PORT", "3306", 1);
+    setenv("MARIADB_DATABASE", "database", 1);
+    setenv("MARIADB_USER", "user", 1);
+    setenv("MARIADB_PASSWORD", "password", 1);
+    setenv("MARIADB_WRITER_THREADS", "4", 1);
+    simple_mariadb::config::MariaDBConfig config;
+    unsetenv("MARIADB_WRITER_THREADS");
+    REQUIRE(config.writer_threads == 4);
+    REQUIRE(config.validate());
+    config.writer_threads = 0;
+    REQUIRE_FALSE(config.validate());
+}
+
+TEST_CASE("Queue backend", "[MariaDBConfig]") {
+    setenv("MARIADB_HOSTNAME", "localhost", 1);
+    setenv("MARIADB_PORT", "3306", 1);
+    setenv("MARIADB_DATABASE", "database", 1);
+    setenv("MARIADB_USER", "user", 1);
+    setenv("MARIADB_PASSWORD", "password", 1);
+    setenv("MARIADB_QUEUE_BACKEND", "ring", 1);
+    setenv("MARIADB_QUEUE_OVERFLOW_POLICY", "drop_oldest", 1);
+    simple_mariadb::config::MariaDBConfig config;
+    unsetenv("MARIADB_QUEUE_BACKEND");
+    unsetenv("MARIADB_QUEUE_OVERFLOW_POLICY");
+    REQUIRE(config.queue_backend == "ring");
+    REQUIRE(config.queue_overflow_policy == "drop_oldest");
+    REQUIRE(config.validate());
+    config.queue_overflow_policy = "wait";
+    REQUIRE_FALSE(config.validate());
+    config.queue_overflow_policy = "reject";
+    config.queue_backend = "spsc";
+    REQUIRE_FALSE(config.validate());
+}
+
+TEST_CASE("Execution engine", "[MariaDBConfig]") {
+    setenv("MARIADB_HOSTNAME", "localhost", 1);
+    setenv("MARIADB_PORT", "3306", 1);
+    setenv("MARIADB_DATABASE", "database", 1);
+    setenv("MARIADB_USER", "user", 1);
+    setenv("MARIADB_PASSWORD", "password", 1);
+    setenv("MARIADB_ENGINE", "nonblocking", 1);
+    setenv("MARIADB_ENGINE_CONNECTIONS", "64", 1);
+    simple_mariadb::config::MariaDBConfig config;
+    unsetenv("MARIADB_ENGINE");
+    unsetenv("MARIADB_ENGINE_CONNECTIONS");
+    REQUIRE(config.engine == "nonblocking");
+    REQUIRE(config.engine_connections == 64);
+    REQUIRE(config.validate());
+    config.engine_connections = 0;
+    REQUIRE_FALSE(config.validate());
+    config.engine_connections = 8;
+    config.engine = "epoll";
+    REQUIRE_FALSE(config.validate());
+}
+
+TEST_CASE("Query cache", "[MariaDBConfig]") {
+    setenv("MARIADB_HOSTNAME", "localhost", 1);
+    setenv("MARIADB_PORT", "3306", 1);
+    setenv("MARIADB_DATABASE", "database", 1);
+    setenv("MARIADB_USER", "user", 1);
+    setenv("MARIADB_PASSWORD", "password", 1);
+    setenv("MARIADB_QUERY_CACHE_SIZE", "512", 1);
+    setenv("MARIADB_QUERY_CACHE_TTL_MS", "250", 1);
+    simple_mariadb::config::MariaDBConfig config;
+    unsetenv("MARIADB_QUERY_CACHE_SIZE");
+    unsetenv("MARIADB_QUERY_CACHE_TTL_MS");
+    REQUIRE(config.query_cache_size == 512);
+    REQUIRE(config.query_cache_ttl_ms == 250);
+    REQUIRE(config.validate());
+    config.query_cache_ttl_ms = 0;
+    REQUIRE_FALSE(config.validate());
+    config.query_cache_size = 0;
+    REQUIRE(config.validate());
+}
+
+TEST_CASE("Retries", "[MariaDBConfig]") {
+    setenv("MARIADB_HOSTNAME", "localhost", 1);
+    setenv("MARIADB_PORT", "3306", 1);
+    setenv("MARIADB_DATABASE", "database", 1);
+    setenv("MARIADB_USER", "user", 1);
+    setenv("MARIADB_PASSWORD", "password", 1);
+    setenv("MARIADB_RETRY_MAX_ATTEMPTS", "3", 1);
+    setenv("MARIADB_RETRY_BACKOFF_MS", "50", 1);
+    setenv("MARIADB_DEAD_LETTER_PATH", "/tmp/dead_letters.jsonl", 1);
+    simple_mariadb::config::MariaDBConfig config;
+    unsetenv("MARIADB_RETRY_MAX_ATTEMPTS");
+    unsetenv("MARIADB_RETRY_BACKOFF_MS");
+    unsetenv("MARIADB_DEAD_LETTER_PATH");
+    REQUIRE(config.retry_max_attempts == 3);
+    REQUIRE(config.retry_backoff_ms == 50);
+    REQUIRE(config.retry_max_backoff_ms == 30000);
+    REQUIRE(config.dead_letter_path == "/tmp/dead_letters.jsonl");
+    REQUIRE(config.validate());
+    config.retry_max_backoff_ms = 10;
+    REQUIRE_FALSE(config.validate());
+    config.retry_max_backoff_ms = 1000;
+    config.retry_max_attempts = 0;
+    REQUIRE_FALSE(config.validate());
+}
+
 TEST_CASE("Use to_json", "[MariaDBConfig]") {
     setenv("MARIADB_HOSTNAME", "localhost", 1);
     setenv("MARIADB_PORT", "3306", 1);
@@ -0,0 +1,124 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+#include <simple_mariadb/executor.h>
+#include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ---------------------------------------------------------------------------------------------------
+using simple_mariadb::executor::Executor;
+using simple_mariadb::executor::Awaitable;
+
+namespace {
+    // Smallest coroutine type able to co_await: starts eagerly and reports through a promise
+    struct Detached {
+        struct promise_type {
+            Detached get_return_object() { return {}; }
+
+            std::suspend_never initial_suspend() noexcept { return {}; }
+
+            std::suspend_never final_suspend() noexcept { return {}; }
+
+            void return_void() {}
+
+            void unhandled_exception() { std::terminate(); }
+        };
+    };
+
+    Detached await_length(Executor &executor, std::string text, std::promise<std::pair<size_t, std::thread::id>> &done) {
+        Awaitable<size_t> awaitable(executor, [text]() { return text.size(); });
+        size_t length = co_await awaitable;
+        done.set_value({length, std::this_thread::get_id()});
+    }
+
+    Detached await_failure(Executor &executor, std::promise<std::string> &done) {
+        try {
+            Awaitable<int> awaitable(executor, []() -> int { throw std::runtime_error("broken"); });
+            co_await awaitable;
+            done.set_value("no exception");
+        } catch (std::runtime_error &e) {
+            done.set_value(e.what());
+        }
+    }
+}
+
+TEST_CASE("Run tasks on the executor", "[executor]") {
+    Executor executor(4);
+    REQUIRE(executor.threads() == 4);
+
+    SECTION("Futures") {
+        std::vector<std::future<int>> futures;
+        for (int i = 0; i < 100; ++i) {
+            futures.push_back(executor.submit([i]() { return i * i; }));
+        }
+        for (int i = 0; i < 100; ++i) {
+            REQUIRE(futures[i].get() == i * i);
+        }
+        auto failed = executor.submit([]() -> int { throw std::runtime_error("broken"); });
+        REQUIRE_THROWS_AS(failed.get(), std::runtime_error);
+        executor.stop();
+        auto stats = executor.get_stats();
+        REQUIRE(stats.submitted == 101);
+        REQUIRE(stats.completed == 101);
+        REQUIRE(stats.queued == 0);
+        REQUIRE(stats.running == 0);
+    }
+
+    SECTION("Tasks run concurrently") {
+        std::atomic<int> inside = 0;
+        std::promise<void> release;
+        auto gate = release.get_future().share();
+        std::vector<std::future<void>> futures;
+        for (int i = 0; i < 4; ++i) {
+            futures.push_back(executor.submit([&inside, gate]() {
+                inside++;
+                gate.wait();
+            }));
+        }
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (inside < 4 && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        REQUIRE(inside == 4);
+        release.set_value();
+        for (auto &future: futures) {
+            future.get();
+        }
+    }
+
+    SECTION("Stop runs the queued tasks and refuses new ones") {
+        std::atomic<int> done = 0;
+        for (int i = 0; i < 50; ++i) {
+            executor.post([&done]() {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+                done++;
+            });
+        }
+        executor.stop();
+        REQUIRE(done == 50);
+        REQUIRE_THROWS_AS(executor.post([]() {}), std::runtime_error);
+        REQUIRE_THROWS_AS(executor.submit([]() { return 1; }), std::runtime_error);
+    }
+
+    SECTION("Coroutines resume on the executor") {
+        std::promise<std::pair<size_t, std::thread::id>> done;
+        auto result = done.get_future();
+        await_length(executor, "simple_mariadb", done);
+        auto [length, thread] = result.get();
+        REQUIRE(length == 14);
+        REQUIRE(thread != std::this_thread::get_id());
+
+        std::promise<std::string> failed;
+        auto error = failed.get_future();
+        await_failure(executor, failed);
+        REQUIRE(error.get() == "broken");
+    }
+}
@@ -0,0 +1,78 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+#include <simple_mariadb/loader.h>
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+#include <vector>
+
+// ---------------------------------------------------------------------------------------------------
+using simple_mariadb::rows::Value;
+using simple_mariadb::loader::append_field;
+using simple_mariadb::loader::append_row;
+using simple_mariadb::loader::load_statement;
+using simple_mariadb::loader::LoadStats;
+using simple_mariadb::loader::InsertType;
+
+TEST_CASE("Format fields", "[loader]") {
+    std::string out;
+    append_field(out, Value(nullptr));
+    REQUIRE(out == "\\N");
+
+    out.clear();
+    append_field(out, Value(true));
+    append_field(out, Value(false));
+    REQUIRE(out == "10");
+
+    out.clear();
+    append_field(out, Value(int64_t(-42)));
+    REQUIRE(out == "-42");
+
+    out.clear();
+    append_field(out, Value(uint64_t(18446744073709551615ull)));
+    REQUIRE(out == "18446744073709551615");
+
+    out.clear();
+    append_field(out, Value(1.5));
+    REQUIRE(out == "1.5");
+
+    out.clear();
+    append_field(out, Value(std::string("a\tb\nc\\d\re")));
+    REQUIRE(out == "a\\tb\\nc\\\\d\\re");
+
+    out.clear();
+    append_field(out, Value(std::string("nul\0x", 5)));
+    REQUIRE(out == "nul\\0x");
+
+    out.clear();
+    append_field(out, Value(std::string("\\N")));
+    REQUIRE(out == "\\\\N");
+}
+
+TEST_CASE("Format rows", "[loader]") {
+    std::string out;
+    append_row(out, {Value(int64_t(1)), Value(std::string("one")), Value(nullptr)});
+    append_row(out, {Value(int64_t(2)), Value(std::string("")), Value(0.25)});
+    REQUIRE(out == "1\tone\t\\N\n2\t\t0.25\n");
+}
+
+TEST_CASE("Build load statement", "[loader]") {
+    REQUIRE(load_statement("t", {"a", "b"}) ==
+            "LOAD DATA LOCAL INFILE 'simple_mariadb_stream' INTO TABLE `t` CHARACTER SET utf8mb4 (`a`,`b`)");
+    REQUIRE(load_statement("t", {"a"}, InsertType::REPLACE) ==
+            "LOAD DATA LOCAL INFILE 'simple_mariadb_stream' REPLACE INTO TABLE `t` CHARACTER SET utf8mb4 (`a`)");
+    REQUIRE(load_statement("t", {"a"}, InsertType::IGNORE) ==
+            "LOAD DATA LOCAL INFILE 'simple_mariadb_stream' IGNORE INTO TABLE `t` CHARACTER SET utf8mb4 (`a`)");
+}
+
+TEST_CASE("Load throughput", "[loader]") {
+    LoadStats stats;
+    REQUIRE(stats.rows_per_second() == 0.0);
+    stats.rows = 1000;
+    stats.bytes = 50000;
+    stats.elapsed_us = 500000;
+    REQUIRE(stats.rows_per_second() == 2000.0);
+    REQUIRE(stats.bytes_per_second() == 100000.0);
+    REQUIRE(stats.to_json()["rows"] == 1000);
+}
@@ -0,0 +1,129 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+#include <simple_mariadb/logging.h>
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ---------------------------------------------------------------------------------------------------
+using simple_mariadb::logging::Log;
+using simple_mariadb::logging::LogLevel;
+using simple_mariadb::logging::QueryLog;
+using simple_mariadb::logging::RateLimiter;
+
+TEST_CASE("Parse log levels", "[logging]") {
+    LogLevel level = LogLevel::DEBUG;
+    REQUIRE(simple_mariadb::logging::parse_level("info", level));
+    REQUIRE(level == LogLevel::INFORMATIONAL);
+    REQUIRE(simple_mariadb::logging::parse_level("WARNING", level));
+    REQUIRE(level == LogLevel::WARNING);
+    REQUIRE_FALSE(simple_mariadb::logging::parse_level("verbose", level));
+    REQUIRE(level == LogLevel::WARNING);
+    STATIC_REQUIRE(simple_mariadb::logging::compiled_in(LogLevel::ERROR));
+}
+
+TEST_CASE("Messages are built only when written", "[logging]") {
+    auto logger = std::make_shared<simple_logger::Logger>("info");
+    size_t built = 0;
+    auto format = [&built]() {
+        built++;
+        return std::string("message");
+    };
+
+    Log info(logger, "info");
+    REQUIRE(info.enabled(LogLevel::ERROR));
+    REQUIRE_FALSE(info.enabled(LogLevel::DEBUG));
+    info.send<LogLevel::DEBUG>(format);
+    REQUIRE(built == 0);
+    info.send<LogLevel::ERROR>(format);
+    REQUIRE(built == 1);
+
+    Log debug(logger, "debug");
+    debug.send<LogLevel::DEBUG>(format);
+    REQUIRE(built == (simple_mariadb::logging::compiled_in(LogLevel::DEBUG) ? 2 : 1));
+}
+
+TEST_CASE("Abbreviate queries", "[logging]") {
+    using simple_mariadb::logging::abbreviate;
+    REQUIRE(abbreviate("INSERT INTO t (a) VALUES (1)", 0) == "INSERT INTO t (a) VALUES (1)");
+    REQUIRE(abbreviate("INSERT INTO t (a) VALUES (1)", 100) == "INSERT INTO t (a) VALUES (1)");
+    REQUIRE(abbreviate("INSERT INTO t (a) VALUES (1)", 11) == "INSERT INTO... (17 more bytes)");
+}
+
+TEST_CASE("Rate limiter", "[logging]") {
+    size_t suppressed = 0;
+
+    SECTION("Per second budget") {
+        RateLimiter limiter(3);
+        for (int i = 0; i < 3; ++i) {
+            REQUIRE(limiter.allow(suppressed));
+            REQUIRE(suppressed == 0);
+        }
+        for (int i = 0; i < 5; ++i) {
+            REQUIRE_FALSE(limiter.allow(suppressed));
+        }
+        REQUIRE(limiter.get_suppressed() == 5);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+        REQUIRE(limiter.allow(suppressed));
+        REQUIRE(suppressed == 5);
+        REQUIRE(limiter.allow(suppressed));
+        REQUIRE(suppressed == 0);
+    }
+
+    SECTION("No limit") {
+        RateLimiter limiter(0);
+        for (int i = 0; i < 1000; ++i) {
+            REQUIRE(limiter.allow(suppressed));
+        }
+        REQUIRE(limiter.get_suppressed() == 0);
+    }
+
+    SECTION("Many threads share the budget") {
+        RateLimiter limiter(100);
+        std::atomic<size_t> allowed = 0;
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&limiter, &allowed]() {
+                size_t held = 0;
+                for (int i = 0; i < 1000; ++i) {
+                    allowed += limiter.allow(held) ? 1 : 0;
+                }
+            });
+        }
+        for (auto &thread: threads) {
+            thread.join();
+        }
+        // The budget is per second, the threads may straddle a second boundary
+        REQUIRE(allowed >= 100);
+        REQUIRE(allowed <= 200);
+        REQUIRE(allowed + limiter.get_suppressed() == 4000);
+    }
+}
+
+TEST_CASE("Query log", "[logging]") {
+    auto logger = std::make_shared<simple_logger::Logger>("info");
+    Log log(logger, "info");
+    QueryLog query_log(log, 2, 8);
+    std::vector<std::string> shown;
+    for (int i = 0; i < 10; ++i) {
+        query_log.send<LogLevel::ERROR>("INSERT INTO t (a) VALUES (1)", [&shown](const std::string &query) {
+            shown.push_back(query);
+            return "DISCARD QUERY: " + query;
+        });
+    }
+    REQUIRE(shown.size() == 2);
+    REQUIRE(shown[0] == "INSERT I... (20 more bytes)");
+    REQUIRE(query_log.get_suppressed() == 8);
+
+    // Levels that are not enabled neither format nor use the budget
+    QueryLog quiet(log, 2, 8);
+    quiet.send<LogLevel::DEBUG>("INSERT INTO t (a) VALUES (1)", [&shown](const std::string &query) {
+        shown.push_back(query);
+        return query;
+    });
+    REQUIRE(shown.size() == 2);
+    REQUIRE(quiet.get_suppressed() == 0);
+}
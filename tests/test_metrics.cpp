@@ -0,0 +1,100 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+#include <simple_mariadb/metrics.h>
+#include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// ---------------------------------------------------------------------------------------------------
+using simple_mariadb::metrics::Histogram;
+using simple_mariadb::metrics::RateMeter;
+
+TEST_CASE("Histogram buckets", "[metrics]") {
+    for (uint64_t value: {uint64_t(0), uint64_t(63), uint64_t(64), uint64_t(127), uint64_t(128), uint64_t(1000),
+                          uint64_t(123456789), (uint64_t(1) << 44) - 1}) {
+        const size_t index = Histogram::bucket_index(value);
+        REQUIRE(index < Histogram::BUCKETS);
+        REQUIRE(Histogram::bucket_upper(index) >= value);
+        REQUIRE(Histogram::bucket_upper(index) - value <= value / Histogram::SUB_BUCKETS);
+        if (index > 0) {
+            REQUIRE(Histogram::bucket_upper(index - 1) < value);
+        }
+    }
+    REQUIRE(Histogram::bucket_index(UINT64_MAX) == Histogram::BUCKETS - 1);
+}
+
+TEST_CASE("Histogram percentiles", "[metrics]") {
+    Histogram histogram;
+    REQUIRE(histogram.snapshot().count == 0);
+    for (uint64_t value = 1; value <= 100000; ++value) {
+        histogram.record(value);
+    }
+    auto snapshot = histogram.snapshot();
+    REQUIRE(snapshot.count == 100000);
+    REQUIRE(snapshot.min == 1);
+    REQUIRE(snapshot.max == 100000);
+    REQUIRE(snapshot.mean == 50000.5);
+    REQUIRE(snapshot.p50 >= 50000);
+    REQUIRE(snapshot.p50 <= 50000 + 50000 / 64);
+    REQUIRE(snapshot.p99 >= 99000);
+    REQUIRE(snapshot.p99 <= 99000 + 99000 / 64);
+    REQUIRE(snapshot.p999 >= 99900);
+    REQUIRE(snapshot.p999 <= 100000);
+    REQUIRE(snapshot.to_json()["count"] == 100000);
+
+    histogram.reset();
+    REQUIRE(histogram.snapshot().count == 0);
+}
+
+TEST_CASE("Histogram records from many threads", "[metrics]") {
+    Histogram histogram;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&histogram, t]() {
+            for (uint64_t i = 0; i < 10000; ++i) {
+                histogram.record(i * (t + 1));
+            }
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    auto snapshot = histogram.snapshot();
+    REQUIRE(snapshot.count == 40000);
+    REQUIRE(snapshot.min == 0);
+    REQUIRE(snapshot.max == 9999 * 4);
+}
+
+TEST_CASE("Histogram snapshot while recording", "[metrics]") {
+    Histogram histogram;
+    std::atomic<bool> done = false;
+    std::thread writer([&histogram, &done]() {
+        for (uint64_t i = 0; i < 200000; ++i) {
+            histogram.record(i % 2 == 0 ? 1000000 - i : i);
+        }
+        done = true;
+    });
+    while (!done) {
+        auto snapshot = histogram.snapshot();
+        if (snapshot.count == 0) {
+            continue;
+        }
+        REQUIRE(snapshot.min <= snapshot.max);
+        REQUIRE(snapshot.p50 >= snapshot.min);
+        REQUIRE(snapshot.p999 <= snapshot.max);
+    }
+    writer.join();
+}
+
+TEST_CASE("Rate meter", "[metrics]") {
+    RateMeter meter;
+    meter.add(10);
+    meter.add(5);
+    auto snapshot = meter.snapshot();
+    REQUIRE(snapshot.total == 15);
+    REQUIRE(snapshot.per_second > 0);
+    REQUIRE(snapshot.to_json()["total"] == 15);
+}
@@ -0,0 +1,245 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+#include <simple_mariadb/queue.h>
+#include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ---------------------------------------------------------------------------------------------------
+using simple_mariadb::queue::RingQueue;
+using simple_mariadb::queue::OverflowPolicy;
+using simple_mariadb::queue::Backend;
+
+TEST_CASE("Parse queue options", "[queue]") {
+    Backend backend = Backend::MUTEX;
+    REQUIRE(simple_mariadb::queue::parse_backend("ring", backend));
+    REQUIRE(backend == Backend::RING);
+    REQUIRE_FALSE(simple_mariadb::queue::parse_backend("lock_free", backend));
+    REQUIRE(backend == Backend::RING);
+
+    OverflowPolicy policy = OverflowPolicy::BLOCK;
+    for (auto name: {"block", "drop_newest", "drop_oldest", "reject"}) {
+        REQUIRE(simple_mariadb::queue::parse_overflow_policy(name, policy));
+        REQUIRE(simple_mariadb::queue::to_string(policy) == name);
+    }
+    REQUIRE_FALSE(simple_mariadb::queue::parse_overflow_policy("wait", policy));
+}
+
+TEST_CASE("Ring queue order", "[queue]") {
+    RingQueue<std::string> queue(3, OverflowPolicy::REJECT, std::chrono::milliseconds(10));
+    std::string value;
+    REQUIRE_FALSE(queue.dequeue(value));
+    for (int round = 0; round < 3; ++round) { // wrap around the ring
+        REQUIRE(queue.enqueue("a"));
+        REQUIRE(queue.enqueue("b"));
+        REQUIRE(queue.size() == 2);
+        REQUIRE(queue.dequeue(value));
+        REQUIRE(value == "a");
+        REQUIRE(queue.dequeue_blocking(value));
+        REQUIRE(value == "b");
+        REQUIRE(queue.size() == 0);
+    }
+    REQUIRE_FALSE(queue.dequeue_blocking(value));
+    auto stats = queue.get_stats();
+    REQUIRE(stats.backend == "ring");
+    REQUIRE(stats.capacity == 3);
+    REQUIRE(stats.enqueued == 6);
+    REQUIRE(stats.dequeued == 6);
+}
+
+TEST_CASE("Ring queue timed dequeue", "[queue]") {
+    RingQueue<std::string> queue(4, OverflowPolicy::REJECT, std::chrono::milliseconds(5000));
+    std::string value;
+    // Bounded by its own timeout, not by the queue timeout
+    const auto start = std::chrono::steady_clock::now();
+    REQUIRE_FALSE(queue.dequeue_for(value, std::chrono::milliseconds(20)));
+    REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(1000));
+    REQUIRE_FALSE(queue.dequeue_for(value, std::chrono::milliseconds(0)));
+
+    REQUIRE(queue.enqueue("a"));
+    REQUIRE(queue.dequeue_for(value, std::chrono::milliseconds(0)));
+    REQUIRE(value == "a");
+    std::thread producer([&queue]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        REQUIRE(queue.enqueue("b"));
+    });
+    REQUIRE(queue.dequeue_for(value, std::chrono::milliseconds(2000)));
+    REQUIRE(value == "b");
+    producer.join();
+}
+
+TEST_CASE("Ring queue overflow policies", "[queue]") {
+    std::string value;
+
+    SECTION("Reject") {
+        RingQueue<std::string> queue(2, OverflowPolicy::REJECT, std::chrono::milliseconds(10));
+        REQUIRE(queue.enqueue("1"));
+        REQUIRE(queue.enqueue("2"));
+        REQUIRE_FALSE(queue.enqueue("3"));
+        REQUIRE(queue.get_stats().rejected == 1);
+        REQUIRE(queue.size() == 2);
+    }
+
+    SECTION("Drop newest") {
+        RingQueue<std::string> queue(2, OverflowPolicy::DROP_NEWEST, std::chrono::milliseconds(10));
+        REQUIRE(queue.enqueue("1"));
+        REQUIRE(queue.enqueue("2"));
+        REQUIRE(queue.enqueue("3"));
+        REQUIRE(queue.get_stats().dropped_newest == 1);
+        REQUIRE(queue.dequeue(value));
+        REQUIRE(value == "1");
+        REQUIRE(queue.dequeue(value));
+        REQUIRE(value == "2");
+    }
+
+    SECTION("Drop oldest") {
+        RingQueue<std::string> queue(2, OverflowPolicy::DROP_OLDEST, std::chrono::milliseconds(10));
+        REQUIRE(queue.enqueue("1"));
+        REQUIRE(queue.enqueue("2"));
+        REQUIRE(queue.enqueue("3"));
+        auto stats = queue.get_stats();
+        REQUIRE(stats.dropped_oldest == 1);
+        REQUIRE(stats.dequeued == 0);
+        REQUIRE(queue.dequeue(value));
+        REQUIRE(value == "2");
+        REQUIRE(queue.dequeue(value));
+        REQUIRE(value == "3");
+    }
+
+    SECTION("Block with deadline") {
+        RingQueue<std::string> queue(1, OverflowPolicy::BLOCK, std::chrono::milliseconds(20));
+        REQUIRE(queue.capacity() == 2);
+        REQUIRE(queue.enqueue("0"));
+        REQUIRE(queue.enqueue("1"));
+        auto start = std::chrono::steady_clock::now();
+        REQUIRE_FALSE(queue.enqueue("2"));
+        REQUIRE(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(20));
+        auto stats = queue.get_stats();
+        REQUIRE(stats.blocked == 1);
+        REQUIRE(stats.block_timeouts == 1);
+
+        std::thread consumer([&queue] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            std::string taken;
+            queue.dequeue(taken);
+        });
+        REQUIRE(queue.enqueue("3"));
+        consumer.join();
+        REQUIRE(queue.get_stats().blocked == 2);
+        REQUIRE(queue.get_stats().block_timeouts == 1);
+    }
+}
+
+TEST_CASE("Ring queue with many producers", "[queue]") {
+    const size_t producers = 8;
+    const size_t per_producer = 20000;
+    RingQueue<std::string> queue(1024, OverflowPolicy::BLOCK, std::chrono::seconds(5));
+
+    std::atomic<size_t> failed = 0;
+    std::vector<std::thread> threads;
+    for (size_t p = 0; p < producers; ++p) {
+        threads.emplace_back([&queue, &failed, p] {
+            for (size_t i = 0; i < per_producer; ++i) {
+                if (!queue.enqueue(std::to_string(p) + ":" + std::to_string(i))) {
+                    failed++;
+                }
+            }
+        });
+    }
+
+    std::vector<size_t> next(producers, 0);
+    std::string value;
+    for (size_t received = 0; received < producers * per_producer; ++received) {
+        REQUIRE(queue.dequeue_blocking(value));
+        auto colon = value.find(':');
+        size_t p = std::stoul(value.substr(0, colon));
+        size_t i = std::stoul(value.substr(colon + 1));
+        REQUIRE(i == next[p]); // per producer FIFO
+        next[p]++;
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    REQUIRE(failed == 0);
+    REQUIRE(queue.size() == 0);
+    REQUIRE(queue.get_stats().dequeued == producers * per_producer);
+}
+
+TEST_CASE("Ring queue bulk push", "[queue]") {
+    std::string value;
+
+    SECTION("Runs claimed at once") {
+        RingQueue<std::string> queue(4, OverflowPolicy::REJECT, std::chrono::milliseconds(10));
+        std::vector<std::string> values = {"a", "b", "c"};
+        REQUIRE(queue.try_push_bulk(values.data(), values.size()));
+        REQUIRE(queue.size() == 3);
+        std::vector<std::string> more = {"d", "e"};
+        REQUIRE_FALSE(queue.try_push_bulk(more.data(), more.size())); // one cell left
+        REQUIRE(more[0] == "d");
+        REQUIRE(queue.dequeue(value));
+        REQUIRE(value == "a");
+        REQUIRE(queue.try_push_bulk(more.data(), more.size())); // wraps around the ring
+        for (auto expected: {"b", "c", "d", "e"}) {
+            REQUIRE(queue.dequeue(value));
+            REQUIRE(value == expected);
+        }
+        REQUIRE(queue.get_stats().enqueued == 5);
+    }
+
+    SECTION("Overflow policy on the rest") {
+        RingQueue<std::string> queue(2, OverflowPolicy::REJECT, std::chrono::milliseconds(10));
+        std::vector<std::string> values = {"1", "2", "3", "4"};
+        REQUIRE(queue.enqueue_bulk(values.data(), values.size()) == 2);
+        REQUIRE(queue.get_stats().rejected == 1);
+
+        RingQueue<std::string> oldest(2, OverflowPolicy::DROP_OLDEST, std::chrono::milliseconds(10));
+        values = {"1", "2", "3", "4", "5"};
+        REQUIRE(oldest.enqueue_bulk(values.data(), values.size()) == 5);
+        REQUIRE(oldest.dequeue(value));
+        REQUIRE(value == "4");
+        REQUIRE(oldest.dequeue(value));
+        REQUIRE(value == "5");
+    }
+}
+
+TEST_CASE("Ring queue with many bulk producers", "[queue]") {
+    const size_t producers = 8;
+    const size_t batches = 500;
+    const size_t batch = 40;
+    RingQueue<std::string> queue(1024, OverflowPolicy::BLOCK, std::chrono::seconds(5));
+
+    std::atomic<size_t> queued = 0;
+    std::vector<std::thread> threads;
+    for (size_t p = 0; p < producers; ++p) {
+        threads.emplace_back([&queue, &queued, p] {
+            std::vector<std::string> values;
+            for (size_t b = 0; b < batches; ++b) {
+                values.clear();
+                for (size_t i = 0; i < batch; ++i) {
+                    values.push_back(std::to_string(p) + ":" + std::to_string(b * batch + i));
+                }
+                queued += queue.enqueue_bulk(values.data(), values.size());
+            }
+        });
+    }
+
+    std::vector<size_t> next(producers, 0);
+    std::string value;
+    for (size_t received = 0; received < producers * batches * batch; ++received) {
+        REQUIRE(queue.dequeue_blocking(value));
+        auto colon = value.find(':');
+        size_t p = std::stoul(value.substr(0, colon));
+        size_t i = std::stoul(value.substr(colon + 1));
+        REQUIRE(i == next[p]); // per producer FIFO
+        next[p]++;
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    REQUIRE(queued == producers * batches * batch);
+    REQUIRE(queue.size() == 0);
+}
@@ -0,0 +1,276 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+#include <simple_mariadb/retry.h>
+#include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ---------------------------------------------------------------------------------------------------
+using simple_mariadb::retry::DeadLetter;
+using simple_mariadb::retry::ErrorClass;
+using simple_mariadb::retry::Failure;
+using simple_mariadb::retry::Pending;
+using simple_mariadb::retry::Policy;
+using simple_mariadb::retry::Retrier;
+using simple_mariadb::retry::TimerWheel;
+using namespace std::chrono_literals;
+
+TEST_CASE("Classify errors", "[retry]") {
+    using simple_mariadb::retry::classify;
+    REQUIRE(classify(2006) == ErrorClass::TRANSIENT); // server gone away
+    REQUIRE(classify(2013) == ErrorClass::TRANSIENT); // lost connection
+    REQUIRE(classify(1213) == ErrorClass::TRANSIENT); // deadlock
+    REQUIRE(classify(1205) == ErrorClass::TRANSIENT); // lock wait timeout
+    REQUIRE(classify(0) == ErrorClass::TRANSIENT);
+    REQUIRE(classify(1064) == ErrorClass::PERMANENT); // syntax
+    REQUIRE(classify(1054) == ErrorClass::PERMANENT); // unknown column
+    REQUIRE(classify(1062) == ErrorClass::PERMANENT); // duplicate key
+    REQUIRE(classify(1153) == ErrorClass::PERMANENT); // packet too large
+    REQUIRE(classify(9999, "08S01") == ErrorClass::TRANSIENT);
+    REQUIRE(classify(9999, "40001") == ErrorClass::TRANSIENT);
+    REQUIRE(classify(9999, "42S22") == ErrorClass::PERMANENT);
+    REQUIRE(simple_mariadb::retry::to_string(ErrorClass::TRANSIENT) == "transient");
+    REQUIRE(simple_mariadb::retry::to_string(ErrorClass::PERMANENT) == "permanent");
+}
+
+TEST_CASE("Exponential backoff", "[retry]") {
+    Policy policy{5, 100ms, 1000ms};
+    REQUIRE(policy.backoff(2) == 100ms);
+    REQUIRE(policy.backoff(3) == 200ms);
+    REQUIRE(policy.backoff(4) == 400ms);
+    REQUIRE(policy.backoff(5) == 800ms);
+    REQUIRE(policy.backoff(6) == 1000ms);
+    REQUIRE(policy.backoff(1000) == 1000ms);
+}
+
+TEST_CASE("Timer wheel", "[retry]") {
+    const auto start = std::chrono::steady_clock::now();
+    TimerWheel<int> wheel(10ms, 8, start);
+    std::vector<int> due;
+
+    SECTION("Entries come out at their deadline") {
+        wheel.schedule(1, start + 25ms);
+        wheel.schedule(2, start + 5ms);
+        wheel.schedule(3, start + 1000ms); // several turns ahead, it shares a bucket with earlier ticks
+        REQUIRE(wheel.size() == 3);
+        REQUIRE(wheel.next_deadline() == start + 10ms);
+        wheel.advance(start + 9ms, due);
+        REQUIRE(due.empty());
+        wheel.advance(start + 10ms, due);
+        REQUIRE(due == std::vector<int>{2});
+        wheel.advance(start + 30ms, due);
+        REQUIRE(due == std::vector<int>{2, 1});
+        wheel.advance(start + 990ms, due);
+        REQUIRE(due.size() == 2);
+        REQUIRE(wheel.next_deadline() == start + 1000ms);
+        wheel.advance(start + 1000ms, due);
+        REQUIRE(due == std::vector<int>{2, 1, 3});
+        REQUIRE(wheel.size() == 0);
+        REQUIRE(wheel.next_deadline() == std::chrono::steady_clock::time_point::max());
+    }
+
+    SECTION("Past deadlines are due at the next tick") {
+        wheel.advance(start + 50ms, due);
+        wheel.schedule(1, start);
+        wheel.advance(start + 59ms, due);
+        REQUIRE(due.empty());
+        wheel.advance(start + 60ms, due);
+        REQUIRE(due == std::vector<int>{1});
+    }
+
+    SECTION("Drain takes everything") {
+        for (int i = 0; i < 100; ++i) {
+            wheel.schedule(i, start + std::chrono::milliseconds(i * 7));
+        }
+        wheel.drain(due);
+        REQUIRE(due.size() == 100);
+        REQUIRE(wheel.size() == 0);
+    }
+}
+
+TEST_CASE("Retrier schedules transient failures", "[retry]") {
+    Retrier retrier(Policy{3, 10ms, 20ms}, "");
+    std::vector<DeadLetter> letters;
+    retrier.set_callback([&letters](const DeadLetter &letter) { letters.push_back(letter); });
+
+    REQUIRE(retrier.fail("INSERT INTO t VALUES (1);", 1, Failure{2006, "HY000", "gone away"}));
+    REQUIRE(retrier.pending() == 1);
+
+    std::vector<Pending> due;
+    const auto deadline = std::chrono::steady_clock::now() + 2s;
+    while (due.empty() && std::chrono::steady_clock::now() < deadline) {
+        retrier.wait(100ms, due);
+    }
+    REQUIRE(due.size() == 1);
+    REQUIRE(due.front().statement == "INSERT INTO t VALUES (1);");
+    REQUIRE(due.front().attempts == 1);
+    REQUIRE(due.front().failure.error_code == 2006);
+
+    // Out of attempts
+    REQUIRE(retrier.fail(due.front().statement, 2, due.front().failure));
+    REQUIRE_FALSE(retrier.fail(due.front().statement, 3, due.front().failure));
+    retrier.recovered();
+    retrier.flush();
+    REQUIRE(letters.size() == 1);
+    REQUIRE(letters.front().reason == "exhausted");
+    REQUIRE(letters.front().attempts == 3);
+
+    auto stats = retrier.get_stats();
+    REQUIRE(stats.transient == 3);
+    REQUIRE(stats.permanent == 0);
+    REQUIRE(stats.scheduled == 2);
+    REQUIRE(stats.retried == 1);
+    REQUIRE(stats.recovered == 1);
+    REQUIRE(stats.pending == 1);
+    REQUIRE(stats.dead_lettered == 1);
+
+    due.clear();
+    retrier.take_all(due);
+    REQUIRE(due.size() == 1);
+    REQUIRE(retrier.pending() == 0);
+}
+
+TEST_CASE("Retrier writes dead letters", "[retry]") {
+    const std::string path = "/tmp/simple_mariadb_test_dead_letters.jsonl";
+    std::remove(path.c_str());
+    {
+        Retrier retrier(Policy{}, path);
+        size_t called = 0;
+        retrier.set_callback([&called](const DeadLetter &) {
+            if (++called == 2) {
+                throw std::runtime_error("sink down");
+            }
+        });
+        REQUIRE_FALSE(retrier.fail("INSERT INTO t (missing) VALUES (1);", 1, Failure{1054, "42S22", "Unknown column"}));
+        REQUIRE_FALSE(retrier.fail("INSERT INTO t VALUES (2);", 1, Failure{2013, "HY000", "lost"}, false));
+        std::vector<Pending> due;
+        retrier.stop();
+        retrier.wait(1s, due); // the letters wake it up and go to the sinks
+        REQUIRE(due.empty());
+        REQUIRE(called == 2);
+        auto stats = retrier.get_stats();
+        REQUIRE(stats.permanent == 1);
+        REQUIRE(stats.transient == 1);
+        REQUIRE(stats.dead_lettered == 2);
+        REQUIRE(stats.sink_errors == 1);
+        // Stopped: transient failures are not scheduled anymore
+        REQUIRE_FALSE(retrier.fail("INSERT INTO t VALUES (3);", 1, Failure{2013, "HY000", "lost"}));
+        retrier.flush();
+    }
+    std::ifstream file(path);
+    std::vector<nlohmann::json> lines;
+    std::string line;
+    while (std::getline(file, line)) {
+        lines.push_back(nlohmann::json::parse(line));
+    }
+    REQUIRE(lines.size() == 3);
+    REQUIRE(lines[0]["reason"] == "permanent");
+    REQUIRE(lines[0]["error_code"] == 1054);
+    REQUIRE(lines[0]["sql_state"] == "42S22");
+    REQUIRE(lines[0]["statement"] == "INSERT INTO t (missing) VALUES (1);");
+    REQUIRE(lines[1]["reason"] == "stopped");
+    REQUIRE(lines[2]["reason"] == "stopped");
+    REQUIRE(lines[2]["attempts"] == 1);
+    std::remove(path.c_str());
+
+    REQUIRE_THROWS_AS(Retrier(Policy{}, "/nonexistent_dir/dead_letters.jsonl"), std::runtime_error);
+}
+
+TEST_CASE("Retrier under concurrent failures", "[retry]") {
+    const size_t threads = 4;
+    const size_t size = 1000;
+    Retrier retrier(Policy{2, 1ms, 1ms}, "");
+    std::atomic<size_t> letters = 0;
+    retrier.set_callback([&letters](const DeadLetter &) { letters++; });
+
+    std::vector<std::thread> producers;
+    for (size_t t = 0; t < threads; ++t) {
+        producers.emplace_back([&retrier, t] {
+            for (size_t i = 0; i < size; ++i) {
+                retrier.fail("INSERT INTO t VALUES (" + std::to_string(t * size + i) + ");", 1,
+                             Failure{i % 2 ? 1213 : 1064, "", "error"});
+            }
+        });
+    }
+    // The consumer fails every retry once more, which exhausts it
+    std::vector<Pending> due;
+    size_t retried = 0;
+    const auto deadline = std::chrono::steady_clock::now() + 10s;
+    while (retried < threads * size / 2 && std::chrono::steady_clock::now() < deadline) {
+        due.clear();
+        retrier.wait(10ms, due);
+        for (auto &pending: due) {
+            REQUIRE_FALSE(retrier.fail(std::move(pending.statement), pending.attempts + 1, pending.failure));
+        }
+        retried += due.size();
+    }
+    for (auto &producer: producers) {
+        producer.join();
+    }
+    retrier.flush();
+    REQUIRE(retried == threads * size / 2);
+    REQUIRE(letters == threads * size);
+    auto stats = retrier.get_stats();
+    REQUIRE(stats.dead_lettered == threads * size);
+    REQUIRE(stats.pending == 0);
+}
+
+TEST_CASE("Retrier postpones and falls back", "[retry]") {
+    Retrier retrier(Policy{2, 1ms, 1ms}, "");
+    std::vector<std::string> kept;
+    std::vector<DeadLetter> letters;
+    retrier.set_fallback([&kept](const std::string &statement) {
+        if (statement.find("keep") == std::string::npos) {
+            return false;
+        }
+        kept.push_back(statement);
+        return true;
+    });
+    retrier.set_callback([&letters](const DeadLetter &letter) { letters.push_back(letter); });
+
+    REQUIRE(retrier.fail("INSERT INTO t VALUES ('keep');", 1, Failure{2006, "", "gone away"}));
+    std::vector<Pending> due;
+    const auto deadline = std::chrono::steady_clock::now() + 2s;
+    while (due.empty() && std::chrono::steady_clock::now() < deadline) {
+        retrier.wait(100ms, due);
+    }
+    REQUIRE(due.size() == 1);
+
+    // Out of reach of the server: put back without using an attempt, as many times as needed
+    for (int i = 0; i < 3; ++i) {
+        retrier.postpone(due, 1ms);
+        REQUIRE(due.empty());
+        while (due.empty() && std::chrono::steady_clock::now() < deadline) {
+            retrier.wait(100ms, due);
+        }
+        REQUIRE(due.size() == 1);
+        REQUIRE(due.front().attempts == 1);
+    }
+
+    // Exhausted transient failures and stopped ones go to the fallback, permanent ones never do
+    REQUIRE_FALSE(retrier.fail(due.front().statement, 2, due.front().failure));
+    REQUIRE_FALSE(retrier.fail("INSERT INTO t VALUES ('keep', 'bad');", 1, Failure{1064, "42000", "syntax"}));
+    std::vector<Pending> stopped = {{"INSERT INTO t VALUES ('drop');", 1, Failure{2013, "", "lost"}}};
+    retrier.give_up(stopped);
+    REQUIRE(stopped.empty());
+    retrier.flush();
+
+    REQUIRE(kept == std::vector<std::string>{"INSERT INTO t VALUES ('keep');"});
+    REQUIRE(letters.size() == 2);
+    REQUIRE(letters[0].reason == "permanent");
+    REQUIRE(letters[1].reason == "stopped");
+    REQUIRE(letters[1].failure.error_code == 2013);
+    auto stats = retrier.get_stats();
+    REQUIRE(stats.postponed == 3);
+    REQUIRE(stats.retried == 4);
+    REQUIRE(stats.fallen_back == 1);
+    REQUIRE(stats.dead_lettered == 2);
+    REQUIRE(stats.pending == 0);
+}
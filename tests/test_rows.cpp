@@ -0,0 +1,117 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+#include <simple_mariadb/rows.h>
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ---------------------------------------------------------------------------------------------------
+using simple_mariadb::rows::Value;
+using simple_mariadb::rows::RowBuffer;
+using simple_mariadb::rows::RowBatch;
+using simple_mariadb::rows::to_value;
+using simple_mariadb::rows::insert_statement;
+
+TEST_CASE("Convert values", "[rows]") {
+    REQUIRE(std::get<int64_t>(to_value(42)) == 42);
+    REQUIRE(std::get<int64_t>(to_value(static_cast<short>(-3))) == -3);
+    REQUIRE(std::get<uint64_t>(to_value(7u)) == 7);
+    REQUIRE(std::get<double>(to_value(1.5f)) == 1.5);
+    REQUIRE(std::get<bool>(to_value(true)));
+    REQUIRE(std::get<std::string>(to_value("it's")) == "it's");
+    REQUIRE(std::get<std::string>(to_value(std::string_view("view"))) == "view");
+    REQUIRE(std::holds_alternative<std::nullptr_t>(to_value(nullptr)));
+    REQUIRE(std::holds_alternative<std::nullptr_t>(to_value(std::optional<int>())));
+    REQUIRE(std::get<int64_t>(to_value(std::optional<int>(5))) == 5);
+}
+
+TEST_CASE("Build insert statement", "[rows]") {
+    REQUIRE(insert_statement("OHLC", {"ticker", "open", "close"}) ==
+            "INSERT INTO `OHLC` (`ticker`,`open`,`close`) VALUES (?,?,?)");
+}
+
+TEST_CASE("Render a row as a text statement", "[rows]") {
+    REQUIRE(simple_mariadb::rows::to_literal(Value(nullptr)) == "NULL");
+    REQUIRE(simple_mariadb::rows::to_literal(Value(true)) == "1");
+    REQUIRE(simple_mariadb::rows::to_literal(Value(int64_t(-7))) == "-7");
+    REQUIRE(simple_mariadb::rows::to_literal(Value(0.1)) == "0.1");
+    REQUIRE(simple_mariadb::rows::to_literal(Value(std::string("it's \\ a\ntest"))) == R"('it\'s \\ a\ntest')");
+
+    RowBatch batch;
+    batch.sql = insert_statement("t?", {"a", "b"});
+    batch.columns = 2;
+    batch.values = {Value(int64_t(1)), Value(std::string("x")), Value(nullptr), Value(2.5)};
+    REQUIRE(simple_mariadb::rows::row_statement(batch, 0) == "INSERT INTO `t?` (`a`,`b`) VALUES (1,'x')");
+    REQUIRE(simple_mariadb::rows::row_statement(batch, 1) == "INSERT INTO `t?` (`a`,`b`) VALUES (NULL,2.5)");
+}
+
+TEST_CASE("Buffer rows per table", "[rows]") {
+    std::atomic<bool> running = true;
+
+    SECTION("Rows are grouped per table and column list") {
+        RowBuffer buffer(100, 0);
+        REQUIRE(buffer.add("a", {"x", "y"}, {to_value(1), to_value("one")}));
+        REQUIRE(buffer.add("b", {"x"}, {to_value(2)}));
+        REQUIRE(buffer.add("a", {"x", "y"}, {to_value(3), to_value("three")}));
+        REQUIRE_FALSE(buffer.add("a", {"x", "y"}, {to_value(4)}));
+        REQUIRE(buffer.pending_rows() == 3);
+
+        auto batches = buffer.take_all();
+        REQUIRE(batches.size() == 2);
+        REQUIRE(batches[0].sql == "INSERT INTO `a` (`x`,`y`) VALUES (?,?)");
+        REQUIRE(batches[0].rows() == 2);
+        REQUIRE(std::get<std::string>(batches[0].values[3]) == "three");
+        REQUIRE(batches[1].rows() == 1);
+        REQUIRE(buffer.pending_rows() == 3);
+        buffer.done(3);
+        REQUIRE(buffer.pending_rows() == 0);
+    }
+
+    SECTION("Batches are capped at max rows") {
+        RowBuffer buffer(4, 0);
+        for (int i = 0; i < 10; ++i) {
+            REQUIRE(buffer.add("a", {"x"}, {to_value(i)}));
+        }
+        auto batches = buffer.wait_batches(std::chrono::milliseconds(1000), running);
+        REQUIRE(batches.size() == 3);
+        REQUIRE(batches[0].rows() == 4);
+        REQUIRE(batches[1].rows() == 4);
+        REQUIRE(batches[2].rows() == 2);
+        REQUIRE(std::get<int64_t>(batches[2].values[1]) == 9);
+    }
+
+    SECTION("Pending limit rejects rows") {
+        RowBuffer buffer(10, 2);
+        REQUIRE(buffer.add("a", {"x"}, {to_value(1)}));
+        REQUIRE(buffer.add("a", {"x"}, {to_value(2)}));
+        REQUIRE_FALSE(buffer.add("a", {"x"}, {to_value(3)}));
+    }
+
+    SECTION("Linger waits for more rows") {
+        RowBuffer buffer(100, 0);
+        REQUIRE(buffer.add("a", {"x"}, {to_value(1)}));
+        std::thread producer([&buffer]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            buffer.add("a", {"x"}, {to_value(2)});
+        });
+        auto batches = buffer.wait_batches(std::chrono::milliseconds(200), running);
+        producer.join();
+        REQUIRE(batches.size() == 1);
+        REQUIRE(batches[0].rows() == 2);
+    }
+
+    SECTION("Stopping wakes the waiter") {
+        RowBuffer buffer(100, 0);
+        std::thread stopper([&buffer, &running]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            running = false;
+            buffer.notify();
+        });
+        auto batches = buffer.wait_batches(std::chrono::milliseconds(0), running);
+        stopper.join();
+        REQUIRE(batches.empty());
+    }
+}
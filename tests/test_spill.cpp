@@ -0,0 +1,157 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+#include <simple_mariadb/spill.h>
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+// ---------------------------------------------------------------------------------------------------
+using simple_mariadb::spill::SegmentLog;
+
+namespace {
+    struct TempDirectory {
+        TempDirectory() {
+            std::random_device rd;
+            path = std::filesystem::temp_directory_path() / ("simple_mariadb_spill_" + std::to_string(rd()));
+        }
+
+        ~TempDirectory() {
+            std::filesystem::remove_all(path);
+        }
+
+        size_t segment_files() const {
+            size_t count = 0;
+            for (const auto &entry: std::filesystem::directory_iterator(path)) {
+                count += entry.path().extension() == ".log" ? 1 : 0;
+            }
+            return count;
+        }
+
+        std::filesystem::path path;
+    };
+}
+
+TEST_CASE("CRC-32", "[spill]") {
+    REQUIRE(simple_mariadb::spill::crc32("") == 0);
+    REQUIRE(simple_mariadb::spill::crc32("123456789") == 0xCBF43926u);
+}
+
+TEST_CASE("Append, peek and commit", "[spill]") {
+    TempDirectory directory;
+    SegmentLog log(directory.path.string(), 4096, 0);
+    REQUIRE(log.pending() == 0);
+
+    REQUIRE(log.append("INSERT INTO t VALUES (1);"));
+    REQUIRE(log.append("INSERT INTO t VALUES (2);"));
+    REQUIRE(log.append(""));
+    REQUIRE(log.pending() == 3);
+
+    std::vector<std::string> records;
+    REQUIRE(log.peek(2, records) == 2);
+    REQUIRE(records == std::vector<std::string>{"INSERT INTO t VALUES (1);", "INSERT INTO t VALUES (2);"});
+
+    log.commit(1);
+    records.clear();
+    REQUIRE(log.peek(10, records) == 2);
+    REQUIRE(records.front() == "INSERT INTO t VALUES (2);");
+    REQUIRE(records.back().empty());
+
+    auto stats = log.get_stats();
+    REQUIRE(stats.appended == 3);
+    REQUIRE(stats.committed == 1);
+    REQUIRE(stats.pending == 2);
+    REQUIRE(stats.segments == 1);
+}
+
+TEST_CASE("Roll and delete segments", "[spill]") {
+    TempDirectory directory;
+    SegmentLog log(directory.path.string(), 1024, 0);
+    const std::string record(100, 'x');
+    for (int i = 0; i < 30; ++i) {
+        REQUIRE(log.append(record + std::to_string(i)));
+    }
+    REQUIRE(directory.segment_files() > 2);
+    REQUIRE_FALSE(log.append(std::string(2048, 'y'))); // larger than a segment
+
+    std::vector<std::string> records;
+    REQUIRE(log.peek(100, records) == 30);
+    for (int i = 0; i < 30; ++i) {
+        REQUIRE(records[i] == record + std::to_string(i));
+    }
+    log.commit(30);
+    REQUIRE(log.pending() == 0);
+    REQUIRE(directory.segment_files() == 1);
+    REQUIRE(log.get_stats().rejected == 1);
+}
+
+TEST_CASE("Limit the bytes on disk", "[spill]") {
+    TempDirectory directory;
+    SegmentLog log(directory.path.string(), 1024, 2048);
+    const std::string record(200, 'x');
+    size_t appended = 0;
+    while (log.append(record)) {
+        appended++;
+    }
+    REQUIRE(appended > 0);
+    REQUIRE(directory.segment_files() == 2);
+    log.commit(appended);
+    REQUIRE(log.append(record)); // committed segments make room again
+}
+
+TEST_CASE("Recover after restart", "[spill]") {
+    TempDirectory directory;
+    {
+        SegmentLog log(directory.path.string(), 1024, 0);
+        for (int i = 0; i < 20; ++i) {
+            REQUIRE(log.append("row " + std::to_string(i)));
+        }
+        log.commit(5);
+    }
+    {
+        SegmentLog log(directory.path.string(), 1024, 0);
+        REQUIRE(log.get_stats().recovered == 15);
+        std::vector<std::string> records;
+        REQUIRE(log.peek(100, records) == 15);
+        REQUIRE(records.front() == "row 5");
+        REQUIRE(records.back() == "row 19");
+        REQUIRE(log.append("row 20"));
+        log.commit(10);
+    }
+    SegmentLog log(directory.path.string(), 1024, 0);
+    std::vector<std::string> records;
+    REQUIRE(log.peek(100, records) == 6);
+    REQUIRE(records.front() == "row 15");
+    REQUIRE(records.back() == "row 20");
+}
+
+TEST_CASE("Ignore a torn record", "[spill]") {
+    TempDirectory directory;
+    {
+        SegmentLog log(directory.path.string(), 1024, 0);
+        REQUIRE(log.append("complete"));
+        REQUIRE(log.append("torn"));
+    }
+    std::filesystem::path segment;
+    for (const auto &entry: std::filesystem::directory_iterator(directory.path)) {
+        segment = entry.path();
+    }
+    {
+        // Damage the payload of the second record, as a crash in the middle of the write would
+        std::fstream file(segment, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(16 + 16 + 8); // segment header, first record, second record header
+        file.put('X');
+    }
+    SegmentLog log(directory.path.string(), 1024, 0);
+    std::vector<std::string> records;
+    REQUIRE(log.peek(10, records) == 1);
+    REQUIRE(records.front() == "complete");
+    REQUIRE(log.append("next"));
+    records.clear();
+    REQUIRE(log.peek(10, records) == 2);
+    REQUIRE(records.back() == "next");
+}
@@ -0,0 +1,64 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+#include <simple_mariadb/table.h>
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+#include <vector>
+
+// ---------------------------------------------------------------------------------------------------
+using simple_mariadb::table::ResultTable;
+
+TEST_CASE("Store rows in a result table", "[table]") {
+    ResultTable table({"ticker", "price", "note"});
+    REQUIRE(table.empty());
+    REQUIRE(table.column_count() == 3);
+
+    table.append("AAPL");
+    table.append("181.5");
+    table.append_null();
+    table.append("MSFT");
+    table.append("402.1");
+    table.append("split");
+
+    REQUIRE(table.rows() == 2);
+    REQUIRE(table.at(0, 0) == "AAPL");
+    REQUIRE(table.at(1, "price") == "402.1");
+    REQUIRE(table.at(0, "note").empty());
+    REQUIRE(table.is_null(0, 2));
+    REQUIRE_FALSE(table.is_null(1, 2));
+    REQUIRE(table[1]["note"] == "split");
+    REQUIRE(table.arena_bytes() == std::string("AAPL181.5MSFT402.1split").size());
+    REQUIRE(table.column_index("price") == 1);
+    REQUIRE_THROWS_AS(table.column_index("missing"), std::out_of_range);
+
+    std::vector<std::string> tickers;
+    for (auto row: table) {
+        REQUIRE(row.size() == 3);
+        tickers.emplace_back(row["ticker"]);
+    }
+    REQUIRE(tickers == std::vector<std::string>{"AAPL", "MSFT"});
+
+    SECTION("Copies share the header") {
+        ResultTable copy = table;
+        REQUIRE(&copy.header() == &table.header());
+        REQUIRE(copy.at(1, 0) == "MSFT");
+    }
+
+    SECTION("Reset keeps the table usable") {
+        table.reset({"id"});
+        REQUIRE(table.rows() == 0);
+        REQUIRE(table.arena_bytes() == 0);
+        table.append("7");
+        REQUIRE(table.rows() == 1);
+        REQUIRE(table[0][0] == "7");
+        REQUIRE(table.header() == std::vector<std::string>{"id"});
+    }
+
+    SECTION("No columns") {
+        ResultTable none;
+        REQUIRE(none.rows() == 0);
+        REQUIRE(none.begin() == none.end());
+    }
+}
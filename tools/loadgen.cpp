@@ -0,0 +1,242 @@
+//
+// Created by Joaquin Bejar Garcia on 17/10/26.
+//
+
+// Load generator: replays an ingest and read mix against a MariaDB server through the public API of
+// MariaDBManager, the way applications use it, and prints a JSON report on stdout.
+//
+// The connection comes from the usual MARIADB_* environment variables (MariaDBConfig). The workload is read
+// from the JSON file given as first argument, missing fields keep their defaults:
+//
+//   {"write_ratio": 0.9, "row_width": 256, "producers": 4, "rate": 20000, "multi_insert": true,
+//    "duration_s": 30, "table": "loadgen", "report_interval_ms": 1000, "drop_table": true}
+//
+// rate is the target of operations per second over all producers, 0 runs them as fast as possible.
+
+#include <simple_mariadb/client.h>
+#include <simple_mariadb/metrics.h>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    struct WorkloadSpec {
+        double write_ratio = 0.9;       ///< Share of writes, the rest are reads.
+        size_t row_width = 256;         ///< Bytes of payload per written row.
+        size_t producers = 4;           ///< Threads issuing operations.
+        size_t rate = 0;                ///< Target operations per second over all producers, 0 is unbounded.
+        bool multi_insert = true;
+        size_t duration_s = 30;
+        std::string table = "loadgen";
+        size_t report_interval_ms = 1000; ///< Period of the queue depth samples.
+        bool drop_table = true;           ///< Drop the table once the report is written.
+
+        void from_json(const nlohmann::json &j) {
+            write_ratio = j.value("write_ratio", write_ratio);
+            row_width = j.value("row_width", row_width);
+            producers = j.value("producers", producers);
+            rate = j.value("rate", rate);
+            multi_insert = j.value("multi_insert", multi_insert);
+            duration_s = j.value("duration_s", duration_s);
+            table = j.value("table", table);
+            report_interval_ms = j.value("report_interval_ms", report_interval_ms);
+            drop_table = j.value("drop_table", drop_table);
+        }
+
+        [[nodiscard]] nlohmann::json to_json() const {
+            nlohmann::json j;
+            j["write_ratio"] = write_ratio;
+            j["row_width"] = row_width;
+            j["producers"] = producers;
+            j["rate"] = rate;
+            j["multi_insert"] = multi_insert;
+            j["duration_s"] = duration_s;
+            j["table"] = table;
+            j["report_interval_ms"] = report_interval_ms;
+            j["drop_table"] = drop_table;
+            return j;
+        }
+
+        [[nodiscard]] bool validate(std::string &error) const {
+            if (write_ratio < 0 || write_ratio > 1) {
+                error = "write_ratio must be between 0 and 1";
+            } else if (producers == 0) {
+                error = "producers must be at least 1";
+            } else if (duration_s == 0) {
+                error = "duration_s must be at least 1";
+            } else if (report_interval_ms == 0) {
+                error = "report_interval_ms must be at least 1";
+            } else if (table.empty()) {
+                error = "table must not be empty";
+            } else {
+                return true;
+            }
+            return false;
+        }
+    };
+
+    struct Counters {
+        std::atomic<size_t> writes = 0;
+        std::atomic<size_t> write_errors = 0; ///< Statements enqueue() refused.
+        std::atomic<size_t> reads = 0;
+        std::atomic<size_t> read_errors = 0;
+        simple_mariadb::metrics::Histogram enqueue_latency;
+        simple_mariadb::metrics::Histogram read_latency;
+    };
+
+    std::map<std::string, std::string> table_columns(const WorkloadSpec &spec) {
+        std::map<std::string, std::string> columns;
+        columns["id"] = "BIGINT NOT NULL AUTO_INCREMENT PRIMARY KEY";
+        columns["producer"] = "INT NOT NULL";
+        columns["seq"] = "BIGINT NOT NULL";
+        columns["payload"] = spec.row_width > 4096 ? "MEDIUMTEXT NULL"
+                                                   : "VARCHAR(" + std::to_string(std::max<size_t>(spec.row_width, 1)) +
+                                                     ") NULL";
+        return columns;
+    }
+
+    void run_producer(simple_mariadb::client::MariaDBManager &manager, const WorkloadSpec &spec, size_t producer,
+                      std::chrono::steady_clock::time_point deadline, Counters &counters) {
+        std::mt19937_64 random(producer * 7919 + 17);
+        std::uniform_real_distribution<double> pick(0, 1);
+        const std::string payload(spec.row_width, static_cast<char>('a' + producer % 26));
+        const std::string insert_prefix = "INSERT INTO `" + spec.table + "` (`producer`, `seq`, `payload`) VALUES (" +
+                                          std::to_string(producer) + ", ";
+        const std::string read_query = "SELECT `id`, `producer`, `seq` FROM `" + spec.table +
+                                       "` WHERE `producer` = " + std::to_string(producer) +
+                                       " ORDER BY `id` DESC LIMIT 10";
+        // Producers share the target rate, each one paces itself on its own schedule
+        const auto interval = spec.rate == 0 ? std::chrono::nanoseconds(0) :
+                              std::chrono::nanoseconds(1000000000ULL * spec.producers / spec.rate);
+        auto next = std::chrono::steady_clock::now();
+        std::string query;
+        for (size_t seq = 0; std::chrono::steady_clock::now() < deadline; ++seq) {
+            if (interval.count() > 0) {
+                next += interval;
+                std::this_thread::sleep_until(next);
+            }
+            const auto start = std::chrono::steady_clock::now();
+            if (pick(random) < spec.write_ratio) {
+                query.clear();
+                query.append(insert_prefix).append(std::to_string(seq)).append(", '").append(payload).append("');");
+                if (manager.enqueue(query)) {
+                    counters.enqueue_latency.record_since(start);
+                    counters.writes++;
+                } else {
+                    counters.write_errors++;
+                }
+            } else {
+                try {
+                    manager.select(read_query);
+                    counters.read_latency.record_since(start);
+                    counters.reads++;
+                } catch (std::exception &) {
+                    counters.read_errors++;
+                }
+            }
+        }
+    }
+
+}
+
+int main(int argc, char **argv) {
+    WorkloadSpec spec;
+    if (argc > 1) {
+        std::ifstream file(argv[1]);
+        if (!file) {
+            std::cerr << "simple_mariadb_loadgen: cannot open " << argv[1] << std::endl;
+            return 2;
+        }
+        try {
+            spec.from_json(nlohmann::json::parse(file));
+        } catch (std::exception &e) {
+            std::cerr << "simple_mariadb_loadgen: invalid workload spec: " << e.what() << std::endl;
+            return 2;
+        }
+    }
+    std::string error;
+    if (!spec.validate(error)) {
+        std::cerr << "simple_mariadb_loadgen: " << error << std::endl;
+        return 2;
+    }
+
+    simple_mariadb::config::MariaDBConfig config;
+    std::unique_ptr<simple_mariadb::client::MariaDBManager> manager;
+    try {
+        manager = std::make_unique<simple_mariadb::client::MariaDBManager>(config);
+    } catch (std::exception &e) {
+        std::cerr << "simple_mariadb_loadgen: " << e.what() << std::endl;
+        return 1;
+    }
+    manager->set_multi_insert(spec.multi_insert);
+    if (!manager->create_table(spec.table, table_columns(spec))) {
+        std::cerr << "simple_mariadb_loadgen: cannot create table " << spec.table << std::endl;
+        return 1;
+    }
+
+    Counters counters;
+    nlohmann::json samples = nlohmann::json::array();
+    const auto start = std::chrono::steady_clock::now();
+    const auto deadline = start + std::chrono::seconds(spec.duration_s);
+    std::vector<std::thread> producers;
+    producers.reserve(spec.producers);
+    for (size_t i = 0; i < spec.producers; ++i) {
+        producers.emplace_back(run_producer, std::ref(*manager), std::cref(spec), i, deadline, std::ref(counters));
+    }
+
+    // Queue depth and progress over time, from the non-blocking stats
+    auto next_sample = start;
+    while (std::chrono::steady_clock::now() < deadline) {
+        next_sample += std::chrono::milliseconds(spec.report_interval_ms);
+        std::this_thread::sleep_until(std::min(next_sample, deadline));
+        const auto operations = manager->get_operation_stats();
+        nlohmann::json sample;
+        sample["t_ms"] = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start).count();
+        sample["queue_depth"] = manager->queue_size();
+        sample["enqueued"] = counters.writes.load();
+        sample["written"] = operations.rows.total;
+        sample["written_per_second"] = operations.rows.per_second;
+        sample["reads"] = counters.reads.load();
+        samples.push_back(std::move(sample));
+    }
+    for (auto &producer: producers) {
+        producer.join();
+    }
+    const double offered_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    manager->stop(); // drains the queue, so every accepted write is counted below
+    const double drained_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const auto stats = manager->get_stats();
+    nlohmann::json report;
+    report["spec"] = spec.to_json();
+    report["elapsed_s"] = offered_s;
+    report["drained_s"] = drained_s;
+    report["writes"]["enqueued"] = counters.writes.load();
+    report["writes"]["rejected"] = counters.write_errors.load();
+    report["writes"]["written"] = stats.operations.rows.total;
+    report["writes"]["enqueued_per_second"] = static_cast<double>(counters.writes.load()) / offered_s;
+    report["writes"]["written_per_second"] = static_cast<double>(stats.operations.rows.total) / drained_s;
+    report["writes"]["enqueue_latency_ns"] = counters.enqueue_latency.snapshot().to_json();
+    report["reads"]["completed"] = counters.reads.load();
+    report["reads"]["failed"] = counters.read_errors.load();
+    report["reads"]["per_second"] = static_cast<double>(counters.reads.load()) / offered_s;
+    report["reads"]["latency_ns"] = counters.read_latency.snapshot().to_json();
+    report["operations"] = stats.operations.to_json();
+    report["read_pool"] = stats.read_pool.to_json();
+    report["queue"] = stats.queue.to_json();
+    report["errors"] = manager->get_error_counter();
+    report["samples"] = std::move(samples);
+
+    if (spec.drop_table) {
+        manager->drop_table(spec.table);
+    }
+    std::cout << report.dump(2) << std::endl;
+    return 0;
+}